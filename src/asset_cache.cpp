@@ -0,0 +1,154 @@
+#include "asset_cache.hpp"
+#include "file_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+const char CACHE_MAGIC[4] = {'S', 'G', 'A', 'C'};
+const sf::Uint32 CACHE_VERSION = 1;
+
+struct CacheHeader {
+    char magic[4];
+    sf::Uint32 version;
+    sf::Int64 sourceModifiedTime;
+    sf::Int64 sourceSize;
+    sf::Uint32 width;
+    sf::Uint32 height;
+};
+}
+
+AssetCache::AssetCache(const std::string& directory)
+    : directory(directory)
+{
+    available = ensureDirectory(directory);
+}
+
+bool AssetCache::loadImage(const std::string& sourcePath, const sf::Vector2u& size, sf::Image& image) {
+    FileStamp stamp;
+    if (!getFileStamp(sourcePath, stamp)) return false;
+
+    std::string cachePath = getCachePath(sourcePath, size);
+    if (available && readCacheFile(cachePath, stamp.modifiedTime, stamp.size, image)) {
+        return true;
+    }
+
+    sf::Image decoded;
+    if (!decoded.loadFromFile(sourcePath)) return false;
+    image = downscaleToCover(decoded, size);
+    if (available) {
+        writeCacheFile(cachePath, stamp.modifiedTime, stamp.size, image);
+    }
+    return true;
+}
+
+void AssetCache::warm(const std::string& sourcePath, const std::vector<sf::Vector2u>& sizes) {
+    FileStamp stamp;
+    if (!available || !getFileStamp(sourcePath, stamp)) return;
+
+    sf::Image decoded;
+    bool isDecoded = false;
+    for (const auto& size : sizes) {
+        std::string cachePath = getCachePath(sourcePath, size);
+        sf::Image cached;
+        if (readCacheFile(cachePath, stamp.modifiedTime, stamp.size, cached)) continue;
+
+        if (!isDecoded) {
+            if (!decoded.loadFromFile(sourcePath)) return;
+            isDecoded = true;
+        }
+        writeCacheFile(cachePath, stamp.modifiedTime, stamp.size, downscaleToCover(decoded, size));
+    }
+}
+
+std::string AssetCache::getCachePath(const std::string& sourcePath, const sf::Vector2u& size) const {
+    return directory + "/" + toHexString(hashBytes(sourcePath.data(), sourcePath.size())) +
+           "_" + std::to_string(size.x) + "x" + std::to_string(size.y) + ".rgba";
+}
+
+bool AssetCache::readCacheFile(const std::string& cachePath, long long modifiedTime, long long fileSize, sf::Image& image) const {
+    std::ifstream ifs(cachePath, std::ios::binary);
+    if (!ifs.is_open()) return false;
+
+    CacheHeader header;
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.sourceModifiedTime != modifiedTime ||
+        header.sourceSize != fileSize ||
+        header.width == 0 || header.height == 0) {
+        return false;
+    }
+
+    std::vector<sf::Uint8> pixels(static_cast<size_t>(header.width) * header.height * 4);
+    if (!ifs.read(reinterpret_cast<char*>(pixels.data()), pixels.size())) return false;
+    image.create(header.width, header.height, pixels.data());
+    return true;
+}
+
+void AssetCache::writeCacheFile(const std::string& cachePath, long long modifiedTime, long long fileSize, const sf::Image& image) const {
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.sourceModifiedTime = modifiedTime;
+    header.sourceSize = fileSize;
+    header.width = image.getSize().x;
+    header.height = image.getSize().y;
+
+    writeFileAtomically(cachePath, [&](std::ostream& os) {
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(image.getPixelsPtr()), static_cast<std::streamsize>(header.width) * header.height * 4);
+        return static_cast<bool>(os);
+    }, true);
+}
+
+sf::Image downscaleToCover(const sf::Image& source, const sf::Vector2u& target) {
+    sf::Vector2u sourceSize = source.getSize();
+    if (target.x == 0 || target.y == 0 || sourceSize.x == 0 || sourceSize.y == 0) return source;
+
+    // 縦横どちらかが target にぴったり合い、もう一方ははみ出す大きさ
+    float scale = std::max(static_cast<float>(target.x) / sourceSize.x,
+                           static_cast<float>(target.y) / sourceSize.y);
+    if (scale >= 1.f) return source;
+
+    unsigned int width = std::max(1u, static_cast<unsigned int>(sourceSize.x * scale + 0.5f));
+    unsigned int height = std::max(1u, static_cast<unsigned int>(sourceSize.y * scale + 0.5f));
+    const sf::Uint8* src = source.getPixelsPtr();
+
+    // 横方向: 各出力列が覆う入力列を平均する
+    std::vector<sf::Uint32> columns(static_cast<size_t>(width) * sourceSize.y * 4);
+    for (unsigned int x = 0; x < width; ++x) {
+        unsigned int x0 = static_cast<unsigned int>(static_cast<unsigned long long>(x) * sourceSize.x / width);
+        unsigned int x1 = std::max(x0 + 1, static_cast<unsigned int>(static_cast<unsigned long long>(x + 1) * sourceSize.x / width));
+        for (unsigned int y = 0; y < sourceSize.y; ++y) {
+            sf::Uint32 sum[4] = {0, 0, 0, 0};
+            const sf::Uint8* row = src + static_cast<size_t>(y) * sourceSize.x * 4;
+            for (unsigned int sx = x0; sx < x1; ++sx) {
+                for (int c = 0; c < 4; ++c) sum[c] += row[sx * 4 + c];
+            }
+            sf::Uint32* out = &columns[(static_cast<size_t>(y) * width + x) * 4];
+            for (int c = 0; c < 4; ++c) out[c] = sum[c] / (x1 - x0);
+        }
+    }
+
+    // 縦方向
+    std::vector<sf::Uint8> pixels(static_cast<size_t>(width) * height * 4);
+    for (unsigned int y = 0; y < height; ++y) {
+        unsigned int y0 = static_cast<unsigned int>(static_cast<unsigned long long>(y) * sourceSize.y / height);
+        unsigned int y1 = std::max(y0 + 1, static_cast<unsigned int>(static_cast<unsigned long long>(y + 1) * sourceSize.y / height));
+        for (unsigned int x = 0; x < width; ++x) {
+            sf::Uint32 sum[4] = {0, 0, 0, 0};
+            for (unsigned int sy = y0; sy < y1; ++sy) {
+                const sf::Uint32* in = &columns[(static_cast<size_t>(sy) * width + x) * 4];
+                for (int c = 0; c < 4; ++c) sum[c] += in[c];
+            }
+            for (int c = 0; c < 4; ++c) {
+                pixels[(static_cast<size_t>(y) * width + x) * 4 + c] = static_cast<sf::Uint8>(sum[c] / (y1 - y0));
+            }
+        }
+    }
+
+    sf::Image result;
+    result.create(width, height, pixels.data());
+    return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+// --- 画像アセットのディスクキャッシュ ---
+// 曲の背景などを表示サイズに縮小した状態で cache/art に保存しておく。
+// 中身は RGBA をそのまま並べただけなので、JPEG のデコードより読み込みが速い。
+// 元ファイルの更新日時とサイズをヘッダに記録し、変わっていれば作り直す。
+// 複数のワーカースレッドから同時に呼んでよい。
+class AssetCache {
+public:
+    explicit AssetCache(const std::string& directory = "cache/art");
+
+    // sourcePath を size を覆う大きさに縮小した画像を返す。キャッシュがなければ作って保存する
+    bool loadImage(const std::string& sourcePath, const sf::Vector2u& size, sf::Image& image);
+
+    // 元画像を1回だけデコードして、指定した全サイズのキャッシュを作っておく
+    void warm(const std::string& sourcePath, const std::vector<sf::Vector2u>& sizes);
+
+private:
+    std::string getCachePath(const std::string& sourcePath, const sf::Vector2u& size) const;
+    bool readCacheFile(const std::string& cachePath, long long modifiedTime, long long fileSize, sf::Image& image) const;
+    void writeCacheFile(const std::string& cachePath, long long modifiedTime, long long fileSize, const sf::Image& image) const;
+
+    std::string directory;
+    bool available; // ディレクトリが作れなかったときはキャッシュせずにデコードだけする
+};
+
+// 画像が target を覆う最小の大きさになるよう面積平均で縮小する (拡大はしない)
+sf::Image downscaleToCover(const sf::Image& source, const sf::Vector2u& target);
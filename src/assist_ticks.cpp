@@ -0,0 +1,77 @@
+#include "assist_ticks.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double PI = 3.14159265358979323846;
+const double SAME_NOTE_TIME = 0.001; // 和音は1回だけ鳴らす (秒)
+
+// 減衰する正弦波のクリック。頭は少しだけ立ち上げてプチノイズを避ける
+std::vector<float> makeClick(double frequency, double length, double decay, float amplitude) {
+    const size_t frameCount = static_cast<size_t>(length * MIXER_SAMPLE_RATE);
+    const size_t attackFrames = MIXER_SAMPLE_RATE / 1000;
+    std::vector<float> sound(frameCount);
+    for (size_t i = 0; i < frameCount; ++i) {
+        double t = static_cast<double>(i) / MIXER_SAMPLE_RATE;
+        double envelope = std::exp(-t / decay) * std::min(1.0, static_cast<double>(i) / attackFrames);
+        // 最後の 1/4 で0まで下げる
+        envelope *= std::min(1.0, 4.0 * (frameCount - i) / frameCount);
+        sound[i] = static_cast<float>(amplitude * envelope * std::sin(2.0 * PI * frequency * t));
+    }
+    return sound;
+}
+}
+
+AssistTickTrack::AssistTickTrack(const std::vector<ChartBeat>& beats, const std::vector<Note>& chart, AssistTickMode mode) {
+    sounds[DOWNBEAT] = makeClick(1760.0, 0.05, 0.012, 0.5f);
+    sounds[BEAT] = makeClick(1320.0, 0.05, 0.010, 0.35f);
+    sounds[NOTE] = makeClick(3520.0, 0.025, 0.005, 0.3f);
+    for (const auto& sound : sounds) longestSound = std::max(longestSound, sound.size());
+
+    if (mode == AssistTickMode::BEAT || mode == AssistTickMode::BOTH) {
+        for (const auto& beat : beats) ticks.push_back({beat.time, beat.downbeat ? DOWNBEAT : BEAT});
+    }
+    if (mode == AssistTickMode::NOTES || mode == AssistTickMode::BOTH) {
+        double lastTime = -1.0;
+        for (const auto& note : chart) {
+            if (note.spawnTime - lastTime < SAME_NOTE_TIME) continue;
+            ticks.push_back({note.spawnTime, NOTE});
+            lastTime = note.spawnTime;
+        }
+    }
+    std::stable_sort(ticks.begin(), ticks.end(), [](const Tick& a, const Tick& b) { return a.time < b.time; });
+}
+
+void AssistTickTrack::mix(float* frames, size_t frameCount, double startTime, float speed, float gain) const {
+    if (ticks.empty() || frameCount == 0) return;
+    const double framesPerSecond = MIXER_SAMPLE_RATE / static_cast<double>(speed);
+    const double endTime = startTime + frameCount / framesPerSecond;
+
+    // 鳴り始めがブロックより前でも、残りがブロックにかかるものから見る
+    const double firstTime = startTime - longestSound / framesPerSecond;
+    auto it = std::lower_bound(ticks.begin(), ticks.end(), firstTime, [](const Tick& tick, double time) { return tick.time < time; });
+    for (; it != ticks.end() && it->time < endTime; ++it) {
+        const std::vector<float>& sound = sounds[it->kind];
+        long long offset = std::llround((it->time - startTime) * framesPerSecond);
+        size_t soundStart = offset < 0 ? static_cast<size_t>(-offset) : 0;
+        size_t blockStart = offset > 0 ? static_cast<size_t>(offset) : 0;
+        if (soundStart >= sound.size() || blockStart >= frameCount) continue;
+        size_t count = std::min(sound.size() - soundStart, frameCount - blockStart);
+        for (size_t i = 0; i < count; ++i) {
+            float value = sound[soundStart + i] * gain;
+            frames[(blockStart + i) * 2] += value;
+            frames[(blockStart + i) * 2 + 1] += value;
+        }
+    }
+}
+
+std::string getAssistTickModeLabel(AssistTickMode mode) {
+    switch (mode) {
+    case AssistTickMode::OFF: return "Off";
+    case AssistTickMode::BEAT: return "Beat";
+    case AssistTickMode::NOTES: return "Notes";
+    case AssistTickMode::BOTH: return "Beat+Notes";
+    }
+    return "";
+}
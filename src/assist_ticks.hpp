@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// --- アシストのクリック ---
+// 譜面のテンポマップから求めた拍の頭と、ノーツの時刻でクリックを鳴らす (テンポチェンジのある曲の練習用)。
+// フレームループから効果音を鳴らすのではなく、ストリーミングサービスのデコードスレッドが
+// BGMのブロックを作るときに、ブロックの曲中の時刻からクリックの位置をフレーム単位で求めて書き込む。
+// 曲と同じブロックに入るので、フレームレートや一時停止・練習区間のループ・再生速度に関係なくずれない。
+// (再生速度を変えたときは時間伸縮の後に書き込むので、クリックの音自体は伸び縮みしない)
+class AssistTickTrack {
+public:
+    AssistTickTrack(const std::vector<ChartBeat>& beats, const std::vector<Note>& chart, AssistTickMode mode);
+
+    // 曲中の時刻 startTime (秒) から出力1フレームごとに speed フレームずつ進むステレオのブロックに、
+    // その間に鳴るクリックを gain 倍で足す。前のブロックから続くクリックの残りも書く
+    void mix(float* frames, size_t frameCount, double startTime, float speed, float gain) const;
+
+    bool empty() const { return ticks.empty(); }
+
+private:
+    enum Kind { DOWNBEAT, BEAT, NOTE, KIND_COUNT };
+
+    struct Tick {
+        double time; // 秒
+        Kind kind;
+    };
+
+    std::vector<Tick> ticks; // 時刻順
+    std::vector<float> sounds[KIND_COUNT]; // モノラル (MIXER_SAMPLE_RATE)
+    size_t longestSound = 0;
+};
+
+// オプション画面の表示名
+std::string getAssistTickModeLabel(AssistTickMode mode);
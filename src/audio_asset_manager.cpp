@@ -0,0 +1,55 @@
+#include "audio_asset_manager.hpp"
+#include "constants.hpp"
+
+namespace {
+struct CueDefinition {
+    AudioChannel channel;
+    const char* path;
+    bool loop;
+};
+
+const CueDefinition CUE_DEFINITIONS[MUSIC_CUE_COUNT] = {
+    {AudioChannel::MENU, "audio/title.ogg", true},
+    {AudioChannel::RESULTS, "audio/result.ogg", false},
+    {AudioChannel::GAMEOVER, "audio/failsound.ogg", false},
+};
+
+AudioChannel getCueChannel(MusicCue cue) {
+    return CUE_DEFINITIONS[static_cast<int>(cue)].channel;
+}
+}
+
+AudioAssetManager::AudioAssetManager(AudioStreamingService& service) : service(service) {
+}
+
+void AudioAssetManager::load() {
+    for (const auto& cue : CUE_DEFINITIONS) {
+        service.open(cue.channel, cue.path, MUSIC_PRELOAD_HEAD, cue.loop);
+    }
+}
+
+void AudioAssetManager::setVolume(float volume) {
+    for (const auto& cue : CUE_DEFINITIONS) {
+        service.setChannelVolume(cue.channel, volume);
+    }
+}
+
+void AudioAssetManager::play(MusicCue cue, sf::Time fade) {
+    service.play(getCueChannel(cue), fade);
+}
+
+void AudioAssetManager::stop(MusicCue cue, sf::Time fade) {
+    service.stop(getCueChannel(cue), fade);
+}
+
+void AudioAssetManager::crossfadeTo(MusicCue cue, sf::Time duration) {
+    for (int i = 0; i < MUSIC_CUE_COUNT; ++i) {
+        if (i != static_cast<int>(cue)) stop(static_cast<MusicCue>(i), duration);
+    }
+    service.fadeIn(getCueChannel(cue), duration);
+}
+
+bool AudioAssetManager::isPlaying(MusicCue cue) const {
+    AudioChannel channel = getCueChannel(cue);
+    return service.getStatus(channel) == sf::SoundSource::Playing && !service.isFadingOut(channel);
+}
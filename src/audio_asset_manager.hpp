@@ -0,0 +1,27 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include "audio_streaming_service.hpp"
+#include "types.hpp"
+
+// --- メニュー系BGMの管理 ---
+// タイトル・リザルト・ゲームオーバーのBGMを起動時にストリーミングサービスのチャンネルへ開き、
+// 先頭をデコードしておく。画面遷移のフレームではファイルを開かずにすぐ鳴らす。
+class AudioAssetManager {
+public:
+    explicit AudioAssetManager(AudioStreamingService& service);
+
+    // すべてのキューを開いておく。開けなかったキューは鳴らさないだけで続行する
+    void load();
+    void setVolume(float volume);
+
+    // 先頭から鳴らす (fade が 0 なら即座に最大音量)
+    void play(MusicCue cue, sf::Time fade = sf::Time::Zero);
+    void stop(MusicCue cue, sf::Time fade = sf::Time::Zero);
+    // cue 以外をフェードアウトし、cue を (鳴っていなければ先頭から) フェードインする
+    void crossfadeTo(MusicCue cue, sf::Time duration);
+    bool isPlaying(MusicCue cue) const;
+
+private:
+    AudioStreamingService& service;
+};
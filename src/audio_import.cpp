@@ -0,0 +1,90 @@
+#include "audio_import.hpp"
+#include "file_utils.hpp"
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+AudioImportManifest::AudioImportManifest(const std::string& directory)
+    : directory(directory)
+{
+}
+
+bool AudioImportManifest::load() {
+    entries.clear();
+    std::ifstream ifs(directory + "/manifest.json");
+    if (!ifs.is_open()) return false;
+    try {
+        json manifestJson = json::parse(ifs);
+        for (auto it = manifestJson.begin(); it != manifestJson.end(); ++it) {
+            Entry entry;
+            entry.modifiedTime = it.value().at("modified").get<long long>();
+            entry.size = it.value().at("size").get<long long>();
+            entry.hash = it.value().at("hash").get<std::string>();
+            entry.output = it.value().at("output").get<std::string>();
+            entries[it.key()] = entry;
+        }
+    } catch (const json::exception& e) {
+        // 壊れていたら全部変換し直す
+        entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AudioImportManifest::save() const {
+    if (!ensureDirectory(directory)) return false;
+    json manifestJson = json::object();
+    for (const auto& item : entries) {
+        manifestJson[item.first] = {
+            {"modified", item.second.modifiedTime},
+            {"size", item.second.size},
+            {"hash", item.second.hash},
+            {"output", item.second.output},
+        };
+    }
+
+    return writeFileAtomically(directory + "/manifest.json", [&](std::ostream& os) {
+        os << std::setw(2) << manifestJson << std::endl;
+        return static_cast<bool>(os);
+    });
+}
+
+std::string AudioImportManifest::resolve(const std::string& sourcePath) const {
+    const Entry* entry = find(sourcePath);
+    if (!entry) return sourcePath;
+    FileStamp sourceStamp, outputStamp;
+    if (!getFileStamp(sourcePath, sourceStamp) ||
+        sourceStamp.modifiedTime != entry->modifiedTime || sourceStamp.size != entry->size) {
+        return sourcePath; // 変換した後に差し替えられた
+    }
+    if (!getFileStamp(entry->output, outputStamp)) return sourcePath;
+    return entry->output;
+}
+
+const AudioImportManifest::Entry* AudioImportManifest::find(const std::string& sourcePath) const {
+    auto it = entries.find(sourcePath);
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+void AudioImportManifest::set(const std::string& sourcePath, const Entry& entry) {
+    entries[sourcePath] = entry;
+}
+
+std::string AudioImportManifest::getOutputPath(const std::string& hash) const {
+    return directory + "/" + hash + ".ogg";
+}
+
+bool hashFileContents(const std::string& path, std::string& hash) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) return false;
+    std::vector<char> buffer(1 << 20);
+    unsigned long long value = hashBytes(nullptr, 0);
+    while (ifs) {
+        ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize count = ifs.gcount();
+        if (count <= 0) break;
+        value = hashBytes(buffer.data(), static_cast<size_t>(count), value);
+    }
+    hash = toHexString(value);
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+// --- 曲の音声のインポート ---
+// songs.json の音声を、出力と同じサンプルレート (MIXER_SAMPLE_RATE)・ステレオの Ogg Vorbis に揃えて
+// audio/imported/<中身のハッシュ>.ogg に置く (tools/audioimport が行う)。
+// どの曲もデコードの負荷とメモリ量が同じになり、再生中のサンプルレート変換もなくなる。
+// もともとその形式のファイルは変換せず、そのまま使う。
+//
+// 対応表 audio/imported/manifest.json には元ファイルの更新日時・サイズ・中身のハッシュを記録する。
+// 日時とサイズが同じなら読み直さず、変わっていても中身が同じなら変換し直さない。
+class AudioImportManifest {
+public:
+    struct Entry {
+        long long modifiedTime = 0;
+        long long size = 0;
+        std::string hash;
+        std::string output; // 変換後のパス (変換しなかったら元のパス)
+    };
+
+    explicit AudioImportManifest(const std::string& directory = "audio/imported");
+
+    bool load();
+    bool save() const;
+
+    // 変換済みで、元ファイルが変わっておらず変換後のファイルがあればそのパス。そうでなければ sourcePath
+    std::string resolve(const std::string& sourcePath) const;
+
+    const Entry* find(const std::string& sourcePath) const;
+    void set(const std::string& sourcePath, const Entry& entry);
+    const std::string& getDirectory() const { return directory; }
+    std::string getOutputPath(const std::string& hash) const;
+
+private:
+    std::string directory;
+    std::map<std::string, Entry> entries;
+};
+
+// ファイルの中身のハッシュ (FNV-1a を16進数にしたもの)。少しずつ読むので大きなファイルでもよい
+bool hashFileContents(const std::string& path, std::string& hash);
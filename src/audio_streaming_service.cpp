@@ -0,0 +1,771 @@
+#include "audio_streaming_service.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "sfx_mixer.hpp"
+#include "thread_priority.hpp"
+
+namespace {
+unsigned int packState(unsigned int generation, sf::SoundSource::Status status) {
+    return (generation << 2) | static_cast<unsigned int>(status);
+}
+
+unsigned int getStateGeneration(unsigned int state) {
+    return state >> 2;
+}
+
+sf::SoundSource::Status getStateStatus(unsigned int state) {
+    return static_cast<sf::SoundSource::Status>(state & 3u);
+}
+
+long long toFrames(sf::Time time) {
+    return time.asMicroseconds() * static_cast<long long>(MIXER_SAMPLE_RATE) / 1000000;
+}
+
+long long framesToMicroseconds(long long frames) {
+    return frames * 1000000 / static_cast<long long>(MIXER_SAMPLE_RATE);
+}
+}
+
+AudioStreamingService::Channel::Channel()
+    : generation(0),
+      state(packState(0, sf::SoundSource::Stopped)),
+      volume(1.f),
+      loudnessGain(1.f),
+      speed(1.f),
+      endedGeneration(0),
+      endOutputFrame(0) {
+    settings.source = std::make_shared<MusicSource>();
+    for (auto& entry : history) {
+        entry.sequence.store(0);
+        entry.generation.store(0);
+        entry.outputFrame.store(-1);
+        entry.sourceTime.store(0);
+        entry.advancedFrames.store(0);
+        entry.speed.store(1.f);
+    }
+}
+
+AudioStreamingService::AudioStreamingService()
+    : running(false),
+      mixBuffer(AUDIO_STREAM_CHUNK_FRAMES * 2, 0.f),
+      outputBuffer(AUDIO_STREAM_CHUNK_FRAMES * 2, 0),
+      mixedFrames(0),
+      publishedMixedFrames(0),
+      outputOrigin(0),
+      tap(new std::atomic<float>[AUDIO_TAP_FRAMES]),
+      priorityRaised(false),
+      mixLoad(0.f),
+      underrunCount(0) {
+    for (int i = 0; i < AUDIO_CHANNEL_COUNT; ++i) {
+        channels[i].reset(new Channel());
+    }
+    for (size_t i = 0; i < AUDIO_TAP_FRAMES; ++i) {
+        tap[i].store(0.f, std::memory_order_relaxed);
+    }
+    initialize(2, MIXER_SAMPLE_RATE);
+}
+
+AudioStreamingService::~AudioStreamingService() {
+    shutdown();
+}
+
+void AudioStreamingService::start() {
+    if (running.load()) return;
+    running.store(true);
+    decodeThread = std::thread(&AudioStreamingService::decodeLoop, this);
+    sf::SoundStream::play();
+}
+
+void AudioStreamingService::shutdown() {
+    // 派生クラスが壊れる前に出力スレッドを止める
+    sf::SoundStream::stop();
+    if (running.exchange(false)) {
+        wakeDecoder();
+        decodeThread.join();
+    }
+}
+
+// --- メインスレッドからの操作 ---
+
+bool AudioStreamingService::open(AudioChannel channelId, const std::string& path, sf::Time headDuration, bool loop) {
+    // 先頭のデコードはロックの外で済ませ、デコードスレッドを待たせない
+    std::unique_ptr<MusicSource> source(new MusicSource());
+    if (!source->open(path, headDuration)) source.reset();
+    return open(channelId, std::move(source), loop);
+}
+
+bool AudioStreamingService::open(AudioChannel channelId, std::unique_ptr<MusicSource> source, bool loop) {
+    Channel& channel = getChannel(channelId);
+    {
+        // デコードスレッドは新しい世代を見てから設定を写すので、世代より先に書いておく
+        std::lock_guard<std::mutex> lock(channel.settingsMutex);
+        channel.settings.loop = loop;
+        channel.settings.opened = source != nullptr;
+        if (source) channel.settings.source = std::move(source);
+    }
+    unsigned int generation = channel.generation.load() + 1;
+    channel.generation.store(generation);
+    channel.state.store(packState(generation, sf::SoundSource::Stopped));
+    channel.fadingOut = false;
+    return channel.settings.opened;
+}
+
+void AudioStreamingService::play(AudioChannel channelId, sf::Time fadeIn) {
+    startChannel(channelId, fadeIn > sf::Time::Zero ? 0.f : 1.f, fadeIn, -1);
+}
+
+void AudioStreamingService::playAt(AudioChannel channelId, long long startFrame) {
+    startChannel(channelId, 1.f, sf::Time::Zero, startFrame);
+}
+
+void AudioStreamingService::startChannel(AudioChannel channelId, float gain, sf::Time fadeIn, long long startFrame) {
+    Channel& channel = getChannel(channelId);
+    if (!channel.settings.opened) return;
+
+    // 世代を進めると、デコードスレッドは先頭に戻り、出力スレッドは古いブロックを捨てる
+    // (予約再生でも鳴り始めるまでの間に先頭のブロックを用意しておける)
+    unsigned int generation = channel.generation.load() + 1;
+    channel.generation.store(generation);
+    channel.state.store(packState(generation, sf::SoundSource::Playing));
+    channel.fadingOut = false;
+    sendCommand(CommandType::START, channelId, gain, fadeIn, false, startFrame);
+    wakeDecoder();
+}
+
+void AudioStreamingService::pause(AudioChannel channelId) {
+    Channel& channel = getChannel(channelId);
+    unsigned int state = channel.state.load();
+    if (getStateStatus(state) != sf::SoundSource::Playing) return;
+    channel.state.store(packState(getStateGeneration(state), sf::SoundSource::Paused));
+    sendCommand(CommandType::PAUSE, channelId, 0.f, sf::Time::Zero, false);
+}
+
+void AudioStreamingService::resume(AudioChannel channelId) {
+    Channel& channel = getChannel(channelId);
+    unsigned int state = channel.state.load();
+    if (getStateStatus(state) != sf::SoundSource::Paused) return;
+    channel.state.store(packState(getStateGeneration(state), sf::SoundSource::Playing));
+    sendCommand(CommandType::RESUME, channelId, 0.f, sf::Time::Zero, false);
+    wakeDecoder();
+}
+
+void AudioStreamingService::stop(AudioChannel channelId, sf::Time fadeOut) {
+    Channel& channel = getChannel(channelId);
+    unsigned int state = channel.state.load();
+    if (getStateStatus(state) == sf::SoundSource::Stopped) return;
+
+    if (fadeOut <= sf::Time::Zero || getStateStatus(state) == sf::SoundSource::Paused) {
+        channel.state.store(packState(getStateGeneration(state), sf::SoundSource::Stopped));
+        channel.fadingOut = false;
+        sendCommand(CommandType::FADE, channelId, 0.f, sf::Time::Zero, true);
+    } else {
+        // フェードし終えた時点で出力スレッドが Stopped にする
+        channel.fadingOut = true;
+        sendCommand(CommandType::FADE, channelId, 0.f, fadeOut, true);
+    }
+}
+
+void AudioStreamingService::fadeIn(AudioChannel channelId, sf::Time duration) {
+    Channel& channel = getChannel(channelId);
+    if (getStatus(channelId) == sf::SoundSource::Playing) {
+        if (channel.fadingOut) {
+            channel.fadingOut = false;
+            sendCommand(CommandType::FADE, channelId, 1.f, duration, false);
+        }
+    } else {
+        play(channelId, duration);
+    }
+}
+
+void AudioStreamingService::crossfade(AudioChannel from, AudioChannel to, sf::Time duration) {
+    stop(from, duration);
+    fadeIn(to, duration);
+}
+
+void AudioStreamingService::setChannelVolume(AudioChannel channelId, float volume) {
+    getChannel(channelId).volume.store(std::max(0.f, std::min(100.f, volume)) / 100.f);
+}
+
+void AudioStreamingService::setChannelGain(AudioChannel channelId, float decibels) {
+    getChannel(channelId).loudnessGain.store(std::pow(10.f, decibels / 20.f));
+}
+
+void AudioStreamingService::setTicks(AudioChannel channelId, std::shared_ptr<const AssistTickTrack> ticks) {
+    Channel& channel = getChannel(channelId);
+    std::lock_guard<std::mutex> lock(channel.settingsMutex);
+    channel.settings.ticks = ticks && !ticks->empty() ? ticks : nullptr;
+}
+
+void AudioStreamingService::setSection(AudioChannel channelId, sf::Time start, sf::Time end, bool loop) {
+    Channel& channel = getChannel(channelId);
+    std::lock_guard<std::mutex> lock(channel.settingsMutex);
+    channel.settings.sectionStart = std::max(sf::Time::Zero, start);
+    channel.settings.sectionEnd = end > channel.settings.sectionStart ? end : sf::Time::Zero;
+    channel.settings.sectionLoop = loop;
+}
+
+sf::Time AudioStreamingService::getDuration(AudioChannel channelId) {
+    Channel& channel = getChannel(channelId);
+    // 設定を書くのはメインスレッドだけで、長さなどは開いた後は変わらないのでロックはいらない
+    const MusicSource& source = *channel.settings.source;
+    if (!channel.settings.opened || source.getChannelCount() == 0 || source.getSampleRate() == 0) return sf::Time::Zero;
+    sf::Uint64 frames = source.getSampleCount() / source.getChannelCount();
+    return sf::microseconds(static_cast<sf::Int64>(frames * 1000000 / source.getSampleRate()));
+}
+
+void AudioStreamingService::setPlaybackSpeed(AudioChannel channelId, float speed) {
+    getChannel(channelId).speed.store(std::max(PRACTICE_SPEED_MIN, std::min(PRACTICE_SPEED_MAX, speed)));
+}
+
+long long AudioStreamingService::getOutputFrame() const {
+    long long now = outputClock.getElapsedTime().asMicroseconds();
+    long long played = (outputOrigin.load() + now * static_cast<long long>(MIXER_SAMPLE_RATE)) / 1000000;
+    return std::max(0LL, std::min(played, publishedMixedFrames.load()));
+}
+
+sf::Time AudioStreamingService::getOutputLatency() const {
+    long long latency = std::max(0LL, getMixedFrame() - getOutputFrame());
+    return sf::microseconds(framesToMicroseconds(latency));
+}
+
+bool AudioStreamingService::readTap(float* out, size_t frameCount, long long endFrame) const {
+    const long long first = endFrame - static_cast<long long>(frameCount);
+    const long long oldest = publishedMixedFrames.load() + static_cast<long long>(AUDIO_STREAM_CHUNK_FRAMES) - static_cast<long long>(AUDIO_TAP_FRAMES);
+    if (first < 0 || first < oldest || endFrame > publishedMixedFrames.load()) return false;
+
+    for (size_t i = 0; i < frameCount; ++i) {
+        out[i] = tap[static_cast<size_t>(first + static_cast<long long>(i)) & (AUDIO_TAP_FRAMES - 1)].load(std::memory_order_relaxed);
+    }
+    // 写している間に出力スレッドが追い越していたら捨てる
+    long long latestOldest = publishedMixedFrames.load() + static_cast<long long>(AUDIO_STREAM_CHUNK_FRAMES) - static_cast<long long>(AUDIO_TAP_FRAMES);
+    return first >= latestOldest;
+}
+
+sf::SoundSource::Status AudioStreamingService::getStatus(AudioChannel channelId) const {
+    const Channel& channel = getChannel(channelId);
+    unsigned int state = channel.state.load();
+    sf::SoundSource::Status status = getStateStatus(state);
+
+    // 出力スレッドが曲の終わりを混ぜ終えても、実際に鳴り終わるまでは Playing とみなす
+    if (status == sf::SoundSource::Stopped && channel.endedGeneration.load() == getStateGeneration(state)) {
+        if (getOutputFrame() < channel.endOutputFrame.load()) return sf::SoundSource::Playing;
+    }
+    return status;
+}
+
+bool AudioStreamingService::isFadingOut(AudioChannel channelId) const {
+    return getChannel(channelId).fadingOut;
+}
+
+sf::Time AudioStreamingService::getPlayingOffset(AudioChannel channelId) const {
+    const Channel& channel = getChannel(channelId);
+    unsigned int generation = getStateGeneration(channel.state.load());
+    long long played = getOutputFrame();
+
+    // 今の世代で、すでに出力された中で一番新しい対応を探す
+    bool found = false;
+    long long bestFrame = 0, bestTime = 0, bestAdvanced = 0;
+    float bestSpeed = 1.f;
+    for (const auto& entry : channel.history) {
+        unsigned int before, after, entryGeneration;
+        long long outputFrame, sourceTime, advancedFrames;
+        float speed;
+        do {
+            before = entry.sequence.load();
+            entryGeneration = entry.generation.load();
+            outputFrame = entry.outputFrame.load();
+            sourceTime = entry.sourceTime.load();
+            advancedFrames = entry.advancedFrames.load();
+            speed = entry.speed.load();
+            after = entry.sequence.load();
+        } while (before != after || (before & 1u) != 0);
+
+        if (entryGeneration != generation || outputFrame < 0 || outputFrame > played) continue;
+        if (!found || outputFrame > bestFrame) {
+            found = true;
+            bestFrame = outputFrame;
+            bestTime = sourceTime;
+            bestAdvanced = advancedFrames;
+            bestSpeed = speed;
+        }
+    }
+    if (!found) return sf::Time::Zero;
+
+    long long advanced = std::min(played - bestFrame, bestAdvanced);
+    return sf::microseconds(bestTime + static_cast<long long>(framesToMicroseconds(advanced) * static_cast<double>(bestSpeed)));
+}
+
+void AudioStreamingService::sendCommand(CommandType type, AudioChannel channelId, float gain, sf::Time fade, bool stopAtEnd, long long startFrame) {
+    Command command;
+    command.type = type;
+    command.channel = static_cast<int>(channelId);
+    command.generation = getChannel(channelId).generation.load();
+    command.startFrame = startFrame;
+    command.gain = gain;
+    command.fadeFrames = std::max(0LL, toFrames(fade));
+    command.stopAtEnd = stopAtEnd;
+    commands.push(command);
+}
+
+// --- デコードスレッド ---
+
+void AudioStreamingService::wakeDecoder() {
+    wakeCondition.notify_one();
+}
+
+bool AudioStreamingService::wantsDecode(const Channel& channel) const {
+    sf::SoundSource::Status status = getStateStatus(channel.state.load());
+    return status != sf::SoundSource::Stopped;
+}
+
+void AudioStreamingService::decodeLoop() {
+    raiseCurrentThreadPriority(ThreadPriority::HIGH);
+
+    const size_t budgetBlocks = static_cast<size_t>(toFrames(AUDIO_DECODE_AHEAD)) / AUDIO_BLOCK_FRAMES;
+    std::vector<sf::Int16> pcm;
+
+    while (running.load()) {
+        size_t activeCount = 0;
+        for (const auto& channel : channels) {
+            if (wantsDecode(*channel)) ++activeCount;
+        }
+        size_t targetBlocks = budgetBlocks / std::max<size_t>(1, activeCount);
+        targetBlocks = std::max(AUDIO_MIN_DECODE_AHEAD_BLOCKS, std::min(targetBlocks, AUDIO_CHANNEL_QUEUE_BLOCKS - 1));
+
+        bool decoded = false;
+        for (auto& channel : channels) {
+            if (wantsDecode(*channel) && decodeChannel(*channel, targetBlocks, pcm)) decoded = true;
+        }
+
+        if (!decoded) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, std::chrono::microseconds(AUDIO_DECODE_INTERVAL.asMicroseconds()));
+        }
+    }
+}
+
+bool AudioStreamingService::decodeChannel(Channel& channel, size_t targetBlocks, std::vector<sf::Int16>& pcm) {
+    unsigned int generation = channel.generation.load();
+    if (generation != channel.decodedGeneration) {
+        {
+            std::lock_guard<std::mutex> lock(channel.settingsMutex);
+            channel.decoding = channel.settings;
+        }
+        channel.decodedGeneration = generation;
+        if (!channel.decoding.opened) {
+            channel.decodeEnded = true;
+            return false;
+        }
+
+        // 区間の先頭へのシークはメモリ上ならすぐ、ファイルでもここ (デコードスレッド) で済む
+        channel.loopStartFrames = toFrames(channel.decoding.sectionStart);
+        seekSource(channel, channel.decoding.sectionStart);
+        sf::Uint64 sampleRate = channel.decoding.source->getSampleRate();
+        channel.sourceSectionEnd = static_cast<sf::Uint64>(channel.decoding.sectionEnd.asMicroseconds()) * sampleRate / 1000000;
+        channel.seekFrame = channel.sourcePosition;
+        channel.firstPassFrames = -1;
+        channel.sourceLoopFrames = 0;
+        channel.resampling = sampleRate != MIXER_SAMPLE_RATE;
+        if (channel.resampling) channel.resampler.reset(static_cast<unsigned int>(sampleRate), MIXER_SAMPLE_RATE);
+        channel.pending.clear();
+        channel.blockedFrames = 0;
+        channel.decodeEnded = false;
+        channel.sourceEnded = false;
+        channel.decodedFrames = channel.loopStartFrames;
+        channel.decodeSpeed = channel.speed.load();
+        channel.stretcher.reset(channel.decodeSpeed);
+        channel.stretchInputFrames = 0;
+        channel.loopFrames = -1;
+    }
+    if (channel.decodeEnded) return false;
+
+    // 出力スレッドがまだ捨てていない古い世代のブロックも数に入るので、多めに積むことはない
+    bool decoded = false;
+    Block block;
+    // 止められたらすぐに手を離す (世代が変わらない stop でも、残りを積み続けない)
+    while (channel.blocks.size() < targetBlocks && channel.generation.load() == generation && wantsDecode(channel)) {
+        block.generation = generation;
+        block.speed = channel.decodeSpeed;
+        block.endOfStream = false;
+
+        if (channel.decodeSpeed != 1.f) {
+            fillStretchedBlock(channel, block, pcm);
+        } else {
+            fillBlock(channel, block, pcm);
+        }
+
+        if (channel.decoding.ticks) mixTicks(channel, block);
+        if (!channel.blocks.push(block)) break;
+        decoded = true;
+        if (channel.decodeEnded) break;
+    }
+    return decoded;
+}
+
+bool AudioStreamingService::readSource(Channel& channel, std::vector<sf::Int16>& pcm, std::vector<float>& stereo) {
+    unsigned int channelCount = channel.decoding.source->getChannelCount();
+    unsigned int sampleRate = channel.decoding.source->getSampleRate();
+    size_t sourceFrames = std::max<size_t>(1, AUDIO_BLOCK_FRAMES * sampleRate / MIXER_SAMPLE_RATE);
+    if (channel.sourceSectionEnd > 0) {
+        // 区間の終わりでちょうど切る
+        sourceFrames = static_cast<size_t>(std::min<sf::Uint64>(sourceFrames, channel.sourceSectionEnd - std::min(channel.sourcePosition, channel.sourceSectionEnd)));
+    }
+    pcm.resize(sourceFrames * channelCount);
+
+    size_t readSamples = sourceFrames > 0 ? channel.decoding.source->read(pcm.data(), pcm.size()) : 0;
+    size_t readFrames = readSamples / channelCount;
+    channel.sourcePosition += readFrames;
+    bool atEnd = readFrames < sourceFrames || (channel.sourceSectionEnd > 0 && channel.sourcePosition >= channel.sourceSectionEnd);
+    const bool looping = channel.decoding.loop || channel.decoding.sectionLoop;
+    if (atEnd && looping && channel.firstPassFrames < 0) {
+        // 1周の長さはここで決まる (2周目からは区間の先頭、区間がなければ曲の頭から読む)
+        channel.firstPassFrames = static_cast<long long>(channel.sourcePosition - channel.seekFrame);
+        sf::Uint64 loopStart = channel.decoding.sectionLoop ? static_cast<sf::Uint64>(channel.decoding.sectionStart.asMicroseconds()) * sampleRate / 1000000 : 0;
+        channel.sourceLoopFrames = static_cast<long long>(channel.sourcePosition - loopStart);
+    }
+
+    if (!channel.resampling) {
+        stereo = convertToStereoFloat(pcm.data(), readFrames, channelCount, sampleRate, sampleRate);
+        return atEnd;
+    }
+    // 変換器は読み位置の端数と入力の末尾を次の呼び出しへ持ち越す。ループの継ぎ目もそのままつなぎ、
+    // 出し切るのは本当に終わるときだけ
+    std::vector<float> input = convertToStereoFloat(pcm.data(), readFrames, channelCount, sampleRate, sampleRate);
+    stereo.clear();
+    channel.resampler.process(input.data(), readFrames, atEnd && !looping, stereo);
+    return atEnd;
+}
+
+void AudioStreamingService::fillBlock(Channel& channel, Block& block, std::vector<sf::Int16>& pcm) {
+    // 1ブロック分の出力がたまるまで入力を足す
+    std::vector<float> stereo;
+    while (!channel.sourceEnded && channel.pending.size() / 2 < AUDIO_BLOCK_FRAMES) {
+        bool atEnd = readSource(channel, pcm, stereo);
+        channel.pending.insert(channel.pending.end(), stereo.begin(), stereo.end());
+        if (atEnd) {
+            if ((channel.decoding.loop || channel.decoding.sectionLoop) && channel.sourceLoopFrames > 0) {
+                // ループは同じ世代のまま区間の先頭に戻る
+                seekSource(channel, channel.decoding.sectionLoop ? channel.decoding.sectionStart : sf::Time::Zero);
+            } else {
+                channel.sourceEnded = true;
+            }
+        }
+    }
+
+    // ブロックはループの継ぎ目で切り、1つのブロックの時刻が継ぎ目をまたがないようにする
+    size_t frameCount = std::min(channel.pending.size() / 2, AUDIO_BLOCK_FRAMES);
+    long long loopFrame = getNextLoopFrame(channel, channel.blockedFrames);
+    if (loopFrame > channel.blockedFrames) {
+        frameCount = static_cast<size_t>(std::min<long long>(static_cast<long long>(frameCount), loopFrame - channel.blockedFrames));
+    }
+    block.frameCount = frameCount;
+    if (frameCount > 0) {
+        std::memcpy(block.frames, channel.pending.data(), frameCount * 2 * sizeof(float));
+        channel.pending.erase(channel.pending.begin(), channel.pending.begin() + frameCount * 2);
+    }
+    // 時刻は読んだソースのフレームで決める (出力のフレームを数えると変換の端数がたまる)
+    block.sourceTime = std::llround(getSourcePosition(channel, channel.blockedFrames) * 1000000.0 / channel.decoding.source->getSampleRate());
+    channel.blockedFrames += static_cast<long long>(frameCount);
+
+    if (channel.sourceEnded && channel.pending.empty()) {
+        block.endOfStream = true;
+        channel.decodeEnded = true;
+    }
+}
+
+double AudioStreamingService::getSourcePosition(const Channel& channel, long long outputFrame) const {
+    // 出力の k フレーム目は、世代の頭から k * step ソースフレーム読んだ位置に当たる
+    const double step = channel.resampling ? channel.resampler.getStep() : 1.0;
+    const double position = outputFrame * step;
+    if (channel.firstPassFrames >= 0 && channel.sourceLoopFrames > 0 && position >= channel.firstPassFrames) {
+        const double loopStart = static_cast<double>(static_cast<long long>(channel.seekFrame) + channel.firstPassFrames - channel.sourceLoopFrames);
+        return loopStart + std::fmod(position - channel.firstPassFrames, static_cast<double>(channel.sourceLoopFrames));
+    }
+    return static_cast<double>(channel.seekFrame) + position;
+}
+
+long long AudioStreamingService::getNextLoopFrame(const Channel& channel, long long outputFrame) const {
+    if (channel.firstPassFrames < 0 || channel.sourceLoopFrames <= 0) return -1;
+    const double step = channel.resampling ? channel.resampler.getStep() : 1.0;
+    const double position = outputFrame * step;
+    double boundary = static_cast<double>(channel.firstPassFrames);
+    if (position >= boundary) {
+        boundary += (std::floor((position - boundary) / channel.sourceLoopFrames) + 1.0) * channel.sourceLoopFrames;
+    }
+    return static_cast<long long>(std::ceil(boundary / step));
+}
+
+void AudioStreamingService::seekSource(Channel& channel, sf::Time time) {
+    channel.sourcePosition = static_cast<sf::Uint64>(time.asMicroseconds()) * channel.decoding.source->getSampleRate() / 1000000;
+    channel.decoding.source->seek(channel.sourcePosition);
+}
+
+void AudioStreamingService::fillStretchedBlock(Channel& channel, Block& block, std::vector<sf::Int16>& pcm) {
+    // 1ブロック分の出力がたまるまで入力を足す
+    std::vector<float> stereo;
+    while (!channel.sourceEnded && channel.stretcher.getAvailableFrames() < AUDIO_BLOCK_FRAMES) {
+        bool atEnd = readSource(channel, pcm, stereo);
+        channel.stretcher.write(stereo.data(), stereo.size() / 2);
+        channel.stretchInputFrames += static_cast<long long>(stereo.size() / 2);
+        if (atEnd) {
+            if (channel.decoding.loop || channel.decoding.sectionLoop) {
+                // 伸縮器はそのまま続けるので、ループの継ぎ目も途切れない
+                seekSource(channel, channel.decoding.sectionLoop ? channel.decoding.sectionStart : sf::Time::Zero);
+                if (channel.loopFrames < 0) {
+                    // 変換器の先読みの分だけ出力は遅れるので、1周の長さはソースのフレームから求める
+                    channel.loopFrames = std::llround(channel.firstPassFrames * static_cast<double>(MIXER_SAMPLE_RATE) / channel.decoding.source->getSampleRate());
+                }
+            } else {
+                channel.stretcher.finish();
+                channel.sourceEnded = true;
+            }
+        }
+    }
+
+    block.frameCount = channel.stretcher.read(block.frames, AUDIO_BLOCK_FRAMES);
+    // 時刻は出力フレーム数 x 速度で決める。伸縮器が実際に選んだ位置の揺れは時計に持ち込まない
+    long long outputFrames = channel.decodedFrames - channel.loopStartFrames;
+    long long sourceFrame = static_cast<long long>(outputFrames * static_cast<double>(channel.decodeSpeed));
+    if (channel.loopFrames > 0) sourceFrame %= channel.loopFrames;
+    block.sourceTime = framesToMicroseconds(channel.loopStartFrames + sourceFrame);
+    channel.decodedFrames += static_cast<long long>(block.frameCount);
+
+    if (channel.sourceEnded && channel.stretcher.isDrained()) {
+        block.endOfStream = true;
+        channel.decodeEnded = true;
+    }
+}
+
+void AudioStreamingService::mixTicks(const Channel& channel, Block& block) {
+    // クリックの大きさは曲ごとの音量の補正に左右されないようにする
+    const float gain = 1.f / std::max(0.01f, channel.loudnessGain.load());
+    const double startTime = block.sourceTime / 1000000.0;
+    size_t frameCount = block.frameCount;
+    double wrapTime = -1.0;
+    if (channel.loopFrames > 0) {
+        // 時間伸縮したループはブロックの途中で区間の先頭に戻ることがある
+        const double loopEnd = static_cast<double>(channel.loopStartFrames + channel.loopFrames) / MIXER_SAMPLE_RATE;
+        const double framesToEnd = std::ceil((loopEnd - startTime) * MIXER_SAMPLE_RATE / block.speed);
+        if (framesToEnd < static_cast<double>(frameCount)) {
+            frameCount = static_cast<size_t>(std::max(0.0, framesToEnd));
+            wrapTime = static_cast<double>(channel.loopStartFrames) / MIXER_SAMPLE_RATE + (startTime + frameCount * block.speed / MIXER_SAMPLE_RATE - loopEnd);
+        }
+    }
+    channel.decoding.ticks->mix(block.frames, frameCount, startTime, block.speed, gain);
+    if (wrapTime >= 0.0) {
+        channel.decoding.ticks->mix(block.frames + frameCount * 2, block.frameCount - frameCount, wrapTime, block.speed, gain);
+    }
+}
+
+// --- 出力スレッド ---
+
+bool AudioStreamingService::onGetData(Chunk& data) {
+    if (!priorityRaised) {
+        raiseCurrentThreadPriority(ThreadPriority::REALTIME);
+        priorityRaised = true;
+    }
+    mixClock.restart();
+    updateOutputPosition();
+
+    Command command;
+    while (commands.pop(command)) {
+        applyCommand(command);
+    }
+
+    std::fill(mixBuffer.begin(), mixBuffer.end(), 0.f);
+    const long long chunkStart = mixedFrames;
+    for (auto& channel : channels) {
+        // 止めた・開き直したチャンネルの古いブロックを捨てる
+        unsigned int generation = channel->generation.load();
+        Block* block = channel->blocks.front();
+        while (block && block->generation != generation) {
+            channel->blocks.popFront();
+            channel->blockOffset = 0;
+            block = channel->blocks.front();
+        }
+        // START を受け取る前に開き直されたチャンネルは止めておく
+        if (channel->playing && channel->playingGeneration != generation) channel->playing = false;
+        if (channel->playing) mixChannel(*channel, chunkStart);
+    }
+
+    for (size_t i = 0; i < mixBuffer.size(); ++i) {
+        float value = std::max(-1.f, std::min(1.f, mixBuffer[i]));
+        outputBuffer[i] = static_cast<sf::Int16>(value * 32767.f);
+    }
+    for (size_t i = 0; i < AUDIO_STREAM_CHUNK_FRAMES; ++i) {
+        size_t index = static_cast<size_t>(chunkStart + static_cast<long long>(i)) & (AUDIO_TAP_FRAMES - 1);
+        tap[index].store((mixBuffer[i * 2] + mixBuffer[i * 2 + 1]) * 0.5f, std::memory_order_relaxed);
+    }
+    mixedFrames += AUDIO_STREAM_CHUNK_FRAMES;
+    publishedMixedFrames.store(mixedFrames);
+    wakeDecoder();
+
+    float load = mixClock.getElapsedTime().asSeconds() * MIXER_SAMPLE_RATE / AUDIO_STREAM_CHUNK_FRAMES;
+    mixLoad.store(mixLoad.load() + (load - mixLoad.load()) * AUDIO_LOAD_SMOOTHING);
+
+    data.samples = outputBuffer.data();
+    data.sampleCount = outputBuffer.size();
+    return true; // 鳴らすチャンネルがなくても無音を流し続ける
+}
+
+void AudioStreamingService::updateOutputPosition() {
+    // onGetData はバッファが1つ鳴り終わるたびに呼ばれる。ほかのバッファはまだキューに残っているので、
+    // 渡したフレームからその分を引いたところまでが鳴り終わっている
+    const long long queued = static_cast<long long>((AUDIO_OUTPUT_BUFFER_COUNT - 1) * AUDIO_STREAM_CHUNK_FRAMES);
+    const long long played = std::max(0LL, mixedFrames - queued);
+    const long long now = outputClock.getElapsedTime().asMicroseconds();
+    long long origin = played * 1000000 - now * static_cast<long long>(MIXER_SAMPLE_RATE);
+
+    // 呼ばれるのは鳴り終わってから SFML が見に来るまでの分だけ遅いので、この推定は実際より遅れている。
+    // 前の推定を延ばした方が進んでいればそちらを使う。時計のずれがたまらないよう少しずつ引き戻し、
+    // 1チャンク以上離れたら (音切れで出力が止まっていたなど) 今の推定に合わせ直す
+    const long long previous = outputOrigin.load() - AUDIO_POSITION_LEAK_FRAMES * 1000000;
+    if (previous > origin && previous - origin < static_cast<long long>(AUDIO_STREAM_CHUNK_FRAMES) * 1000000) origin = previous;
+    outputOrigin.store(origin);
+}
+
+void AudioStreamingService::onSeek(sf::Time) {
+    // 出力は止めずに流し続けるのでシークはしない (チャンネルごとの位置はブロックの時刻で管理する)
+}
+
+void AudioStreamingService::applyCommand(const Command& command) {
+    Channel& channel = *channels[command.channel];
+    switch (command.type) {
+    case CommandType::START:
+        channel.playing = true;
+        channel.playingGeneration = command.generation;
+        channel.primed = false;
+        channel.startFrame = command.startFrame;
+        channel.blockOffset = 0;
+        channel.gain = command.gain;
+        channel.gainTarget = 1.f;
+        channel.fadeRemaining = command.fadeFrames;
+        channel.gainStep = command.fadeFrames > 0 ? (1.f - command.gain) / command.fadeFrames : 0.f;
+        channel.stopAtFadeEnd = false;
+        if (command.fadeFrames == 0) channel.gain = 1.f;
+        break;
+    case CommandType::PAUSE:
+        if (command.generation == channel.playingGeneration) channel.playing = false;
+        break;
+    case CommandType::RESUME:
+        if (command.generation == channel.playingGeneration) channel.playing = true;
+        break;
+    case CommandType::FADE:
+        if (command.generation != channel.playingGeneration) break;
+        channel.gainTarget = command.gain;
+        channel.fadeRemaining = command.fadeFrames;
+        channel.gainStep = command.fadeFrames > 0 ? (command.gain - channel.gain) / command.fadeFrames : 0.f;
+        channel.stopAtFadeEnd = command.stopAtEnd;
+        if (command.fadeFrames == 0) {
+            channel.gain = command.gain;
+            if (command.stopAtEnd) channel.playing = false;
+        }
+        break;
+    }
+}
+
+void AudioStreamingService::mixChannel(Channel& channel, long long chunkStart) {
+    const float volume = channel.volume.load() * channel.loudnessGain.load();
+    size_t index = 0;
+
+    // 予約再生はチャンクの途中から鳴らし始める
+    if (channel.startFrame > chunkStart) {
+        if (channel.startFrame - chunkStart >= static_cast<long long>(AUDIO_STREAM_CHUNK_FRAMES)) return;
+        index = static_cast<size_t>(channel.startFrame - chunkStart);
+    }
+    long long entryFrame = -1, entryTime = 0;
+    float entrySpeed = 1.f;
+
+    while (index < AUDIO_STREAM_CHUNK_FRAMES) {
+        Block* block = channel.blocks.front();
+        if (!block) {
+            if (channel.primed) underrunCount.fetch_add(1); // デコードが間に合っていない。残りは無音
+            break;
+        }
+        if (channel.blockOffset >= block->frameCount) {
+            bool ended = block->endOfStream;
+            channel.blocks.popFront();
+            channel.blockOffset = 0;
+            if (ended) {
+                finishChannel(channel, chunkStart + static_cast<long long>(index));
+                break;
+            }
+            continue;
+        }
+
+        if (entryFrame >= 0 && channel.blockOffset == 0 && block->sourceTime < entryTime) {
+            // ループで時刻が戻った。ここから先は別の対応として記録する
+            recordPosition(channel, entryFrame, entryTime, chunkStart + static_cast<long long>(index) - entryFrame, entrySpeed);
+            entryFrame = -1;
+        }
+
+        channel.primed = true;
+        if (entryFrame < 0) {
+            entryFrame = chunkStart + static_cast<long long>(index);
+            entryTime = block->sourceTime + static_cast<long long>(framesToMicroseconds(static_cast<long long>(channel.blockOffset)) * static_cast<double>(block->speed));
+            entrySpeed = block->speed;
+        }
+
+        size_t frames = std::min(AUDIO_STREAM_CHUNK_FRAMES - index, block->frameCount - channel.blockOffset);
+        if (channel.fadeRemaining > 0) {
+            frames = static_cast<size_t>(std::min<long long>(static_cast<long long>(frames), channel.fadeRemaining));
+        }
+
+        const float* in = &block->frames[channel.blockOffset * 2];
+        float* out = &mixBuffer[index * 2];
+        if (channel.fadeRemaining > 0) {
+            for (size_t i = 0; i < frames; ++i) {
+                channel.gain += channel.gainStep;
+                out[i * 2] += in[i * 2] * channel.gain * volume;
+                out[i * 2 + 1] += in[i * 2 + 1] * channel.gain * volume;
+            }
+            channel.fadeRemaining -= static_cast<long long>(frames);
+        } else {
+            const float gain = channel.gain * volume;
+            for (size_t i = 0; i < frames * 2; ++i) {
+                out[i] += in[i] * gain;
+            }
+        }
+        channel.blockOffset += frames;
+        index += frames;
+
+        if (channel.fadeRemaining == 0 && channel.gain != channel.gainTarget) {
+            channel.gain = channel.gainTarget;
+        }
+        if (channel.fadeRemaining == 0 && channel.stopAtFadeEnd) {
+            finishChannel(channel, chunkStart + static_cast<long long>(index));
+            break;
+        }
+    }
+
+    if (entryFrame >= 0) {
+        recordPosition(channel, entryFrame, entryTime, chunkStart + static_cast<long long>(index) - entryFrame, entrySpeed);
+    }
+}
+
+void AudioStreamingService::finishChannel(Channel& channel, long long endFrame) {
+    channel.playing = false;
+    channel.stopAtFadeEnd = false;
+    channel.endOutputFrame.store(endFrame);
+    channel.endedGeneration.store(channel.playingGeneration);
+
+    // その間にメインスレッドが次の操作をしていたら上書きしない
+    for (int status = sf::SoundSource::Paused; status <= sf::SoundSource::Playing; ++status) {
+        unsigned int expected = packState(channel.playingGeneration, static_cast<sf::SoundSource::Status>(status));
+        if (channel.state.compare_exchange_strong(expected, packState(channel.playingGeneration, sf::SoundSource::Stopped))) break;
+    }
+}
+
+void AudioStreamingService::recordPosition(Channel& channel, long long outputFrame, long long sourceTime, long long advancedFrames, float speed) {
+    PositionEntry& entry = channel.history[channel.historyIndex];
+    channel.historyIndex = (channel.historyIndex + 1) % AUDIO_POSITION_HISTORY;
+
+    entry.sequence.fetch_add(1); // 奇数の間は書き込み中
+    entry.generation.store(channel.playingGeneration);
+    entry.outputFrame.store(outputFrame);
+    entry.sourceTime.store(sourceTime);
+    entry.advancedFrames.store(advancedFrames);
+    entry.speed.store(speed);
+    entry.sequence.fetch_add(1);
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "assist_ticks.hpp"
+#include "constants.hpp"
+#include "music_source.hpp"
+#include "resampler.hpp"
+#include "spsc_queue.hpp"
+#include "time_stretcher.hpp"
+#include "types.hpp"
+
+// --- 音楽ストリーミングサービス ---
+// sf::Music はインスタンスごとにストリーミングスレッドを持ち、それぞれが勝手な間隔で
+// バッファを見に行く。ここではBGM・メニュー・リザルト・試聴などをチャンネルとして持ち、
+// デコードは1本のスレッドで、出力は1本の sf::SoundStream でまとめて行う。
+//
+// - デコードスレッド: 各チャンネルの MusicSource を読み、ステレオ float のブロックにして
+//   チャンネルのキューに積む。先読み量は鳴っているチャンネル数で AUDIO_DECODE_AHEAD を分け合う
+// - 出力スレッド (onGetData): ブロックを混ぜるだけ。ロックもメモリ確保もしない
+// - メインスレッド: open/play/stop などの操作。出力スレッドへは命令キューで伝える
+//
+// 各ブロックには曲中の時刻が付いているので、チャンネルごとの再生位置は
+// 出力ストリームの再生位置から逆算できる (ゲームプレイの時刻はこれを使う)。
+// サンプルレートの違うソースはチャンネルごとの Resampler でブロックをまたいで続けて変換し、
+// ブロックの時刻は読んだソースのフレーム数から決める (出力のフレーム数を数えると変換の丸めがたまる)。
+// 再生速度を変えたチャンネルはデコードスレッドで時間伸縮してからキューに積む。
+// アシストのクリックもデコードスレッドがブロックの時刻に合わせて書き込む。
+class AudioStreamingService : public sf::SoundStream {
+public:
+    AudioStreamingService();
+    ~AudioStreamingService();
+
+    // デコードスレッドと出力を開始する
+    void start();
+    void shutdown();
+
+    // チャンネルにファイルを割り当てる。先頭 headDuration 分はここでデコードしておく
+    // (曲全体より長ければメモリ上だけで再生する)。鳴っていた音は止まる
+    bool open(AudioChannel channel, const std::string& path, sf::Time headDuration, bool loop);
+    // 別のスレッドで開いておいたソースを割り当てる (null なら閉じる)。重い処理はしない
+    bool open(AudioChannel channel, std::unique_ptr<MusicSource> source, bool loop);
+
+    // 先頭から鳴らす
+    void play(AudioChannel channel, sf::Time fadeIn = sf::Time::Zero);
+    // 出力フレーム startFrame (getMixedFrame() より先) からちょうど鳴り始めるよう予約する
+    void playAt(AudioChannel channel, long long startFrame);
+    void pause(AudioChannel channel);
+    void resume(AudioChannel channel);
+    void stop(AudioChannel channel, sf::Time fadeOut = sf::Time::Zero);
+    // 止まっていれば先頭からフェードインし、フェードアウト中なら音量を戻す
+    void fadeIn(AudioChannel channel, sf::Time duration);
+    void crossfade(AudioChannel from, AudioChannel to, sf::Time duration);
+    void setChannelVolume(AudioChannel channel, float volume); // 0-100
+    // 曲ごとの音量の補正 (dB)。音量とは別に掛ける (ラウドネスを揃えるためのもの)
+    void setChannelGain(AudioChannel channel, float decibels);
+    // 音程を変えずに再生速度を変える (練習用)。次の play/playAt から有効
+    void setPlaybackSpeed(AudioChannel channel, float speed);
+    // 再生する区間 [start, end) を決める (end が start 以下なら曲の終わりまで)。
+    // loop なら end で start に継ぎ目なく戻る。次の play/playAt から有効
+    void setSection(AudioChannel channel, sf::Time start, sf::Time end, bool loop);
+    // 曲に重ねて鳴らすクリック (null なら鳴らさない)。次の play/playAt から有効
+    void setTicks(AudioChannel channel, std::shared_ptr<const AssistTickTrack> ticks);
+
+    sf::SoundSource::Status getStatus(AudioChannel channel) const;
+    bool isFadingOut(AudioChannel channel) const;
+    sf::Time getPlayingOffset(AudioChannel channel) const;
+    // 開いている曲の長さ (開いていなければ0)
+    sf::Time getDuration(AudioChannel channel);
+
+    // 出力のタイムライン (フレーム)。ミックス済みの位置と、実際に再生された位置。
+    // 再生された位置は SFML の再生位置 (float の秒) を使わず、渡したフレーム数から整数で数える
+    long long getMixedFrame() const { return publishedMixedFrames.load(); }
+    long long getOutputFrame() const;
+    // ミックスしてから聞こえるまでの遅れ (実測)
+    sf::Time getOutputLatency() const;
+
+    // 出力したミックスをモノラルで少しだけ残しておく (スペクトル表示などの解析用)。
+    // 出力フレーム endFrame の直前 frameCount フレームを out に写す。間に合わなければ false
+    bool readTap(float* out, size_t frameCount, long long endFrame) const;
+
+    // 出力スレッドの負荷 (ミックスにかかった時間 / チャンクの長さ) と音切れの回数
+    float getMixLoad() const { return mixLoad.load(); }
+    unsigned int getUnderrunCount() const { return underrunCount.load(); }
+
+protected:
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time timeOffset) override;
+
+private:
+    struct Block {
+        float frames[AUDIO_BLOCK_FRAMES * 2]; // L, R の交互
+        size_t frameCount;
+        long long sourceTime; // 先頭フレームの曲中の時刻 (マイクロ秒)
+        float speed;          // 出力1フレームで進む曲中のフレーム数
+        unsigned int generation;
+        bool endOfStream;
+    };
+
+    // 出力チャンクごとの「出力フレーム → 曲中の時刻」の対応 (seqlock で読む)
+    struct PositionEntry {
+        std::atomic<unsigned int> sequence;
+        std::atomic<unsigned int> generation;
+        std::atomic<long long> outputFrame;
+        std::atomic<long long> sourceTime;
+        std::atomic<long long> advancedFrames;
+        std::atomic<float> speed;
+    };
+
+    enum class CommandType { START, PAUSE, RESUME, FADE };
+
+    struct Command {
+        CommandType type;
+        int channel;
+        unsigned int generation;
+        long long startFrame; // START: 鳴り始める出力フレーム。-1 なら次のチャンクから
+        float gain;           // START: 開始時の音量, FADE: 目標の音量
+        long long fadeFrames; // 0 なら即座に
+        bool stopAtEnd;       // FADE の終わりで止める
+    };
+
+    // open/setSection/setTicks で決まり、次の世代から使う設定
+    struct Settings {
+        std::shared_ptr<MusicSource> source;
+        bool loop = false;
+        bool opened = false;
+        sf::Time sectionStart;
+        sf::Time sectionEnd;
+        bool sectionLoop = false;
+        std::shared_ptr<const AssistTickTrack> ticks;
+    };
+
+    struct Channel {
+        // メインスレッドが書く。デコードスレッドは世代が変わったときだけ settingsMutex の中で decoding に写し、
+        // デコード中はロックを持たない (ファイルの読み込みや時間伸縮の間、メインスレッドを待たせない)
+        std::mutex settingsMutex;
+        Settings settings;
+
+        // メインスレッドが書き、他のスレッドが読む
+        std::atomic<unsigned int> generation; // open/play のたびに増え、古いブロックを捨てる目印になる
+        std::atomic<unsigned int> state;      // (generation << 2) | sf::SoundSource::Status
+        std::atomic<float> volume;
+        std::atomic<float> loudnessGain; // setChannelGain の倍率
+        std::atomic<float> speed;
+        bool fadingOut = false; // メインスレッドだけが使う
+
+        // 出力スレッドが書き、メインスレッドが読む
+        std::atomic<unsigned int> endedGeneration;
+        std::atomic<long long> endOutputFrame; // 自然に終わった世代の最後のフレームが出力される位置
+        PositionEntry history[AUDIO_POSITION_HISTORY];
+
+        // デコードスレッドだけが触る
+        Settings decoding; // 今の世代の設定 (古いソースもデコードし終えるまではここで生きている)
+        unsigned int decodedGeneration = 0;
+        bool decodeEnded = false;   // 最後のブロックを積んだ
+        bool sourceEnded = false;   // ソースを読み終えた (時間伸縮の出力はまだ残っているかもしれない)
+        long long decodedFrames = 0;
+        sf::Uint64 sourcePosition = 0;    // ソースの読み位置 (ソースのフレーム)
+        sf::Uint64 sourceSectionEnd = 0;  // 0 なら曲の終わりまで
+        sf::Uint64 seekFrame = 0;         // 世代の頭でシークした位置 (ソースのフレーム)
+        long long firstPassFrames = -1;   // 最初にループするまでに読んだソースのフレーム数 (-1 ならまだ)
+        long long sourceLoopFrames = 0;   // 2周目からの1周の長さ (ソースのフレーム)
+        bool resampling = false;          // ソースのレートが出力と違う
+        Resampler resampler;
+        std::vector<float> pending;       // 出力のレートにして、まだブロックにしていないフレーム (ステレオ)
+        long long blockedFrames = 0;      // 世代の頭からブロックにしたフレーム数 (出力のレート)
+        float decodeSpeed = 1.f;
+        TimeStretcher stretcher;
+        long long stretchInputFrames = 0; // 時間伸縮に渡した入力のフレーム数
+        long long loopFrames = -1;        // ループする長さ (時間伸縮のときの時刻の折り返しに使う)
+        long long loopStartFrames = 0;    // ループで戻る位置 (出力レートのフレーム)
+
+        // 出力スレッドだけが触る
+        bool playing = false;
+        bool primed = false; // 今の世代のブロックを鳴らし始めたか (それまでの無音は音切れに数えない)
+        unsigned int playingGeneration = 0;
+        long long startFrame = -1;
+        size_t blockOffset = 0;
+        float gain = 1.f;
+        float gainTarget = 1.f;
+        float gainStep = 0.f;
+        long long fadeRemaining = 0;
+        bool stopAtFadeEnd = false;
+        size_t historyIndex = 0;
+
+        SpscQueue<Block, AUDIO_CHANNEL_QUEUE_BLOCKS> blocks;
+
+        Channel();
+    };
+
+    void decodeLoop();
+    bool decodeChannel(Channel& channel, size_t targetBlocks, std::vector<sf::Int16>& pcm);
+    bool readSource(Channel& channel, std::vector<sf::Int16>& pcm, std::vector<float>& stereo);
+    void fillBlock(Channel& channel, Block& block, std::vector<sf::Int16>& pcm);
+    double getSourcePosition(const Channel& channel, long long outputFrame) const;
+    long long getNextLoopFrame(const Channel& channel, long long outputFrame) const;
+    void seekSource(Channel& channel, sf::Time time);
+    void fillStretchedBlock(Channel& channel, Block& block, std::vector<sf::Int16>& pcm);
+    void mixTicks(const Channel& channel, Block& block);
+    bool wantsDecode(const Channel& channel) const;
+    void wakeDecoder();
+
+    void updateOutputPosition();
+    void applyCommand(const Command& command);
+    void mixChannel(Channel& channel, long long chunkStart);
+    void finishChannel(Channel& channel, long long endFrame);
+    void recordPosition(Channel& channel, long long outputFrame, long long sourceTime, long long advancedFrames, float speed);
+    void sendCommand(CommandType type, AudioChannel channel, float gain, sf::Time fade, bool stopAtEnd, long long startFrame = -1);
+    void startChannel(AudioChannel channel, float gain, sf::Time fadeIn, long long startFrame);
+
+    Channel& getChannel(AudioChannel channel) { return *channels[static_cast<int>(channel)]; }
+    const Channel& getChannel(AudioChannel channel) const { return *channels[static_cast<int>(channel)]; }
+
+    std::unique_ptr<Channel> channels[AUDIO_CHANNEL_COUNT];
+
+    std::thread decodeThread;
+    std::atomic<bool> running;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    SpscQueue<Command, AUDIO_COMMAND_QUEUE_SIZE> commands;
+
+    // 出力スレッドだけが触る
+    std::vector<float> mixBuffer;
+    std::vector<sf::Int16> outputBuffer;
+    long long mixedFrames;
+    std::atomic<long long> publishedMixedFrames;
+    // 再生位置の推定。再生済みフレーム x 1000000 - outputClock の経過マイクロ秒 x レート (出力スレッドが書く)
+    std::atomic<long long> outputOrigin;
+    sf::Clock outputClock;
+    std::unique_ptr<std::atomic<float>[]> tap; // AUDIO_TAP_FRAMES のリングバッファ
+    bool priorityRaised;
+    sf::Clock mixClock;
+
+    std::atomic<float> mixLoad;
+    std::atomic<unsigned int> underrunCount;
+};
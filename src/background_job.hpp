@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "worker_pool.hpp"
+
+// --- 取り消せるバックグラウンドのジョブ ---
+// ワーカーで結果 (T) を1つ作り、メインスレッドが take() で受け取る。
+// start/cancel のたびに世代を進め、古いジョブは cancelled() で気付いて途中でやめる (結果は捨てる)。
+// 状態はワーカーと共有するので、ジョブが終わる前にこのオブジェクトが消えても困らない。
+// start/take/cancel/isBusy はメインスレッドから呼ぶ。
+template <typename T>
+class BackgroundJob {
+public:
+    using CancelCheck = std::function<bool()>;
+    // cancelled が true を返したら途中で戻ってよい (null を返せば失敗)
+    using Job = std::function<std::unique_ptr<T>(const CancelCheck& cancelled)>;
+
+    explicit BackgroundJob(WorkerPool& pool)
+        : pool(pool),
+          shared(std::make_shared<Shared>())
+    {
+    }
+
+    // 前のジョブを取り消して job を投げる
+    void start(Job job) {
+        const unsigned int generation = shared->generation.fetch_add(1) + 1;
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->ready.reset();
+            ++shared->running;
+        }
+
+        std::shared_ptr<Shared> state = shared;
+        pool.submit([state, generation, job]() {
+            CancelCheck cancelled = [&]() { return state->generation.load() != generation; };
+            std::unique_ptr<T> result;
+            if (!cancelled()) result = job(cancelled);
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            --state->running;
+            if (result && !cancelled()) {
+                state->ready = std::move(result);
+                state->readyGeneration = generation;
+            }
+        });
+    }
+
+    // 今のジョブが終わっていれば結果を取り出す (済んでいないか失敗なら null)
+    std::unique_ptr<T> take() {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (shared->ready && shared->readyGeneration != shared->generation.load()) shared->ready.reset();
+        return std::move(shared->ready);
+    }
+
+    // 投げてあるジョブは次に cancelled() を見たところでやめる
+    void cancel() {
+        shared->generation.fetch_add(1);
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->ready.reset();
+    }
+
+    // 取り消したものも含めて、まだ走っているジョブがあるか
+    bool isBusy() const {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        return shared->running > 0;
+    }
+
+private:
+    struct Shared {
+        std::atomic<unsigned int> generation{0};
+        std::mutex mutex;
+        unsigned int running = 0;
+        std::unique_ptr<T> ready;
+        unsigned int readyGeneration = 0;
+    };
+
+    WorkerPool& pool;
+    std::shared_ptr<Shared> shared;
+};
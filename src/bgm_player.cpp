@@ -0,0 +1,110 @@
+#include "bgm_player.hpp"
+#include "constants.hpp"
+
+namespace {
+// デコード前にヘッダだけ読んで、展開後のサイズを見積もる
+bool fitsInMemory(const sf::InputSoundFile& file, bool preferMemory, size_t memoryBudget) {
+    return preferMemory && file.getSampleCount() * sizeof(sf::Int16) <= memoryBudget;
+}
+
+// メモリ展開では曲より長い先頭を指定して全体をデコードさせる
+sf::Time getHeadDuration(const sf::InputSoundFile& file, bool inMemory) {
+    return inMemory ? file.getDuration() + sf::seconds(1.f) : MUSIC_PRELOAD_HEAD;
+}
+}
+
+BgmPlayer::BgmPlayer(AudioStreamingService& service) : service(service) {
+}
+
+bool BgmPlayer::open(const std::string& path, bool preferMemory, size_t memoryBudget) {
+    stop();
+
+    sf::InputSoundFile file;
+    if (!file.openFromFile(path)) return false;
+    bool fits = fitsInMemory(file, preferMemory, memoryBudget);
+    if (path == openedPath && fits == inMemory) return true;
+
+    openedPath.clear();
+    if (!service.open(channel, path, getHeadDuration(file, fits), false)) return false;
+    openedPath = path;
+    inMemory = fits;
+    return true;
+}
+
+bool BgmPlayer::open(std::unique_ptr<MusicSource> source) {
+    stop();
+    openedPath.clear();
+    inMemory = true;
+    return service.open(channel, std::move(source), false);
+}
+
+std::unique_ptr<MusicSource> BgmPlayer::openSource(const std::string& path, bool preferMemory, size_t memoryBudget, bool& inMemory) {
+    sf::InputSoundFile file;
+    if (!file.openFromFile(path)) return nullptr;
+    inMemory = fitsInMemory(file, preferMemory, memoryBudget);
+    std::unique_ptr<MusicSource> source(new MusicSource());
+    if (!source->open(path, getHeadDuration(file, inMemory))) return nullptr;
+    return source;
+}
+
+bool BgmPlayer::openNext(std::unique_ptr<MusicSource> source, const std::string& path, bool sourceInMemory) {
+    nextPath.clear();
+    if (!service.open(getNextChannel(), std::move(source), false)) return false;
+    nextPath = path;
+    nextInMemory = sourceInMemory;
+    return true;
+}
+
+void BgmPlayer::switchToNext(sf::Time fadeOut) {
+    service.stop(channel, fadeOut);
+    channel = getNextChannel();
+    openedPath = nextPath;
+    inMemory = nextInMemory;
+    nextPath.clear();
+}
+
+AudioChannel BgmPlayer::getNextChannel() const {
+    return channel == AudioChannel::BGM ? AudioChannel::BGM_SUB : AudioChannel::BGM;
+}
+
+void BgmPlayer::play() {
+    if (service.getStatus(channel) == sf::SoundSource::Paused) {
+        service.resume(channel);
+    } else {
+        service.play(channel);
+    }
+}
+
+void BgmPlayer::pause() {
+    service.pause(channel);
+}
+
+void BgmPlayer::stop() {
+    service.stop(channel);
+}
+
+void BgmPlayer::setVolume(float volume) {
+    service.setChannelVolume(AudioChannel::BGM, volume);
+    service.setChannelVolume(AudioChannel::BGM_SUB, volume);
+}
+
+void BgmPlayer::setGain(float decibels) {
+    service.setChannelGain(channel, decibels);
+}
+
+void BgmPlayer::setTicks(std::shared_ptr<const AssistTickTrack> ticks) {
+    service.setTicks(channel, ticks);
+    service.setTicks(getNextChannel(), nullptr);
+}
+
+sf::SoundSource::Status BgmPlayer::getStatus() const {
+    return service.getStatus(channel);
+}
+
+sf::Time BgmPlayer::getPlayingOffset() const {
+    return service.getPlayingOffset(channel);
+}
+
+sf::Time BgmPlayer::getDuration() const {
+    return service.getDuration(channel);
+}
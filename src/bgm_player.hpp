@@ -0,0 +1,54 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <memory>
+#include <string>
+#include "audio_streaming_service.hpp"
+
+// --- 曲のBGM再生 ---
+// ストリーミングサービスの BGM チャンネルを sf::Music と同じ感覚で扱うためのもの。
+// メモリ展開モードでは曲の開始時に全体をデコードしておき、再生位置がディスクの
+// 読み込み待ちに左右されないようにする。予算を超える長い曲はストリーミングに戻す。
+// コースでは次の曲をもう1本のチャンネル (BGM_SUB) に開いておき、曲が変わるときに入れ替える。
+class BgmPlayer {
+public:
+    explicit BgmPlayer(AudioStreamingService& service);
+
+    // inMemory でも PCM が memoryBudget バイトを超える場合はストリーミングで開く
+    bool open(const std::string& path, bool inMemory, size_t memoryBudget);
+    // 作ったソースを開く (ファイルの曲ではないので、次の open() では必ず開き直す)
+    bool open(std::unique_ptr<MusicSource> source);
+    // open() と同じ基準で開いたソースを作る (ワーカーで次の曲を用意するためのもの)
+    static std::unique_ptr<MusicSource> openSource(const std::string& path, bool preferMemory, size_t memoryBudget, bool& inMemory);
+
+    // openSource() で作ったソースを、鳴っていない方のチャンネルに割り当てておく
+    bool openNext(std::unique_ptr<MusicSource> source, const std::string& path, bool inMemory);
+    // 次の曲のチャンネルに切り替える。鳴っていた曲は fadeOut でフェードアウトする
+    void switchToNext(sf::Time fadeOut);
+    AudioChannel getChannel() const { return channel; }
+
+    // 一時停止中なら続きから、そうでなければ先頭から鳴らす
+    void play();
+    void pause();
+    void stop();
+    void setVolume(float volume);
+    // 曲ごとの音量の補正 (dB)。今のチャンネルに掛ける
+    void setGain(float decibels);
+    // アシストのクリック (null なら鳴らさない)。今のチャンネルに重ね、もう1本からは外す
+    void setTicks(std::shared_ptr<const AssistTickTrack> ticks);
+    sf::SoundSource::Status getStatus() const;
+    sf::Time getPlayingOffset() const;
+    sf::Time getDuration() const;
+
+    bool isInMemory() const { return inMemory; }
+
+private:
+    AudioChannel getNextChannel() const;
+
+    AudioStreamingService& service;
+    AudioChannel channel = AudioChannel::BGM;
+    std::string openedPath; // 同じ曲のリトライでは開き直さない
+    bool inMemory = false;
+    std::string nextPath;
+    bool nextInMemory = false;
+};
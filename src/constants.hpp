@@ -18,6 +18,129 @@ const float NOTE_PIXELS_PER_SECOND = 350.f; // ノーツの落下速度 (ピク
 const float PERFECT_WINDOW = 0.08f; // 秒 (±80ms)
 const float GREAT_WINDOW = 0.15f;  // 秒 (±150ms)
 
+// --- フレームペーシング ---
+const int DEFAULT_FRAME_RATE = 120;
+const std::vector<int> FRAME_RATE_PRESETS = {60, 120, 144, 240};
+const size_t FRAME_TIME_HISTORY_SIZE = 1024;                    // パーセンタイル計算に使うフレーム数
+const sf::Time FRAME_PACER_MIN_SPIN = sf::microseconds(500);    // 最低限スピンで待つ時間
+const sf::Time FRAME_PACER_MAX_SPIN = sf::milliseconds(4);
+const float FRAME_PACER_OVERSLEEP_DECAY = 0.99f;                // 寝過ごし量の最大値を毎フレーム減衰させる
+
+// 描画スレッド使用時にゲームスレッドが入力を見に行く間隔
+const sf::Time GAME_TICK_INTERVAL = sf::milliseconds(1);
+
+// --- 非同期読み込み ---
+const unsigned int MAX_WORKER_THREADS = 4;
+const unsigned int TEXTURE_UPLOAD_SLICE_ROWS = 64;               // 1回の転送で送る行数
+const sf::Time TEXTURE_UPLOAD_BUDGET = sf::milliseconds(2);      // 1フレームあたりの転送時間の上限
+const sf::Vector2u THUMBNAIL_SIZE(320, 180);                     // 曲リスト用のサムネイル
+
+// --- 動的解像度 ---
+const float MIN_RENDER_SCALE = 0.5f;  // ネイティブ解像度に対する最小倍率
+const float MAX_RENDER_SCALE = 1.0f;
+const float RENDER_SCALE_STEP = 0.1f;
+const float RENDER_SCALE_DOWN_THRESHOLD = 0.9f; // 平均フレーム時間が予算の90%を超えたら下げる
+const float RENDER_SCALE_UP_THRESHOLD = 0.6f;   // 予算の60%を下回ったら上げる
+const float FRAME_TIME_SMOOTHING = 0.1f;        // フレーム時間の指数移動平均の係数
+const sf::Time RENDER_SCALE_COOLDOWN = sf::seconds(0.5f);
+
+// --- 効果音ミキサー ---
+const unsigned int MIXER_SAMPLE_RATE = 44100;
+#if SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR >= 6
+const size_t SFX_MIXER_CHUNK_FRAMES = 256; // 約5.8ms
+#else
+const size_t SFX_MIXER_CHUNK_FRAMES = 512; // SFML 2.5 のストリームは10msごとにしか起きないので余裕を持たせる
+#endif
+const size_t SFX_VOICE_COUNT = 96;         // 同時発音数 (キー音の和音が重なっても足りるように)
+const size_t SFX_MAX_SAMPLES = 512;        // 固定の効果音 + 1曲分のキー音
+const size_t SFX_COMMAND_QUEUE_SIZE = 256;
+const long long KEYSOUND_SCHEDULE_LEAD = static_cast<long long>(SFX_MIXER_CHUNK_FRAMES); // キー音は1チャンク先に予約して揺れをなくす
+
+// --- BGM ---
+const sf::Time MUSIC_PRELOAD_HEAD = sf::seconds(3.f);        // 起動時にデコードしておく先頭の長さ
+const sf::Time MUSIC_CROSSFADE_TIME = sf::milliseconds(400);
+
+// --- 音楽ストリーミング ---
+const size_t AUDIO_STREAM_CHUNK_FRAMES = 1024;     // 出力1回分 (約23ms)
+const size_t AUDIO_BLOCK_FRAMES = 1024;            // デコードスレッドが1度に作るブロック
+const size_t AUDIO_CHANNEL_QUEUE_BLOCKS = 64;      // チャンネルごとのブロック数の上限 (約1.5秒)
+const sf::Time AUDIO_DECODE_AHEAD = sf::seconds(3.f); // 全チャンネルで分け合う先読み量
+const size_t AUDIO_MIN_DECODE_AHEAD_BLOCKS = 8;    // 鳴っているチャンネルが多くてもこれだけは先読みする
+const sf::Time AUDIO_DECODE_INTERVAL = sf::milliseconds(5);
+const size_t AUDIO_POSITION_HISTORY = 32;          // 再生位置の対応表 (出力チャンク数)
+const size_t AUDIO_COMMAND_QUEUE_SIZE = 64;
+const float AUDIO_LOAD_SMOOTHING = 0.05f;
+const size_t AUDIO_TAP_FRAMES = 16384;             // 解析用に残す出力の長さ (2のべき乗, 約0.37秒)
+const size_t AUDIO_OUTPUT_BUFFER_COUNT = 3;        // sf::SoundStream が回す出力バッファの数 (SFML 2.5/2.6)
+const long long AUDIO_POSITION_LEAK_FRAMES = 1;    // 再生位置の推定を出力チャンクごとに引き戻す量 (時計のずれをためない)
+
+// --- サンプルレートの変換 ---
+const int RESAMPLE_HALF_TAPS = 16;         // 窓付き sinc の片側の点数
+const int RESAMPLE_TABLE_RESOLUTION = 512; // 1入力フレームあたりの表の細かさ
+
+// --- 曲の開始 ---
+const sf::Time SONG_LEAD_IN = sf::seconds(2.f);         // 最低限のリードイン (カウントダウン)
+const sf::Time SONG_LEAD_IN_MARGIN = sf::seconds(0.5f); // 最初のノーツが画面上端から落ちてくる余裕
+const sf::Time SONG_CLOCK_RESYNC_THRESHOLD = sf::milliseconds(50); // これ以上ずれたら時計を合わせ直す
+const sf::Time SONG_CLOCK_CORRECTION_TIME = sf::milliseconds(500); // 小さなずれを吸収する時定数
+
+// --- コース ---
+const sf::Time COURSE_OUTRO_FADE = SONG_LEAD_IN; // 前の曲の残りを次の曲のリードインの間にフェードアウトする
+
+// --- 練習用の再生速度 ---
+const float PRACTICE_SPEED_MIN = 0.5f;
+const float PRACTICE_SPEED_MAX = 1.5f;
+const float PRACTICE_SPEED_STEP = 0.05f;
+const size_t TIME_STRETCH_HOP_FRAMES = 1024;   // 出力側の間隔。窓はこの2倍 (約46ms)
+const size_t TIME_STRETCH_SEARCH_FRAMES = 384; // 切り出し位置を探す範囲 (前後それぞれ)
+const int PRACTICE_SECTION_BARS = 8;           // マーカーのない譜面の練習区間の長さ
+const size_t PAUSE_MENU_SECTION_INDEX = 2;     // ポーズメニューの練習区間の項目
+
+// --- スペクトル表示 ---
+const size_t SPECTRUM_FFT_SIZE = 2048;          // 2のべき乗 (約46ms)
+const size_t SPECTRUM_BAND_COUNT = 48;
+const float SPECTRUM_MIN_FREQUENCY = 40.f;
+const float SPECTRUM_MAX_FREQUENCY = 16000.f;
+const float SPECTRUM_FLOOR_DB = -60.f;          // これ以下は0 (フルスケールの正弦波が1)
+const float SPECTRUM_ATTACK = 0.6f;             // 上がるときに1回で近づく割合
+const float SPECTRUM_RELEASE = 0.88f;           // 下がるときに1回で残る割合
+const sf::Time SPECTRUM_INTERVAL = sf::microseconds(16667); // 約60Hz
+
+// --- ラウドネスの正規化 ---
+const double LOUDNESS_TARGET = -16.0;    // LUFS。曲ごとにここへ寄せる
+const double LOUDNESS_MAX_BOOST = 6.0;   // dB。静かな曲を上げすぎて割れないように
+const double LOUDNESS_MAX_CUT = 12.0;    // dB
+
+// --- 選曲画面の試聴 ---
+const sf::Time SONG_PREVIEW_DELAY = sf::milliseconds(300);  // カーソルがこれだけ止まったらデコードを始める
+const sf::Time SONG_PREVIEW_LENGTH = sf::seconds(15.f);     // 試聴区間の長さ (これだけ先に展開してループする)
+const sf::Time SONG_PREVIEW_FADE = sf::milliseconds(500);
+
+// --- 遅延のキャリブレーション ---
+const sf::Time CALIBRATION_INTERVAL = sf::milliseconds(500); // クリックの間隔 (120BPM)
+const int CALIBRATION_COUNT_IN = 4;            // 最初の拍は聞くだけ (叩いても数えない)
+const int CALIBRATION_TAPS = 32;               // 叩いてもらうクリックの数
+const size_t CALIBRATION_MIN_TAPS = 12;        // 外れ値を除いてこれだけ残れば結果を出す
+const double CALIBRATION_OUTLIER_LIMIT = 3.0;  // 中央値からばらつき (MAD を標準偏差に直したもの) のこの倍より離れたら除く
+const double CALIBRATION_MIN_SPREAD = 0.002;   // 秒。打鍵がそろいすぎても外れ値の幅を0にしない
+
+// --- 譜面ごとのずれの学習 ---
+const double HIT_OFFSET_LEARNING_RATE = 0.05;  // 1打ごとに推定をばらつきのこの倍だけ動かす
+const double HIT_OFFSET_INITIAL_SPREAD = 0.015; // 秒。最初の打鍵のばらつきの見積もり
+const double HIT_OFFSET_MIN_SPREAD = 0.002;    // 秒。そろった打鍵が続いても歩幅を0にしない
+const long long HIT_OFFSET_MIN_HITS = 50;      // これだけ学習した譜面から補正に使う
+const double HIT_OFFSET_LIMIT = 0.05;          // 秒。補正はこの範囲に収める
+
+// --- リザルトの分析 ---
+const int TIMING_HISTOGRAM_BINS = 30; // ±GREAT_WINDOW を10msずつに分ける
+const sf::FloatRect RESULTS_HISTOGRAM_AREA(200.f, 720.f, 660.f, 160.f); // ずれのヒストグラム
+const sf::FloatRect RESULTS_TIMELINE_AREA(1060.f, 720.f, 660.f, 160.f); // 小節ごとの精度とずれ
+
+// --- 波形のピーク ---
+const unsigned int WAVEFORM_BASE_DIVISION = 128;  // 一番細かい段の1値あたりのフレーム数 (約2.9ms)
+const sf::FloatRect WAVEFORM_PREVIEW_AREA(160.f, WINDOW_HEIGHT - 140.f, WINDOW_WIDTH - 320.f, 100.f); // 難易度選択画面の波形
+const sf::Color WAVEFORM_PREVIEW_COLOR = sf::Color(100, 200, 255, 200);
+
 // --- 色の定義 ---
 const sf::Color LANE_COLOR_NORMAL = sf::Color(50, 50, 50, 128);
 const sf::Color LANE_COLOR_PRESSED = sf::Color(255, 255, 0, 180);
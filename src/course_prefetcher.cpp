@@ -0,0 +1,31 @@
+#include "course_prefetcher.hpp"
+#include "bgm_player.hpp"
+#include "file_utils.hpp"
+
+CoursePrefetcher::CoursePrefetcher(WorkerPool& pool)
+    : job(pool)
+{
+}
+
+void CoursePrefetcher::prepare(const SongData& song, const ChartData& chart, bool preferMemory, size_t memoryBudget) {
+    std::string audioPath = song.audioPath;
+    std::string chartPath = chart.chartPath;
+    double offset = chart.offset / 1000.0;
+    job.start([audioPath, chartPath, offset, preferMemory, memoryBudget](const BackgroundJob<PreparedSong>::CancelCheck&) {
+        std::unique_ptr<PreparedSong> prepared(new PreparedSong());
+        prepared->audioPath = audioPath;
+        prepared->source = BgmPlayer::openSource(audioPath, preferMemory, memoryBudget, prepared->inMemory);
+        if (prepared->source) {
+            prepared->chart = loadChartFromMidi(chartPath, &prepared->sections, offset, &prepared->beats);
+        }
+        return prepared;
+    });
+}
+
+std::unique_ptr<PreparedSong> CoursePrefetcher::take() {
+    return job.take();
+}
+
+void CoursePrefetcher::cancel() {
+    job.cancel();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "background_job.hpp"
+#include "music_source.hpp"
+#include "types.hpp"
+#include "worker_pool.hpp"
+
+// ワーカーで用意した次の曲 (source が null か chart が空なら失敗)
+struct PreparedSong
+{
+    std::unique_ptr<MusicSource> source;
+    std::string audioPath;
+    bool inMemory = false;
+    std::vector<Note> chart;
+    std::vector<ChartSection> sections;
+    std::vector<ChartBeat> beats;
+};
+
+// --- コースの次の曲の先読み ---
+// 曲を遊んでいる間に、次の曲の音声を開いて先頭 (メモリ展開なら全体) をデコードし、譜面も読み込んでおく。
+// 曲の切り替えでは take() で受け取ってチャンネルと譜面を差し替えるだけなので、1フレームもかからない。
+// 背景は ImageLoader がもともと非同期なので、ここでは扱わない。
+// prepare/take/cancel はメインスレッドから呼ぶ。
+class CoursePrefetcher {
+public:
+    explicit CoursePrefetcher(WorkerPool& pool);
+
+    // 前の準備を捨てて、song の chart の準備を始める
+    void prepare(const SongData& song, const ChartData& chart, bool preferMemory, size_t memoryBudget);
+    // 準備が済んでいれば取り出す (済んでいなければ null)
+    std::unique_ptr<PreparedSong> take();
+    void cancel();
+
+private:
+    BackgroundJob<PreparedSong> job;
+};
@@ -0,0 +1,109 @@
+#include "fft.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FFT_USE_SSE2 1
+#endif
+
+namespace {
+const double PI = 3.14159265358979323846;
+}
+
+Fft::Fft(size_t size)
+    : size(size),
+      bitReversed(size) {
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < size) ++bits;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned int reversed = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            if (i & (static_cast<size_t>(1) << b)) reversed |= 1u << (bits - 1 - b);
+        }
+        bitReversed[i] = reversed;
+    }
+
+    for (size_t half = 1; half < size; half *= 2) {
+        for (size_t k = 0; k < half; ++k) {
+            double angle = -PI * k / half;
+            twiddleReal.push_back(static_cast<float>(std::cos(angle)));
+            twiddleImag.push_back(static_cast<float>(std::sin(angle)));
+        }
+    }
+}
+
+std::vector<float> Fft::makeHannWindow() const {
+    std::vector<float> window(size);
+    for (size_t i = 0; i < size; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * i / size));
+    }
+    return window;
+}
+
+void Fft::transform(const float* input, float* re, float* im) const {
+    for (size_t i = 0; i < size; ++i) {
+        re[bitReversed[i]] = input[i];
+        im[bitReversed[i]] = 0.f;
+    }
+    butterflies(re, im);
+}
+
+void Fft::inverse(float* re, float* im) const {
+    // 共役をとって順方向に変換し、もう一度共役をとれば逆変換になる
+    for (size_t i = 0; i < size; ++i) {
+        size_t j = bitReversed[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (size_t i = 0; i < size; ++i) im[i] = -im[i];
+    butterflies(re, im);
+    const float scale = 1.f / size;
+    for (size_t i = 0; i < size; ++i) {
+        re[i] *= scale;
+        im[i] *= -scale;
+    }
+}
+
+void Fft::butterflies(float* re, float* im) const {
+    size_t twiddleOffset = 0;
+    for (size_t half = 1; half < size; half *= 2) {
+        const float* wr = &twiddleReal[twiddleOffset];
+        const float* wi = &twiddleImag[twiddleOffset];
+        for (size_t start = 0; start < size; start += half * 2) {
+            size_t k = 0;
+#ifdef FFT_USE_SSE2
+            // 段の半分が4以上なら4つのバタフライをまとめて計算する
+            for (; k + 4 <= half; k += 4) {
+                size_t top = start + k;
+                size_t bottom = top + half;
+                __m128 twr = _mm_loadu_ps(wr + k);
+                __m128 twi = _mm_loadu_ps(wi + k);
+                __m128 br = _mm_loadu_ps(re + bottom);
+                __m128 bi = _mm_loadu_ps(im + bottom);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(br, twr), _mm_mul_ps(bi, twi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(br, twi), _mm_mul_ps(bi, twr));
+                __m128 ar = _mm_loadu_ps(re + top);
+                __m128 ai = _mm_loadu_ps(im + top);
+                _mm_storeu_ps(re + top, _mm_add_ps(ar, tr));
+                _mm_storeu_ps(im + top, _mm_add_ps(ai, ti));
+                _mm_storeu_ps(re + bottom, _mm_sub_ps(ar, tr));
+                _mm_storeu_ps(im + bottom, _mm_sub_ps(ai, ti));
+            }
+#endif
+            for (; k < half; ++k) {
+                size_t top = start + k;
+                size_t bottom = top + half;
+                float tr = re[bottom] * wr[k] - im[bottom] * wi[k];
+                float ti = re[bottom] * wi[k] + im[bottom] * wr[k];
+                re[bottom] = re[top] - tr;
+                im[bottom] = im[top] - ti;
+                re[top] += tr;
+                im[top] += ti;
+            }
+        }
+        twiddleOffset += half;
+    }
+}
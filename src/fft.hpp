@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --- 高速フーリエ変換 ---
+// 長さが2のべき乗の実数列を変換する (基数2の時間間引き)。ビット反転と回転因子の表は
+// 作成時に用意し、変換中はメモリを確保しない。バタフライは SSE2 があれば4つずつまとめる。
+// transform() は const なので、1つのインスタンスを複数のスレッドから同時に使ってよい。
+class Fft {
+public:
+    explicit Fft(size_t size);
+
+    size_t getSize() const { return size; }
+
+    // input (size 個) を変換し、real, imag (それぞれ size 個) に周波数領域を書く
+    void transform(const float* input, float* real, float* imag) const;
+    // 周波数領域 (real, imag) をその場で時間領域に戻す。1/size の正規化も行う
+    void inverse(float* real, float* imag) const;
+
+    // 周期的なハン窓 (size 個)
+    std::vector<float> makeHannWindow() const;
+
+private:
+    // ビット反転の順に並んだ複素数列にバタフライを全段かける
+    void butterflies(float* real, float* imag) const;
+
+    size_t size;
+    std::vector<unsigned int> bitReversed;
+    std::vector<float> twiddleReal; // 段ごとに連続して並べる (段の半分の長さ m なら m 個)
+    std::vector<float> twiddleImag;
+};
@@ -2,8 +2,18 @@
 #include "constants.hpp"
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 #include "MidiFile.h"
 #include <algorithm>
+#include <array>
+#include <cstdio>
+#include <thread>
+#include <sys/stat.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <direct.h>
+#include <windows.h>
+#endif
 
 // --- ハイスコア関連のヘルパー関数 ---
 
@@ -12,6 +22,11 @@ std::string generateHighScoreKey(const SongData& song, const ChartData& chart) {
     return song.title + "-" + chart.difficultyName;
 }
 
+// コースは曲と同じ表に "course-" を付けて記録する
+std::string generateCourseHighScoreKey(const CourseData& course) {
+    return "course-" + course.title;
+}
+
 // scores.json からハイスコアを読み込む
 std::map<std::string, int> loadHighScores() {
     std::map<std::string, int> highScores;
@@ -60,6 +75,43 @@ GameConfig loadConfig() {
             if (configJson.contains("audio_offset")) {
                 config.audioOffset = configJson["audio_offset"].get<float>();
             }
+            if (configJson.contains("dynamic_resolution")) {
+                config.dynamicResolution = configJson["dynamic_resolution"].get<bool>();
+            }
+            if (configJson.contains("frame_rate")) {
+                config.frameRateLimit = configJson["frame_rate"].get<int>();
+            }
+            if (configJson.contains("vsync")) {
+                config.verticalSync = configJson["vsync"].get<bool>();
+            }
+            if (configJson.contains("render_thread")) {
+                config.renderThread = configJson["render_thread"].get<bool>();
+            }
+            if (configJson.contains("keysounds")) {
+                config.keysounds = configJson["keysounds"].get<bool>();
+            }
+            if (configJson.contains("bgm_in_memory")) {
+                config.bgmInMemory = configJson["bgm_in_memory"].get<bool>();
+            }
+            if (configJson.contains("bgm_memory_budget_mb")) {
+                config.bgmMemoryBudget = configJson["bgm_memory_budget_mb"].get<int>();
+            }
+            if (configJson.contains("loudness_normalization")) {
+                config.loudnessNormalization = configJson["loudness_normalization"].get<bool>();
+            }
+            if (configJson.contains("spectrum_visualizer")) {
+                config.spectrumVisualizer = configJson["spectrum_visualizer"].get<bool>();
+            }
+            if (configJson.contains("adaptive_offset")) {
+                config.adaptiveOffset = configJson["adaptive_offset"].get<bool>();
+            }
+            if (configJson.contains("assist_ticks")) {
+                std::string assistTicks = configJson["assist_ticks"].get<std::string>();
+                if (assistTicks == "beat") config.assistTicks = AssistTickMode::BEAT;
+                else if (assistTicks == "notes") config.assistTicks = AssistTickMode::NOTES;
+                else if (assistTicks == "both") config.assistTicks = AssistTickMode::BOTH;
+                else config.assistTicks = AssistTickMode::OFF;
+            }
         } catch (const json::parse_error& e) {
             // パースエラーが起きても、デフォルト設定でゲームを続行
         }
@@ -74,13 +126,25 @@ void saveConfig(const GameConfig& config) {
     configJson["bgm_volume"] = config.bgmVolume;
     configJson["sfx_volume"] = config.sfxVolume;
     configJson["audio_offset"] = config.audioOffset;
+    configJson["dynamic_resolution"] = config.dynamicResolution;
+    configJson["frame_rate"] = config.frameRateLimit;
+    configJson["vsync"] = config.verticalSync;
+    configJson["render_thread"] = config.renderThread;
+    configJson["keysounds"] = config.keysounds;
+    configJson["bgm_in_memory"] = config.bgmInMemory;
+    configJson["bgm_memory_budget_mb"] = config.bgmMemoryBudget;
+    configJson["spectrum_visualizer"] = config.spectrumVisualizer;
+    configJson["loudness_normalization"] = config.loudnessNormalization;
+    configJson["adaptive_offset"] = config.adaptiveOffset;
+    const char* assistTickNames[] = {"off", "beat", "notes", "both"};
+    configJson["assist_ticks"] = assistTickNames[static_cast<int>(config.assistTicks)];
     std::ofstream ofs("config.json");
     ofs << std::setw(4) << configJson << std::endl;
 }
 
 
 // --- 譜面読み込み関数 ---
-std::vector<Note> loadChartFromMidi(const std::string& path) {
+std::vector<Note> loadChartFromMidi(const std::string& path, std::vector<ChartSection>* sections, double offset, std::vector<ChartBeat>* beats) {
     smf::MidiFile midiFile;
     if (!midiFile.read(path)) {
         return {}; // 読み込み失敗
@@ -92,14 +156,37 @@ std::vector<Note> loadChartFromMidi(const std::string& path) {
     midiFile.joinTracks();
 
     std::vector<Note> chart;
+    std::vector<ChartSection> markers;
+    int beatsPerBar = 4, beatUnit = 4;
+    bool timeSignatureFound = false;
+    // 拍子の変化 (ティック, 拍子の分子, 分母)。拍の頭を求めるのに使う
+    std::vector<std::array<int, 3>> timeSignatures;
+    int lastTick = 0;
     // マージされたトラックは1つだけ (トラック0)
     if (midiFile.getTrackCount() > 0) {
         for (int event = 0; event < midiFile[0].size(); ++event) {
+            const smf::MidiMessage& message = midiFile[0][event];
+            if (message.isMarkerText()) {
+                markers.push_back({midiFile.getTimeInSeconds(0, event) + offset, message.getMetaContent()});
+            } else if (message.isTimeSignature()) {
+                int numerator = std::max(1, static_cast<int>(message[3]));
+                int denominator = 1 << std::min(6, static_cast<int>(message[4]));
+                timeSignatures.push_back({{midiFile[0][event].tick, numerator, denominator}});
+                if (!timeSignatureFound) {
+                    // 小節の区切りは最初の拍子で数える
+                    beatsPerBar = numerator;
+                    beatUnit = denominator;
+                    timeSignatureFound = true;
+                }
+            }
             if (midiFile[0][event].isNoteOn()) {
+                lastTick = midiFile[0][event].tick;
                 Note newNote;
                 // テンポチェンジを考慮した正確な秒数を取得
-                newNote.spawnTime = midiFile.getTimeInSeconds(0, event);
+                newNote.spawnTime = midiFile.getTimeInSeconds(0, event) + offset;
                 newNote.laneIndex = midiFile[0][event].getKeyNumber() % LANE_COUNT;
+                newNote.keyNumber = midiFile[0][event].getKeyNumber();
+                newNote.channel = midiFile[0][event].getChannel();
                 
                 newNote.shape.setSize(sf::Vector2f(LANE_WIDTH, NOTE_HEIGHT));
                 newNote.shape.setFillColor(sf::Color::Cyan);
@@ -115,5 +202,113 @@ std::vector<Note> loadChartFromMidi(const std::string& path) {
         return a.spawnTime < b.spawnTime;
     });
 
+    if (sections) {
+        sections->clear();
+        if (!markers.empty()) {
+            std::sort(markers.begin(), markers.end(), [](const ChartSection& a, const ChartSection& b) {
+                return a.startTime < b.startTime;
+            });
+            *sections = markers;
+        } else {
+            // マーカーがなければ PRACTICE_SECTION_BARS 小節ごとに区切る
+            int ticksPerSection = midiFile.getTicksPerQuarterNote() * 4 * beatsPerBar / beatUnit * PRACTICE_SECTION_BARS;
+            for (int tick = 0, bar = 1; ticksPerSection > 0 && tick <= lastTick; tick += ticksPerSection, bar += PRACTICE_SECTION_BARS) {
+                sections->push_back({midiFile.getTimeInSeconds(tick) + offset, "Bar " + std::to_string(bar)});
+            }
+        }
+        // オフセットで前にずれても、区間は曲の頭より前から始めない
+        for (auto& section : *sections) {
+            section.startTime = std::max(0.0, section.startTime);
+        }
+    }
+
+    if (beats) {
+        // 拍子が変わったところから小節を数え直す (拍子は小節の頭で変わるものとする)
+        beats->clear();
+        const int ticksPerQuarter = midiFile.getTicksPerQuarterNote();
+        size_t signatureIndex = 0;
+        int numerator = 4, denominator = 4, beatInBar = 0;
+        for (int tick = 0; ticksPerQuarter > 0; ) {
+            while (signatureIndex < timeSignatures.size() && timeSignatures[signatureIndex][0] <= tick) {
+                numerator = timeSignatures[signatureIndex][1];
+                denominator = timeSignatures[signatureIndex][2];
+                beatInBar = 0;
+                ++signatureIndex;
+            }
+            if (tick > lastTick && beatInBar == 0) break;
+            beats->push_back({midiFile.getTimeInSeconds(tick) + offset, beatInBar == 0});
+            tick += std::max(1, ticksPerQuarter * 4 / denominator);
+            beatInBar = (beatInBar + 1) % numerator;
+        }
+    }
+
     return chart;
 }
+
+
+// --- ファイル情報 ---
+
+bool getFileStamp(const std::string& path, FileStamp& stamp) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    stamp.modifiedTime = static_cast<long long>(info.st_mtime);
+    stamp.size = static_cast<long long>(info.st_size);
+    return true;
+}
+
+bool ensureDirectory(const std::string& path) {
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        std::string partial = path.substr(0, pos);
+#ifdef _WIN32
+        _mkdir(partial.c_str());
+#else
+        mkdir(partial.c_str(), 0755);
+#endif
+    }
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+}
+
+unsigned long long hashBytes(const void* data, size_t size, unsigned long long seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    unsigned long long hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string toHexString(unsigned long long value) {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << value;
+    return ss.str();
+}
+
+bool writeFileAtomically(const std::string& path, const std::function<bool(std::ostream&)>& write, bool binary) {
+    std::hash<std::thread::id> threadHash;
+    std::string temporaryPath = path + "." + std::to_string(threadHash(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream ofs(temporaryPath, binary ? std::ios::out | std::ios::binary : std::ios::out);
+        if (!ofs.is_open()) return false;
+        if (!write(ofs) || !ofs.flush()) {
+            ofs.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+    return replaceFile(temporaryPath, path);
+}
+
+bool replaceFile(const std::string& temporaryPath, const std::string& path) {
+#ifdef _WIN32
+    // rename は既存のファイルを上書きしないので、置き換えられる MoveFileEx を使う
+    bool replaced = MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool replaced = std::rename(temporaryPath.c_str(), path.c_str()) == 0; // POSIX の rename は上書きも不可分
+#endif
+    if (!replaced) std::remove(temporaryPath.c_str());
+    return replaced;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <map>
@@ -13,6 +15,7 @@ using json = nlohmann::json;
 
 // ハイスコア関連
 std::string generateHighScoreKey(const SongData& song, const ChartData& chart);
+std::string generateCourseHighScoreKey(const CourseData& course);
 std::map<std::string, int> loadHighScores();
 void saveHighScores(const std::map<std::string, int>& highScores);
 
@@ -21,4 +24,25 @@ GameConfig loadConfig();
 void saveConfig(const GameConfig& config);
 
 // 譜面読み込み
-std::vector<Note> loadChartFromMidi(const std::string& path);
+// sections を渡すと練習用の区間も同じ読み込みで作る。offset (秒) はノーツと区間の時刻に足す
+// beats を渡すとテンポマップと拍子から拍の頭の時刻も求める (最後のノーツの小節の終わりまで)
+std::vector<Note> loadChartFromMidi(const std::string& path, std::vector<ChartSection>* sections = nullptr, double offset = 0.0,
+                                    std::vector<ChartBeat>* beats = nullptr);
+
+// ファイル情報 (キャッシュの無効化判定に使う)
+struct FileStamp {
+    long long modifiedTime = 0; // UNIX時間 (秒)
+    long long size = 0;         // バイト
+};
+bool getFileStamp(const std::string& path, FileStamp& stamp);
+bool ensureDirectory(const std::string& path); // 途中のディレクトリもまとめて作る
+unsigned long long hashBytes(const void* data, size_t size, unsigned long long seed = 14695981039346656037ULL); // FNV-1a
+std::string toHexString(unsigned long long value);
+
+// 書きかけのファイルを読まれないよう、同じディレクトリの一時ファイルに write で書いてから path を置き換える。
+// 一時ファイルの名前はスレッドごとに分けるので、複数のワーカーが同じ path に書いてもぶつからない。
+// write が false を返すか書き込みに失敗したら、元のファイルはそのまま残して false を返す
+bool writeFileAtomically(const std::string& path, const std::function<bool(std::ostream&)>& write, bool binary = false);
+// 書き終えた temporaryPath で path を置き換える (途中で止まっても path は古いか新しいかのどちらか)。
+// 失敗したら temporaryPath を消して false を返す
+bool replaceFile(const std::string& temporaryPath, const std::string& path);
@@ -0,0 +1,127 @@
+#include "frame_pacer.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <thread>
+
+FramePacer::FramePacer()
+    : mode(Mode::LIMITED),
+      period(sf::seconds(1.f / DEFAULT_FRAME_RATE)),
+      spinMargin(FRAME_PACER_MIN_SPIN),
+      frameTimes(FRAME_TIME_HISTORY_SIZE, 0.f),
+      frameTimeCursor(0),
+      frameTimeCount(0)
+{
+    sortScratch.reserve(FRAME_TIME_HISTORY_SIZE);
+}
+
+void FramePacer::apply(sf::Window& window, int frameRateLimit, bool verticalSync) {
+    // SFML 側の sleep による制限は常に切り、待ち合わせはこちらで行う
+    window.setFramerateLimit(0);
+    window.setVerticalSyncEnabled(verticalSync);
+
+    if (verticalSync) {
+        mode = Mode::VSYNC;
+    } else if (frameRateLimit <= 0) {
+        mode = Mode::UNCAPPED;
+    } else {
+        mode = Mode::LIMITED;
+        period = sf::seconds(1.f / frameRateLimit);
+    }
+
+    nextDeadline = clock.getElapsedTime() + period;
+    lastFrameEnd = clock.getElapsedTime();
+    frameTimeCursor = 0;
+    frameTimeCount = 0;
+}
+
+void FramePacer::endFrame() {
+    if (mode == Mode::LIMITED) {
+        sf::Time now = clock.getElapsedTime();
+        if (now > nextDeadline + period) {
+            // ロードなどで大きく遅れたときは追いつこうとせず基準を取り直す
+            nextDeadline = now;
+        } else {
+            sf::Time sleepUntil = nextDeadline - spinMargin;
+            if (now < sleepUntil) {
+                sf::sleep(sleepUntil - now);
+
+                // 寝過ごした量を学習し、スピンで待つ区間をそれに合わせる
+                sf::Time oversleep = clock.getElapsedTime() - sleepUntil;
+                oversleepPeak = std::max(oversleep, oversleepPeak * FRAME_PACER_OVERSLEEP_DECAY);
+                spinMargin = std::min(FRAME_PACER_MAX_SPIN, std::max(FRAME_PACER_MIN_SPIN, oversleepPeak + FRAME_PACER_MIN_SPIN));
+            }
+            while (clock.getElapsedTime() < nextDeadline) {
+                std::this_thread::yield();
+            }
+        }
+        nextDeadline += period;
+    }
+
+    sf::Time frameEnd = clock.getElapsedTime();
+    recordFrameTime(frameEnd - lastFrameEnd);
+    lastFrameEnd = frameEnd;
+}
+
+sf::Time FramePacer::getFrameBudget() const {
+    if (mode == Mode::LIMITED) return period;
+    return sf::seconds(1.f / DEFAULT_FRAME_RATE);
+}
+
+FrameTimeStats FramePacer::getStats() const {
+    FrameTimeStats stats;
+    stats.sampleCount = frameTimeCount;
+    if (frameTimeCount == 0) return stats;
+
+    sortScratch.assign(frameTimes.begin(), frameTimes.begin() + frameTimeCount);
+    auto percentile = [this](float p) {
+        size_t index = static_cast<size_t>(p * (sortScratch.size() - 1));
+        std::nth_element(sortScratch.begin(), sortScratch.begin() + index, sortScratch.end());
+        return sortScratch[index];
+    };
+    stats.p50 = percentile(0.50f);
+    stats.p95 = percentile(0.95f);
+    stats.p99 = percentile(0.99f);
+    stats.max = *std::max_element(sortScratch.begin(), sortScratch.end());
+    return stats;
+}
+
+void FramePacer::recordFrameTime(sf::Time frameTime) {
+    frameTimes[frameTimeCursor] = frameTime.asMicroseconds() / 1000.f;
+    frameTimeCursor = (frameTimeCursor + 1) % frameTimes.size();
+    frameTimeCount = std::min(frameTimeCount + 1, frameTimes.size());
+}
+
+// --- オプション画面用のヘルパー ---
+
+int getFrameRateChoiceIndex(const GameConfig& config) {
+    const int presetCount = static_cast<int>(FRAME_RATE_PRESETS.size());
+    if (config.verticalSync) return presetCount;
+    if (config.frameRateLimit <= 0) return presetCount + 1;
+    for (int i = 0; i < presetCount; ++i) {
+        if (FRAME_RATE_PRESETS[i] >= config.frameRateLimit) return i;
+    }
+    return presetCount - 1;
+}
+
+void applyFrameRateChoice(GameConfig& config, int choiceIndex) {
+    const int presetCount = static_cast<int>(FRAME_RATE_PRESETS.size());
+    if (choiceIndex < presetCount) {
+        config.verticalSync = false;
+        config.frameRateLimit = FRAME_RATE_PRESETS[choiceIndex];
+    } else if (choiceIndex == presetCount) {
+        config.verticalSync = true;
+    } else {
+        config.verticalSync = false;
+        config.frameRateLimit = 0;
+    }
+}
+
+int getFrameRateChoiceCount() {
+    return static_cast<int>(FRAME_RATE_PRESETS.size()) + 2;
+}
+
+std::string getFrameRateChoiceLabel(const GameConfig& config) {
+    if (config.verticalSync) return "VSync";
+    if (config.frameRateLimit <= 0) return "Unlimited";
+    return std::to_string(config.frameRateLimit) + " FPS";
+}
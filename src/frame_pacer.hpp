@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// --- フレーム時間の統計 (ミリ秒) ---
+struct FrameTimeStats {
+    float p50 = 0.f;
+    float p95 = 0.f;
+    float p99 = 0.f;
+    float max = 0.f;
+    size_t sampleCount = 0;
+};
+
+// --- フレームペーサー ---
+// setFramerateLimit は sf::sleep だけで待つため 1-2ms 寝過ごすことがある。
+// ここでは期限の少し手前まで sleep し、残りをスピンで待つことで間隔を揃える。
+class FramePacer {
+public:
+    FramePacer();
+
+    // 設定をウィンドウに反映する (frameRateLimit が 0 なら無制限)
+    void apply(sf::Window& window, int frameRateLimit, bool verticalSync);
+
+    // window.display() の直後に毎フレーム呼ぶ
+    void endFrame();
+
+    // 1フレームに使える時間 (VSync・無制限のときは既定値)
+    sf::Time getFrameBudget() const;
+
+    // 直近のフレーム間隔のパーセンタイル
+    FrameTimeStats getStats() const;
+
+private:
+    enum class Mode {
+        LIMITED,
+        VSYNC,
+        UNCAPPED
+    };
+
+    void recordFrameTime(sf::Time frameTime);
+
+    Mode mode;
+    sf::Clock clock;        // リスタートしない単調時計
+    sf::Time period;        // LIMITED 時の目標フレーム間隔
+    sf::Time nextDeadline;
+    sf::Time lastFrameEnd;
+    sf::Time spinMargin;    // 期限の何秒前に sleep を切り上げるか
+    sf::Time oversleepPeak; // 観測した寝過ごし量 (減衰付きの最大値)
+
+    std::vector<float> frameTimes; // ミリ秒のリングバッファ
+    size_t frameTimeCursor;
+    size_t frameTimeCount;
+    mutable std::vector<float> sortScratch;
+};
+
+// --- オプション画面用のヘルパー ---
+// 60 / 120 / 144 / 240 / VSync / 無制限 を順番に切り替える
+int getFrameRateChoiceIndex(const GameConfig& config);
+void applyFrameRateChoice(GameConfig& config, int choiceIndex);
+int getFrameRateChoiceCount();
+std::string getFrameRateChoiceLabel(const GameConfig& config);
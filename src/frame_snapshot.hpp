@@ -0,0 +1,46 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "constants.hpp"
+#include "types.hpp"
+
+// --- 描画用のスナップショット ---
+// ゲームスレッドが毎フレーム作成し、描画側はこれだけを見て画面を組み立てる。
+// 描画中にゲームの状態が書き換わっても影響を受けない。
+
+struct NoteSnapshot {
+    int laneIndex;
+    float y;
+};
+
+struct ParticleSnapshot {
+    sf::Vector2f position;
+    float radius;
+    sf::Color color;
+};
+
+struct FrameSnapshot {
+    bool paused = false;
+    size_t selectedPauseMenuIndex = 0;
+    std::string practiceSectionLabel = "All"; // ポーズメニューの練習区間
+
+    std::vector<NoteSnapshot> notes;
+    std::vector<ParticleSnapshot> particles;
+    sf::Color laneColors[LANE_COUNT];
+
+    int score = 0;
+    int combo = 0;
+    float comboAnimationTime = 1.f; // 10コンボごとの演出からの経過秒
+
+    Judgment judgment = Judgment::NONE;
+    int judgmentLane = 0;
+    float judgmentTime = 1.f;       // 最後の判定からの経過秒
+
+    float hpRatio = 1.f;
+
+    float leadInRemaining = 0.f;    // 曲が鳴り始めるまでの秒数 (カウントダウン表示)
+
+    bool showSpectrum = false;
+    float spectrum[SPECTRUM_BAND_COUNT] = {}; // 帯域ごとの強さ (0-1)
+};
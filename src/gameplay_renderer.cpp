@@ -0,0 +1,274 @@
+#include "gameplay_renderer.hpp"
+#include "constants.hpp"
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+GameplayRenderer::GameplayRenderer()
+    : spectrumBars(sf::Quads, SPECTRUM_BAND_COUNT * 4),
+      lanes(LANE_COUNT)
+{
+}
+
+bool GameplayRenderer::load() {
+    if (!font.loadFromFile("Kazesawa-ExtraLight.ttf")) { return false; }
+    if (!scoreFont.loadFromFile("Evogria.otf")) { return false; }
+
+    renderScaler.create(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    // レーンと判定ライン
+    for (int i = 0; i < LANE_COUNT; ++i) {
+        lanes[i].setSize(sf::Vector2f(LANE_WIDTH - 2.f, WINDOW_HEIGHT));
+        lanes[i].setPosition(LANE_START_X + i * LANE_WIDTH, 0);
+        lanes[i].setOutlineColor(sf::Color::White);
+    }
+    judgmentLine.setSize(sf::Vector2f(LANE_AREA_WIDTH, 2.f));
+    judgmentLine.setPosition(LANE_START_X, JUDGMENT_LINE_Y);
+    judgmentLine.setFillColor(sf::Color::Red);
+
+    noteShape.setSize(sf::Vector2f(LANE_WIDTH, NOTE_HEIGHT));
+    noteShape.setFillColor(sf::Color::Cyan);
+
+    // HUD
+    scoreText.setFont(scoreFont);
+    scoreText.setCharacterSize(48); // 30 -> 48
+    scoreText.setPosition(20, 20); // 10, 10 -> 20, 20
+    scoreText.setOutlineColor(sf::Color::Black);
+    scoreText.setOutlineThickness(2.f);
+
+    comboText.setFont(font);
+    comboText.setCharacterSize(72); // 48 -> 72
+    judgmentText.setFont(font);
+    judgmentText.setCharacterSize(54); // 36 -> 54
+    countdownText.setFont(scoreFont);
+    countdownText.setCharacterSize(160);
+    countdownText.setOutlineColor(sf::Color::Black);
+    countdownText.setOutlineThickness(4.f);
+
+    // HPゲージ
+    hpGaugeBg.setSize(sf::Vector2f(300, 20));
+    hpGaugeBg.setFillColor(sf::Color(50, 50, 50));
+    hpGaugeBg.setOutlineColor(sf::Color::White);
+    hpGaugeBg.setOutlineThickness(2.f);
+    hpGaugeBg.setPosition(WINDOW_WIDTH - 320, 20);
+    hpGauge.setPosition(WINDOW_WIDTH - 320, 20);
+
+    // ポーズ画面
+    pauseOverlay.setSize(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
+    pauseOverlay.setFillColor(sf::Color(0, 0, 0, 150)); // 半透明の黒
+    pauseTitle.setFont(font);
+    pauseTitle.setCharacterSize(90); // 60 -> 90
+    pauseTitle.setString("PAUSED");
+    centerOrigin(pauseTitle);
+    pauseTitle.setPosition(WINDOW_WIDTH / 2.0f, 300.f); // 150 -> 300
+
+    std::vector<std::string> pauseMenuStrings = {"Continue", "Retry", "Section", "Back to Select"};
+    pauseMenuTexts.resize(pauseMenuStrings.size());
+    for(size_t i = 0; i < pauseMenuTexts.size(); ++i) {
+        pauseMenuTexts[i].setFont(font);
+        pauseMenuTexts[i].setCharacterSize(50); // 32 -> 50
+        pauseMenuTexts[i].setString(pauseMenuStrings[i]);
+        centerOrigin(pauseMenuTexts[i]);
+        pauseMenuTexts[i].setPosition(WINDOW_WIDTH / 2.0f, 500.f + i * 80.f); // 280, 60 -> 500, 80
+    }
+
+    // パフォーマンス表示
+    performanceText.setFont(font);
+    performanceText.setCharacterSize(24);
+    performanceText.setOutlineColor(sf::Color::Black);
+    performanceText.setOutlineThickness(1.f);
+    performanceText.setPosition(20, WINDOW_HEIGHT - 40);
+
+    return true;
+}
+
+void GameplayRenderer::applyConfig(const GameConfig& config, sf::Time frameBudget) {
+    renderScaler.setEnabled(config.dynamicResolution);
+    renderScaler.setTargetFrameTime(frameBudget);
+    frameRateLabel = getFrameRateChoiceLabel(config);
+}
+
+void GameplayRenderer::setBackground(const std::shared_ptr<AsyncTexture>& texture) {
+    background = texture;
+    backgroundSprite = sf::Sprite();
+}
+
+void GameplayRenderer::draw(sf::RenderTarget& target, const FrameSnapshot& snapshot) {
+    // シーンは可変解像度、HUDはネイティブ解像度で描画する
+    sf::RenderTarget& scene = renderScaler.beginScene(target);
+    if (background) {
+        background->bind(backgroundSprite);
+    }
+    scene.draw(backgroundSprite);
+    if (snapshot.showSpectrum) {
+        // 帯域ごとの棒を下から伸ばす。色は低音から高音へ青 -> 紫
+        const float barWidth = LANE_AREA_WIDTH / static_cast<float>(SPECTRUM_BAND_COUNT);
+        for (size_t b = 0; b < SPECTRUM_BAND_COUNT; ++b) {
+            float left = LANE_START_X + b * barWidth;
+            float right = left + barWidth - 2.f;
+            float top = WINDOW_HEIGHT - snapshot.spectrum[b] * WINDOW_HEIGHT * 0.6f;
+            float ratio = static_cast<float>(b) / SPECTRUM_BAND_COUNT;
+            sf::Color color(static_cast<sf::Uint8>(80 + 150 * ratio), 120, 255, static_cast<sf::Uint8>(60 + 100 * snapshot.spectrum[b]));
+            sf::Vertex* quad = &spectrumBars[b * 4];
+            quad[0] = sf::Vertex(sf::Vector2f(left, top), color);
+            quad[1] = sf::Vertex(sf::Vector2f(right, top), color);
+            quad[2] = sf::Vertex(sf::Vector2f(right, WINDOW_HEIGHT), color);
+            quad[3] = sf::Vertex(sf::Vector2f(left, WINDOW_HEIGHT), color);
+        }
+        scene.draw(spectrumBars);
+    }
+    for (int i = 0; i < LANE_COUNT; ++i) {
+        lanes[i].setFillColor(snapshot.laneColors[i]);
+        scene.draw(lanes[i]);
+    }
+    scene.draw(judgmentLine);
+    for (const auto& note : snapshot.notes) {
+        if (note.y > -NOTE_HEIGHT && note.y < WINDOW_HEIGHT) {
+            noteShape.setPosition(LANE_START_X + note.laneIndex * LANE_WIDTH, note.y);
+            scene.draw(noteShape);
+        }
+    }
+    for (const auto& p : snapshot.particles) {
+        particleShape.setRadius(p.radius);
+        particleShape.setFillColor(p.color);
+        particleShape.setPosition(p.position);
+        scene.draw(particleShape);
+    }
+    renderScaler.present(target);
+
+    scoreText.setString("Score: " + std::to_string(snapshot.score));
+    target.draw(scoreText);
+
+    if (snapshot.combo > 2) {
+        comboText.setString(std::to_string(snapshot.combo));
+        if (snapshot.combo >= 20) { // 100から変更
+            comboText.setFillColor(sf::Color::Magenta);
+            comboText.setCharacterSize(80); // 52 -> 80
+        } else if (snapshot.combo >= 10) { // 50から変更
+            comboText.setFillColor(sf::Color(255, 165, 0)); // Orange
+            comboText.setCharacterSize(76); // 48 -> 76
+        } else {
+            comboText.setFillColor(sf::Color::White);
+            comboText.setCharacterSize(72); // 44 -> 72
+        }
+        centerOrigin(comboText);
+        comboText.setPosition(LANE_START_X + LANE_AREA_WIDTH / 2.f, JUDGMENT_LINE_Y - 50.f);
+
+        // コンボテキストのアニメーション
+        const float comboAnimationDuration = 0.2f;
+        if (snapshot.comboAnimationTime < comboAnimationDuration) {
+            float scale = 1.5f - (0.5f * (snapshot.comboAnimationTime / comboAnimationDuration));
+            comboText.setScale(scale, scale);
+        } else {
+            comboText.setScale(1.0f, 1.0f);
+        }
+        target.draw(comboText);
+    }
+
+    if (snapshot.judgment != Judgment::NONE && snapshot.judgmentTime < 0.5f) {
+        if (snapshot.judgment == Judgment::PERFECT) {
+            judgmentText.setString("Perfect");
+            judgmentText.setFillColor(sf::Color::Cyan);
+        } else if (snapshot.judgment == Judgment::GREAT) {
+            judgmentText.setString("Great");
+            judgmentText.setFillColor(sf::Color::Yellow);
+        } else {
+            judgmentText.setString("Miss");
+            judgmentText.setFillColor(sf::Color::Red);
+        }
+        centerOrigin(judgmentText);
+        judgmentText.setPosition(LANE_START_X + snapshot.judgmentLane * LANE_WIDTH + LANE_WIDTH / 2.f, JUDGMENT_LINE_Y - 100.f);
+
+        // 判定テキストのアニメーション
+        const float animationDuration = 0.2f; // アニメーションの時間（秒）
+        if (snapshot.judgmentTime < animationDuration) {
+            float scale = 1.5f - (0.5f * (snapshot.judgmentTime / animationDuration));
+            judgmentText.setScale(scale, scale);
+        } else {
+            judgmentText.setScale(1.0f, 1.0f);
+        }
+        target.draw(judgmentText);
+    }
+
+    // リードインのカウントダウン (最後の3秒だけ数字を出す)
+    if (snapshot.leadInRemaining > 0.f && snapshot.leadInRemaining <= 3.f) {
+        int count = static_cast<int>(std::ceil(snapshot.leadInRemaining));
+        float fraction = snapshot.leadInRemaining - (count - 1); // 1 -> 0 で縮みながら消える
+        countdownText.setString(std::to_string(count));
+        countdownText.setFillColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(255 * fraction)));
+        centerOrigin(countdownText);
+        countdownText.setScale(0.8f + 0.4f * fraction, 0.8f + 0.4f * fraction);
+        countdownText.setPosition(LANE_START_X + LANE_AREA_WIDTH / 2.f, WINDOW_HEIGHT / 2.f);
+        target.draw(countdownText);
+    }
+
+    // HPゲージの更新
+    hpGauge.setSize(sf::Vector2f(300 * snapshot.hpRatio, 20));
+    if (snapshot.hpRatio > 0.5f) {
+        hpGauge.setFillColor(sf::Color::Green);
+    } else if (snapshot.hpRatio > 0.2f) {
+        hpGauge.setFillColor(sf::Color::Yellow);
+    } else {
+        hpGauge.setFillColor(sf::Color::Red);
+    }
+    target.draw(hpGaugeBg);
+    target.draw(hpGauge);
+
+    if (snapshot.paused) {
+        // オーバーレイとメニューを描画
+        target.draw(pauseOverlay);
+        target.draw(pauseTitle);
+        // 練習区間は左右キーで選ぶので今の値を出す
+        pauseMenuTexts[PAUSE_MENU_SECTION_INDEX].setString("< Section: " + snapshot.practiceSectionLabel + " >");
+        centerOrigin(pauseMenuTexts[PAUSE_MENU_SECTION_INDEX]);
+        for(size_t i = 0; i < pauseMenuTexts.size(); ++i) {
+            pauseMenuTexts[i].setFillColor(i == snapshot.selectedPauseMenuIndex ? sf::Color::Yellow : sf::Color::White);
+            target.draw(pauseMenuTexts[i]);
+        }
+    }
+}
+
+void GameplayRenderer::reportFrameTime(sf::Time frameTime) {
+    renderScaler.update(frameTime);
+}
+
+void GameplayRenderer::drawPerformanceOverlay(sf::RenderTarget& target, const FramePacer& pacer) {
+    // フレーム時間の統計 (0.25秒ごとに更新)
+    if (performanceTextClock.getElapsedTime() > sf::seconds(0.25f)) {
+        FrameTimeStats stats = pacer.getStats();
+        std::stringstream ss_perf;
+        ss_perf << std::fixed << std::setprecision(2)
+                << frameRateLabel
+                << "  p50 " << stats.p50 << "ms  p95 " << stats.p95
+                << "ms  p99 " << stats.p99 << "ms  max " << stats.max << "ms"
+                << "  scale " << renderScaler.getScale();
+        if (audioService) {
+            ss_perf << "  audio " << audioService->getMixLoad() * 100.f
+                    << "%  xrun " << audioService->getUnderrunCount()
+                    << "  out " << audioService->getOutputLatency().asSeconds() * 1000.f << "ms";
+        }
+        if (spectrumAnalyzer) {
+            ss_perf << "  fft " << spectrumAnalyzer->getAnalysisTime().asSeconds() * 1000.f << "ms";
+        }
+        performanceText.setString(ss_perf.str());
+        performanceTextClock.restart();
+    }
+    target.draw(performanceText);
+}
+
+void GameplayRenderer::setAudioService(const AudioStreamingService* service) {
+    audioService = service;
+}
+
+void GameplayRenderer::setSpectrumAnalyzer(const SpectrumAnalyzer* analyzer) {
+    spectrumAnalyzer = analyzer;
+}
+
+size_t GameplayRenderer::getPauseMenuItemCount() const {
+    return pauseMenuTexts.size();
+}
+
+void GameplayRenderer::centerOrigin(sf::Text& text) {
+    sf::FloatRect textRect = text.getLocalBounds();
+    text.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+}
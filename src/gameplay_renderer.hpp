@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "audio_streaming_service.hpp"
+#include "frame_snapshot.hpp"
+#include "frame_pacer.hpp"
+#include "image_loader.hpp"
+#include "render_scaler.hpp"
+#include "spectrum_analyzer.hpp"
+
+// --- ゲームプレイ画面 (ポーズ画面を含む) の描画 ---
+// 描画スレッドからも使うため、フォントや図形はすべて自前で持つ。
+// メインスレッドのテキストやフォントとは共有しない。
+class GameplayRenderer {
+public:
+    GameplayRenderer();
+
+    bool load();
+
+    // 設定の反映 (描画スレッドが止まっているときに呼ぶ)
+    void applyConfig(const GameConfig& config, sf::Time frameBudget);
+    void setBackground(const std::shared_ptr<AsyncTexture>& texture);
+    // 統計の表示にオーディオスレッドの負荷も載せる (読むのはアトミックな値だけ)
+    void setAudioService(const AudioStreamingService* service);
+    void setSpectrumAnalyzer(const SpectrumAnalyzer* analyzer);
+
+    void draw(sf::RenderTarget& target, const FrameSnapshot& snapshot);
+
+    // 描画にかかった時間を動的解像度に反映する
+    void reportFrameTime(sf::Time frameTime);
+
+    // F3 で表示するフレーム時間の統計
+    void drawPerformanceOverlay(sf::RenderTarget& target, const FramePacer& pacer);
+
+    size_t getPauseMenuItemCount() const;
+
+private:
+    void centerOrigin(sf::Text& text);
+
+    sf::Font font;
+    sf::Font scoreFont;
+
+    RenderScaler renderScaler;
+    std::string frameRateLabel;
+    const AudioStreamingService* audioService = nullptr;
+    const SpectrumAnalyzer* spectrumAnalyzer = nullptr;
+
+    std::shared_ptr<AsyncTexture> background; // 読み込み中の間は描画しない
+    sf::Sprite backgroundSprite;
+    sf::VertexArray spectrumBars; // レーンの後ろに1回の描画で出す
+    std::vector<sf::RectangleShape> lanes;
+    sf::RectangleShape judgmentLine;
+    sf::RectangleShape noteShape;
+    sf::CircleShape particleShape;
+
+    sf::Text scoreText;
+    sf::Text comboText;
+    sf::Text judgmentText;
+    sf::Text countdownText;
+    sf::RectangleShape hpGaugeBg;
+    sf::RectangleShape hpGauge;
+
+    sf::RectangleShape pauseOverlay;
+    sf::Text pauseTitle;
+    std::vector<sf::Text> pauseMenuTexts;
+
+    sf::Text performanceText;
+    sf::Clock performanceTextClock;
+};
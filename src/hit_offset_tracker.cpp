@@ -0,0 +1,101 @@
+#include "hit_offset_tracker.hpp"
+#include "constants.hpp"
+#include "file_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+// 筐体ごとに遅れが違うので、コンピュータ名で分ける
+std::string getDeviceName() {
+#ifdef _WIN32
+    const char* name = std::getenv("COMPUTERNAME");
+    if (name && *name) return name;
+#else
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) == 0 && name[0] != '\0') return name;
+#endif
+    return "default";
+}
+
+double roundMilliseconds(double seconds) {
+    return std::round(seconds * 100000.0) / 100.0;
+}
+}
+
+HitOffsetTracker::HitOffsetTracker(const std::string& path)
+    : path(path),
+      device(getDeviceName())
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) return;
+    try {
+        json trackerJson = json::parse(ifs);
+        for (auto deviceIt = trackerJson.begin(); deviceIt != trackerJson.end(); ++deviceIt) {
+            for (auto it = deviceIt.value().begin(); it != deviceIt.value().end(); ++it) {
+                Estimate estimate;
+                estimate.median = it.value().at("median_ms").get<double>() / 1000.0;
+                estimate.spread = it.value().at("spread_ms").get<double>() / 1000.0;
+                estimate.count = it.value().at("count").get<long long>();
+                devices[deviceIt.key()][it.key()] = estimate;
+            }
+        }
+    } catch (const json::exception& e) {
+        // 壊れていたら学習し直す
+        devices.clear();
+    }
+}
+
+void HitOffsetTracker::record(const std::string& chartKey, double error) {
+    Estimate& estimate = devices[device][chartKey];
+    if (estimate.count == 0) {
+        estimate.median = error;
+        estimate.spread = HIT_OFFSET_INITIAL_SPREAD;
+    } else {
+        double deviation = error - estimate.median;
+        // 中央値は向きだけを見て動かし、歩幅はばらつきに合わせる
+        double step = HIT_OFFSET_LEARNING_RATE * estimate.spread;
+        estimate.median += deviation > 0.0 ? step : (deviation < 0.0 ? -step : 0.0);
+        estimate.spread += HIT_OFFSET_LEARNING_RATE * (std::abs(deviation) - estimate.spread);
+        estimate.spread = std::max(estimate.spread, HIT_OFFSET_MIN_SPREAD);
+    }
+    ++estimate.count;
+    dirty = true;
+}
+
+bool HitOffsetTracker::getCorrection(const std::string& chartKey, double& correction) const {
+    auto deviceIt = devices.find(device);
+    if (deviceIt == devices.end()) return false;
+    auto it = deviceIt->second.find(chartKey);
+    if (it == deviceIt->second.end() || it->second.count < HIT_OFFSET_MIN_HITS) return false;
+    // 遅れて叩く譜面は判定の時刻を早める
+    correction = std::max(-HIT_OFFSET_LIMIT, std::min(HIT_OFFSET_LIMIT, -it->second.median));
+    return true;
+}
+
+void HitOffsetTracker::save() const {
+    if (!dirty) return;
+    json trackerJson = json::object();
+    for (const auto& deviceItem : devices) {
+        json charts = json::object();
+        for (const auto& item : deviceItem.second) {
+            charts[item.first] = {
+                {"median_ms", roundMilliseconds(item.second.median)},
+                {"spread_ms", roundMilliseconds(item.second.spread)},
+                {"count", item.second.count},
+            };
+        }
+        trackerJson[deviceItem.first] = charts;
+    }
+
+    bool written = writeFileAtomically(path, [&](std::ostream& os) {
+        os << std::setw(2) << trackerJson << std::endl;
+        return static_cast<bool>(os);
+    });
+    if (written) dirty = false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+// --- 譜面ごとの打鍵のずれの学習 ---
+// 判定したノーツごとに、符号付きのずれ (叩いた時刻 - ノーツの時刻、実時間) を記録し、
+// 譜面ごと・環境 (PC) ごとに指数重み付きの中央値として少しずつ推定する。
+// 1打ごとに推定を「ずれの向きに、ばらつきの HIT_OFFSET_LEARNING_RATE 倍」だけ動かすので、
+// 叩き損ねの大きなずれに引っ張られず、古い打鍵ほど効かなくなる。
+// ばらつきも絶対偏差の指数移動平均で同時に持つ。譜面ごとに持つのは数値3つだけ。
+//
+// 記録するのはこの補正を掛ける前のずれなので、補正を使っても推定が補正に追いかけられることはない。
+// 保存先は hit_offsets.json ({環境名: {譜面のキー: {...}}})。環境名はコンピュータ名。
+class HitOffsetTracker {
+public:
+    explicit HitOffsetTracker(const std::string& path = "hit_offsets.json");
+
+    // error は秒 (プラスが遅れ)
+    void record(const std::string& chartKey, double error);
+    // 補正に使えるだけ学習していれば、判定の時刻に足す補正 (秒) を返す
+    bool getCorrection(const std::string& chartKey, double& correction) const;
+    void save() const;
+
+private:
+    struct Estimate {
+        double median = 0.0; // 秒
+        double spread = 0.0; // 秒 (平均絶対偏差)
+        long long count = 0;
+    };
+
+    std::string path;
+    std::string device;
+    std::map<std::string, std::map<std::string, Estimate>> devices; // 他の環境の分も保存し直すために持つ
+    mutable bool dirty = false; // 保存していない学習がある
+};
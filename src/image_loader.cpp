@@ -0,0 +1,110 @@
+#include "image_loader.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <vector>
+
+// --- AsyncTexture ---
+
+AsyncTexture::AsyncTexture(const std::string& path, const sf::Vector2u& targetSize, const std::string& fallbackPath)
+    : path(path),
+      fallbackPath(fallbackPath),
+      targetSize(targetSize),
+      uploadedRows(0),
+      state(DECODING)
+{
+}
+
+bool AsyncTexture::isReady() const {
+    return state == READY;
+}
+
+bool AsyncTexture::hasFailed() const {
+    return state == FAILED;
+}
+
+const sf::Texture& AsyncTexture::getTexture() const {
+    return texture;
+}
+
+const std::string& AsyncTexture::getPath() const {
+    return path;
+}
+
+void AsyncTexture::bind(sf::Sprite& sprite) const {
+    if (isReady() && sprite.getTexture() != &texture) {
+        sprite.setTexture(texture, true);
+    }
+}
+
+// --- ImageLoader ---
+
+ImageLoader::ImageLoader(WorkerPool& pool, AssetCache& assetCache)
+    : pool(pool),
+      assetCache(assetCache),
+      uploadQueue(std::make_shared<UploadQueue>())
+{
+}
+
+std::shared_ptr<AsyncTexture> ImageLoader::load(const std::string& path, const sf::Vector2u& targetSize,
+                                                const std::string& fallbackPath) {
+    auto texture = std::make_shared<AsyncTexture>(path, targetSize, fallbackPath);
+    std::shared_ptr<UploadQueue> queue = uploadQueue;
+    AssetCache* cache = &assetCache;
+    pool.submit([texture, queue, cache]() {
+        // 誰も参照していなければ (曲選択で素通りされた等) デコードしない
+        if (texture.use_count() == 1) return;
+
+        decode(*texture, *cache);
+        if (texture->state == AsyncTexture::FAILED) return;
+
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->textures.push_back(texture);
+    });
+    return texture;
+}
+
+void ImageLoader::pumpUploads(sf::Time budget) {
+    sf::Clock clock;
+    while (clock.getElapsedTime() < budget) {
+        std::shared_ptr<AsyncTexture> texture;
+        {
+            std::lock_guard<std::mutex> lock(uploadQueue->mutex);
+            if (uploadQueue->textures.empty()) return;
+            texture = uploadQueue->textures.front();
+        }
+
+        bool abandoned = texture.use_count() <= 2; // キューとここだけが持っている
+        sf::Vector2u size = texture->image.getSize();
+        if (!abandoned && texture->uploadedRows == 0) {
+            if (!texture->texture.create(size.x, size.y)) {
+                texture->state = AsyncTexture::FAILED;
+                abandoned = true;
+            }
+        }
+
+        if (!abandoned) {
+            // 1回の転送量を抑え、フレームの予算を超えたら次のフレームに回す
+            unsigned int rows = std::min(TEXTURE_UPLOAD_SLICE_ROWS, size.y - texture->uploadedRows);
+            const sf::Uint8* pixels = texture->image.getPixelsPtr() + static_cast<size_t>(texture->uploadedRows) * size.x * 4;
+            texture->texture.update(pixels, size.x, rows, 0, texture->uploadedRows);
+            texture->uploadedRows += rows;
+            if (texture->uploadedRows < size.y) continue;
+
+            texture->texture.setSmooth(true);
+            texture->image = sf::Image();
+            texture->state = AsyncTexture::READY;
+        }
+
+        std::lock_guard<std::mutex> lock(uploadQueue->mutex);
+        uploadQueue->textures.pop_front();
+    }
+}
+
+void ImageLoader::decode(AsyncTexture& texture, AssetCache& assetCache) {
+    if (!assetCache.loadImage(texture.path, texture.targetSize, texture.image) &&
+        (texture.fallbackPath.empty() || !assetCache.loadImage(texture.fallbackPath, texture.targetSize, texture.image))) {
+        texture.state = AsyncTexture::FAILED;
+        return;
+    }
+    texture.state = AsyncTexture::UPLOADING;
+}
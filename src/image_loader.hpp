@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "asset_cache.hpp"
+#include "worker_pool.hpp"
+
+// --- 非同期に読み込まれるテクスチャ ---
+// ワーカーでデコード・縮小し、描画側のスレッドで少しずつ GPU に転送する。
+// 準備ができるまでは isReady() が false を返すので、その間は描画しない。
+class AsyncTexture {
+public:
+    AsyncTexture(const std::string& path, const sf::Vector2u& targetSize, const std::string& fallbackPath);
+
+    bool isReady() const;
+    bool hasFailed() const;
+    const sf::Texture& getTexture() const;
+    const std::string& getPath() const;
+
+    // 準備ができていればスプライトにテクスチャを設定する (描画側のスレッドで呼ぶ)
+    void bind(sf::Sprite& sprite) const;
+
+private:
+    friend class ImageLoader;
+
+    enum State {
+        DECODING,
+        UPLOADING,
+        READY,
+        FAILED
+    };
+
+    std::string path;
+    std::string fallbackPath;
+    sf::Vector2u targetSize;
+    sf::Image image;          // デコード済みの画像 (転送が終わったら解放する)
+    sf::Texture texture;
+    unsigned int uploadedRows;
+    std::atomic<int> state;
+};
+
+// --- 画像読み込みサービス ---
+// 縮小済みの画像は AssetCache から読むので、2回目以降は JPEG をデコードしない。
+class ImageLoader {
+public:
+    ImageLoader(WorkerPool& pool, AssetCache& assetCache);
+
+    // path をワーカーでデコードし、targetSize を覆う大きさまで縮小する。
+    // 読めなかった場合は fallbackPath を試す
+    std::shared_ptr<AsyncTexture> load(const std::string& path, const sf::Vector2u& targetSize,
+                                       const std::string& fallbackPath = "");
+
+    // デコード済みの画像を budget の時間内で GPU に転送する (描画側のスレッドで毎フレーム呼ぶ)
+    void pumpUploads(sf::Time budget);
+
+private:
+    // ジョブがローダーより長生きしても安全なように共有で持つ
+    struct UploadQueue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<AsyncTexture>> textures;
+    };
+
+    static void decode(AsyncTexture& texture, AssetCache& assetCache);
+
+    WorkerPool& pool;
+    AssetCache& assetCache;
+    std::shared_ptr<UploadQueue> uploadQueue;
+};
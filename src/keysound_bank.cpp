@@ -0,0 +1,87 @@
+#include "keysound_bank.hpp"
+#include <map>
+
+namespace {
+const int MIDI_KEY_COUNT = 128;
+const int MIDI_CHANNEL_COUNT = 16;
+
+// キーとチャンネルの両方を指定したものを最優先し、次にキーだけ、チャンネルだけの順で選ぶ
+int getMatchPriority(const KeysoundMapping& mapping, int keyNumber, int channel) {
+    bool keyMatches = mapping.keyNumber < 0 || mapping.keyNumber == keyNumber;
+    bool channelMatches = mapping.channel < 0 || mapping.channel == channel;
+    if (!keyMatches || !channelMatches) return -1;
+    return (mapping.keyNumber >= 0 ? 2 : 0) + (mapping.channel >= 0 ? 1 : 0);
+}
+}
+
+size_t KeysoundBank::load(const SongData& song, std::vector<Note>& chart, SfxMixer& mixer) {
+    unload(mixer);
+    for (auto& note : chart) {
+        note.keysound = -1;
+    }
+    if (song.keysounds.empty()) return 0;
+
+    // 同じファイルは一度だけ読み込む
+    std::map<std::string, SfxMixer::SampleId> loadedSamples;
+    std::vector<int> mappingEntries(song.keysounds.size(), -1);
+    for (size_t i = 0; i < song.keysounds.size(); ++i) {
+        const KeysoundMapping& mapping = song.keysounds[i];
+        auto it = loadedSamples.find(mapping.samplePath);
+        SfxMixer::SampleId sample;
+        if (it != loadedSamples.end()) {
+            sample = it->second;
+        } else {
+            sample = mixer.loadSample(mapping.samplePath);
+            loadedSamples[mapping.samplePath] = sample;
+            if (sample >= 0 && firstSample < 0) firstSample = sample;
+        }
+        if (sample < 0) continue; // 読めないサンプルの対応は無視してタップ音にする
+
+        Entry entry;
+        entry.sample = sample;
+        entry.gain = mapping.gain;
+        mappingEntries[i] = static_cast<int>(entries.size());
+        entries.push_back(entry);
+    }
+
+    // (チャンネル, キー) ごとの割り当て表を先に作り、ノーツごとの検索をなくす
+    std::vector<int> table(MIDI_CHANNEL_COUNT * MIDI_KEY_COUNT, -1);
+    for (int channel = 0; channel < MIDI_CHANNEL_COUNT; ++channel) {
+        for (int key = 0; key < MIDI_KEY_COUNT; ++key) {
+            int bestPriority = -1;
+            for (size_t i = 0; i < song.keysounds.size(); ++i) {
+                if (mappingEntries[i] < 0) continue;
+                int priority = getMatchPriority(song.keysounds[i], key, channel);
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    table[channel * MIDI_KEY_COUNT + key] = mappingEntries[i];
+                }
+            }
+        }
+    }
+
+    size_t assignedCount = 0;
+    for (auto& note : chart) {
+        if (note.channel < 0 || note.channel >= MIDI_CHANNEL_COUNT) continue;
+        if (note.keyNumber < 0 || note.keyNumber >= MIDI_KEY_COUNT) continue;
+        note.keysound = table[note.channel * MIDI_KEY_COUNT + note.keyNumber];
+        if (note.keysound >= 0) ++assignedCount;
+    }
+    return assignedCount;
+}
+
+void KeysoundBank::unload(SfxMixer& mixer) {
+    if (firstSample >= 0) {
+        mixer.unloadSamplesFrom(firstSample);
+    }
+    firstSample = -1;
+    entries.clear();
+}
+
+bool KeysoundBank::play(SfxMixer& mixer, const Note& note) const {
+    if (note.keysound < 0 || note.keysound >= static_cast<int>(entries.size())) return false;
+    const Entry& entry = entries[note.keysound];
+    // 即時に鳴らすとチャンク境界まで待たされる分だけ遅れが揺れるので、一定の遅れで予約する
+    mixer.triggerAt(entry.sample, entry.gain, mixer.getMixFrame() + KEYSOUND_SCHEDULE_LEAD);
+    return true;
+}
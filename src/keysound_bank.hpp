@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "sfx_mixer.hpp"
+#include "types.hpp"
+
+// --- キー音バンク ---
+// songs.json の "keysounds" に書かれたサンプルを曲ごとにミキサーへ読み込み、
+// 譜面の各ノーツに (キー番号, チャンネル) から鳴らすサンプルを割り当てる。
+// 割り当ては読み込み時に済ませるので、判定時は表を引いてミキサーに予約するだけ。
+class KeysoundBank {
+public:
+    // 前の曲のキー音を破棄してから読み込む。割り当てたノーツの数を返す
+    size_t load(const SongData& song, std::vector<Note>& chart, SfxMixer& mixer);
+    void unload(SfxMixer& mixer);
+
+    // ノーツにキー音があれば鳴らして true を返す
+    bool play(SfxMixer& mixer, const Note& note) const;
+
+private:
+    struct Entry {
+        SfxMixer::SampleId sample;
+        float gain;
+    };
+
+    // キー音はミキサーで最後に読み込むサンプル群なので、先頭の ID から後ろをまとめて捨てる
+    SfxMixer::SampleId firstSample = -1;
+    std::vector<Entry> entries; // Note::keysound の参照先
+};
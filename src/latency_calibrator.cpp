@@ -0,0 +1,66 @@
+#include "latency_calibrator.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double MAD_TO_SIGMA = 1.4826; // 正規分布なら MAD をこの倍にすると標準偏差になる
+
+double getMedian(std::vector<double> values) {
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    double median = values[middle];
+    if (values.size() % 2 == 0) {
+        median = (median + *std::max_element(values.begin(), values.begin() + middle)) * 0.5;
+    }
+    return median;
+}
+}
+
+std::vector<ChartBeat> LatencyCalibrator::getBeats() const {
+    std::vector<ChartBeat> beats;
+    const double interval = CALIBRATION_INTERVAL.asSeconds();
+    for (int i = 0; i < CALIBRATION_COUNT_IN + CALIBRATION_TAPS; ++i) {
+        beats.push_back({i * interval, i % 4 == 0});
+    }
+    return beats;
+}
+
+double LatencyCalibrator::getEndTime() const {
+    return (CALIBRATION_COUNT_IN + CALIBRATION_TAPS) * static_cast<double>(CALIBRATION_INTERVAL.asSeconds());
+}
+
+bool LatencyCalibrator::addTap(double time) {
+    const double interval = CALIBRATION_INTERVAL.asSeconds();
+    long long beat = std::llround(time / interval);
+    if (beat < CALIBRATION_COUNT_IN || beat >= CALIBRATION_COUNT_IN + CALIBRATION_TAPS) return false;
+    errors.push_back(time - beat * interval);
+    return true;
+}
+
+LatencyCalibrator::Result LatencyCalibrator::compute() const {
+    Result result;
+    if (errors.empty()) return result;
+
+    const double median = getMedian(errors);
+    std::vector<double> deviations;
+    for (double error : errors) deviations.push_back(std::abs(error - median));
+    const double sigma = std::max(CALIBRATION_MIN_SPREAD, getMedian(deviations) * MAD_TO_SIGMA);
+
+    std::vector<double> inliers;
+    for (double error : errors) {
+        if (std::abs(error - median) <= sigma * CALIBRATION_OUTLIER_LIMIT) inliers.push_back(error);
+    }
+    result.used = inliers.size();
+    result.rejected = errors.size() - inliers.size();
+    if (inliers.size() < CALIBRATION_MIN_TAPS) return result;
+
+    const double inlierMedian = getMedian(inliers);
+    deviations.clear();
+    for (double error : inliers) deviations.push_back(std::abs(error - inlierMedian));
+    // 遅れて叩いていたら判定の時刻を早める (musicTime = 曲の時刻 + audio_offset)
+    result.offset = static_cast<float>(-inlierMedian * 1000.0);
+    result.spread = static_cast<float>(getMedian(deviations) * MAD_TO_SIGMA * 1000.0);
+    result.valid = true;
+    return result;
+}
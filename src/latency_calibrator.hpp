@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <vector>
+#include "types.hpp"
+
+// --- 遅延のキャリブレーション ---
+// 一定間隔のクリックに合わせてレーンのキーを叩いてもらい、叩いた時刻とクリックの時刻の差から
+// audio_offset を求める。叩いた時刻はゲームプレイの判定と同じく、キーのイベントを処理した時点の
+// 曲の時計で取るので、音が出るまでの遅れと入力の遅れ (と叩く人の癖) がまとめて補正される。
+// ノーツの表示も同じ audio_offset で動くので、見た目用の値は別に持たない。
+//
+// 叩き損ねや2度打ちに引っ張られないよう平均は使わない。差の中央値と中央絶対偏差 (MAD) を求め、
+// 中央値から MAD を標準偏差に直した値の CALIBRATION_OUTLIER_LIMIT 倍より離れた打鍵を除いて、
+// 残りの中央値を結果にする。
+class LatencyCalibrator {
+public:
+    struct Result {
+        bool valid = false;  // 残った打鍵が CALIBRATION_MIN_TAPS に満たなければ false
+        float offset = 0.f;  // ms。audio_offset にそのまま入れる値
+        float spread = 0.f;  // ms。残った打鍵のばらつき (MAD を標準偏差に直したもの)
+        size_t used = 0;
+        size_t rejected = 0;
+    };
+
+    void reset() { errors.clear(); }
+
+    // 鳴らすクリック。曲の時刻0から CALIBRATION_INTERVAL ごと (最初の CALIBRATION_COUNT_IN 拍は聞くだけ)
+    std::vector<ChartBeat> getBeats() const;
+    // 最後のクリックから1拍おいた時刻 (秒)。ここまで鳴らしたら終わる
+    double getEndTime() const;
+
+    // 曲の時計で time (秒) に叩いた。叩く対象のクリックの近くでなければ数えず false を返す
+    bool addTap(double time);
+    size_t getTapCount() const { return errors.size(); }
+    // 最後に数えた打鍵のずれ (ms、プラスは遅れ)
+    float getLastError() const { return errors.empty() ? 0.f : static_cast<float>(errors.back() * 1000.0); }
+
+    Result compute() const;
+
+private:
+    std::vector<double> errors; // 秒 (叩いた時刻 - 一番近いクリックの時刻)
+};
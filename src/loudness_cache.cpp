@@ -0,0 +1,204 @@
+#include "loudness_cache.hpp"
+#include "constants.hpp"
+#include "file_utils.hpp"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+const double PI = 3.14159265358979323846;
+const double ABSOLUTE_GATE = -70.0; // LUFS
+const double RELATIVE_GATE = -10.0; // LU
+const size_t SUB_BLOCKS_PER_BLOCK = 4; // 100ms ずつずらした 400ms のブロック
+
+// 双2次フィルタ (直接形II転置)
+struct Biquad {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double z1 = 0.0, z2 = 0.0;
+
+    double process(double x) {
+        double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+};
+
+// BS.1770 のK特性 (頭の影響を表す高域のシェルフ + 低域を切るハイパス) を任意のサンプルレートで作る
+void makeKWeighting(unsigned int sampleRate, Biquad& shelf, Biquad& highPass) {
+    {
+        const double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+        double k = std::tan(PI * f0 / sampleRate);
+        double vh = std::pow(10.0, gain / 20.0);
+        double vb = std::pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        double k = std::tan(PI * f0 / sampleRate);
+        double a0 = 1.0 + k / q + k * k;
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+}
+
+double toLoudness(double meanSquare) {
+    return -0.691 + 10.0 * std::log10(meanSquare);
+}
+}
+
+bool measureIntegratedLoudness(const std::string& audioPath, double& loudness) {
+    sf::InputSoundFile file;
+    if (!file.openFromFile(audioPath)) return false;
+    const unsigned int channelCount = file.getChannelCount();
+    const unsigned int sampleRate = file.getSampleRate();
+    if (channelCount == 0 || sampleRate == 0) return false;
+
+    // 各チャンネルの重みは L/R/C と同じ 1.0 (サラウンドの曲は扱わない)
+    std::vector<Biquad> shelves(channelCount), highPasses(channelCount);
+    for (unsigned int c = 0; c < channelCount; ++c) makeKWeighting(sampleRate, shelves[c], highPasses[c]);
+
+    // 100ms ごとの二乗和 (全チャンネルの合計) を溜め、400ms のブロックはそれを4つ足して作る
+    const size_t subBlockFrames = sampleRate / 10;
+    std::vector<double> subBlocks;
+    double sum = 0.0;
+    size_t framesInSubBlock = 0;
+
+    std::vector<sf::Int16> samples(static_cast<size_t>(subBlockFrames) * channelCount);
+    for (;;) {
+        size_t count = static_cast<size_t>(file.read(samples.data(), samples.size()));
+        if (count == 0) break;
+        for (size_t i = 0; i + channelCount <= count; i += channelCount) {
+            for (unsigned int c = 0; c < channelCount; ++c) {
+                double value = highPasses[c].process(shelves[c].process(samples[i + c] / 32768.0));
+                sum += value * value;
+            }
+            if (++framesInSubBlock == subBlockFrames) {
+                subBlocks.push_back(sum);
+                sum = 0.0;
+                framesInSubBlock = 0;
+            }
+        }
+    }
+    if (subBlocks.size() < SUB_BLOCKS_PER_BLOCK) return false;
+
+    std::vector<double> blocks; // 各ブロックの平均二乗 (チャンネルの合計)
+    blocks.reserve(subBlocks.size() - SUB_BLOCKS_PER_BLOCK + 1);
+    for (size_t i = 0; i + SUB_BLOCKS_PER_BLOCK <= subBlocks.size(); ++i) {
+        double blockSum = 0.0;
+        for (size_t j = 0; j < SUB_BLOCKS_PER_BLOCK; ++j) blockSum += subBlocks[i + j];
+        blocks.push_back(blockSum / (subBlockFrames * SUB_BLOCKS_PER_BLOCK));
+    }
+
+    // 絶対ゲートを通ったブロックの平均から相対ゲートを決め、両方を通ったブロックで平均する
+    double gatedSum = 0.0;
+    size_t gatedCount = 0;
+    for (double block : blocks) {
+        if (block > 0.0 && toLoudness(block) > ABSOLUTE_GATE) {
+            gatedSum += block;
+            ++gatedCount;
+        }
+    }
+    if (gatedCount == 0) return false;
+    const double relativeGate = toLoudness(gatedSum / gatedCount) + RELATIVE_GATE;
+
+    gatedSum = 0.0;
+    gatedCount = 0;
+    for (double block : blocks) {
+        if (block > 0.0) {
+            double blockLoudness = toLoudness(block);
+            if (blockLoudness > ABSOLUTE_GATE && blockLoudness > relativeGate) {
+                gatedSum += block;
+                ++gatedCount;
+            }
+        }
+    }
+    if (gatedCount == 0) return false;
+    loudness = toLoudness(gatedSum / gatedCount);
+    return true;
+}
+
+float getLoudnessGain(double loudness) {
+    double gain = LOUDNESS_TARGET - loudness;
+    return static_cast<float>(std::max(-LOUDNESS_MAX_CUT, std::min(LOUDNESS_MAX_BOOST, gain)));
+}
+
+// --- LoudnessCache ---
+
+LoudnessCache::LoudnessCache(const std::string& path)
+    : path(path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) return;
+    try {
+        json cacheJson = json::parse(ifs);
+        for (auto it = cacheJson.begin(); it != cacheJson.end(); ++it) {
+            Entry entry;
+            entry.modifiedTime = it.value().at("modified").get<long long>();
+            entry.size = it.value().at("size").get<long long>();
+            entry.loudness = it.value().at("loudness").get<double>();
+            entries[it.key()] = entry;
+        }
+    } catch (const json::exception& e) {
+        // 壊れていたら作り直す
+        entries.clear();
+    }
+}
+
+void LoudnessCache::analyze(const std::string& audioPath) {
+    FileStamp stamp;
+    if (!getFileStamp(audioPath, stamp)) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(audioPath);
+        if (it != entries.end() && it->second.modifiedTime == stamp.modifiedTime && it->second.size == stamp.size) return;
+    }
+
+    // デコードはロックの外で行う (同じ曲を2つのスレッドが測っても結果は同じ)
+    Entry entry;
+    entry.modifiedTime = stamp.modifiedTime;
+    entry.size = stamp.size;
+    if (!measureIntegratedLoudness(audioPath, entry.loudness)) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[audioPath] = entry;
+    save();
+}
+
+bool LoudnessCache::lookup(const std::string& audioPath, double& loudness) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(audioPath);
+    if (it == entries.end()) return false;
+    loudness = it->second.loudness;
+    return true;
+}
+
+void LoudnessCache::save() const {
+    std::string directory = path.substr(0, path.find_last_of("/\\"));
+    if (directory != path && !ensureDirectory(directory)) return;
+
+    json cacheJson = json::object();
+    for (const auto& item : entries) {
+        cacheJson[item.first] = {
+            {"modified", item.second.modifiedTime},
+            {"size", item.second.size},
+            {"loudness", std::round(item.second.loudness * 100.0) / 100.0},
+        };
+    }
+
+    writeFileAtomically(path, [&](std::ostream& os) {
+        os << std::setw(2) << cacheJson << std::endl;
+        return static_cast<bool>(os);
+    });
+}
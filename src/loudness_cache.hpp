@@ -0,0 +1,41 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+// 曲全体の統合ラウドネス (LUFS) を EBU R128 / ITU-R BS.1770 の方法で測る。
+// K特性のフィルタを通した400msのブロック (75%重ね) を -70 LUFS の絶対ゲートと -10 LU の相対ゲートで選んで平均する。
+// ファイルは少しずつデコードするので、長い曲でもメモリは使わない。無音なら false
+bool measureIntegratedLoudness(const std::string& audioPath, double& loudness);
+
+// 曲の音量を揃えるためのゲイン (dB)。LOUDNESS_TARGET に寄せ、上げすぎ・下げすぎないよう制限する
+float getLoudnessGain(double loudness);
+
+// --- ラウドネスのキャッシュ ---
+// 音声ファイルごとの統合ラウドネスを cache/loudness.json に保存しておく。
+// 元ファイルの更新日時とサイズも記録し、変わっていれば測り直す。
+// 測るのは起動時にワーカーで1回だけ (analyze)。再生時は lookup で表を引くだけ。
+// 複数のスレッドから同時に呼んでよい。
+class LoudnessCache {
+public:
+    explicit LoudnessCache(const std::string& path = "cache/loudness.json");
+
+    // キャッシュが古いかなければ測って保存する
+    void analyze(const std::string& audioPath);
+    // 測ってあれば true (ファイルの確認はしない)
+    bool lookup(const std::string& audioPath, double& loudness) const;
+
+private:
+    struct Entry {
+        long long modifiedTime = 0;
+        long long size = 0;
+        double loudness = 0.0;
+    };
+
+    void save() const; // mutex を持った状態で呼ぶ
+
+    std::string path;
+    std::map<std::string, Entry> entries;
+    mutable std::mutex mutex;
+};
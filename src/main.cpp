@@ -14,6 +14,30 @@
 #include "constants.hpp"
 #include "types.hpp"
 #include "file_utils.hpp"
+#include "frame_pacer.hpp"
+#include "frame_snapshot.hpp"
+#include "gameplay_renderer.hpp"
+#include "asset_cache.hpp"
+#include "assist_ticks.hpp"
+#include "audio_import.hpp"
+#include "audio_asset_manager.hpp"
+#include "audio_streaming_service.hpp"
+#include "bgm_player.hpp"
+#include "course_prefetcher.hpp"
+#include "hit_offset_tracker.hpp"
+#include "image_loader.hpp"
+#include "keysound_bank.hpp"
+#include "latency_calibrator.hpp"
+#include "loudness_cache.hpp"
+#include "play_analytics.hpp"
+#include "render_thread.hpp"
+#include "results_graphs.hpp"
+#include "sfx_mixer.hpp"
+#include "song_clock.hpp"
+#include "song_preview.hpp"
+#include "spectrum_analyzer.hpp"
+#include "waveform_peaks.hpp"
+#include "worker_pool.hpp"
 
 // for convenience
 using json = nlohmann::json;
@@ -43,7 +67,6 @@ void createParticleExplosion(std::vector<Particle>& particles, const sf::Vector2
 int main()
 {
     sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Sound Game");
-    window.setFramerateLimit(120);
 
     // --- リソースの事前読み込み ---
     sf::Font font;
@@ -53,37 +76,47 @@ int main()
     sf::Font rankFont;
     if (!rankFont.loadFromFile("Evogria_Italic.otf")) { return -1; }
 
-    sf::Texture titleBackgroundTexture;
-    if (!titleBackgroundTexture.loadFromFile("img/title.jpg")) { return -1; }
+    // 背景画像はワーカーでデコードし、描画側のスレッドで少しずつ転送する
+    // (縮小済みの画像は cache/art に保存され、次回からはそちらを読む)
+    AssetCache assetCache;
+    LoudnessCache loudnessCache; // ワーカーより先に作り、後に壊す
+    WorkerPool workerPool;
+    ImageLoader imageLoader(workerPool, assetCache);
+    const sf::Vector2u screenSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    auto titleBackground = imageLoader.load("img/title.jpg", screenSize);
     sf::Sprite titleBackgroundSprite;
-    titleBackgroundSprite.setTexture(titleBackgroundTexture);
 
-    sf::Texture backgroundTexture;
-    if (!backgroundTexture.loadFromFile("img/nasturtium.jpg")) { return -1; }
+    std::shared_ptr<AsyncTexture> songBackground; // 選択中の曲の背景
     sf::Sprite backgroundSprite;
-    backgroundSprite.setTexture(backgroundTexture);
 
-    sf::Texture resultBackgroundTexture;
-    if (!resultBackgroundTexture.loadFromFile("img/result_bg.jpg")) { return -1; }
+    // 選択中の曲の波形。ピークはワーカーで読み込み (.reapeaks かキャッシュがあればデコードしない)、
+    // 準備ができたら1回だけ頂点を作る
+    std::shared_ptr<WaveformPeaks> songPeaks;
+    std::string songPeaksPath;
+    const WaveformPeaks* songWaveformSource = nullptr;
+    sf::VertexArray songWaveform(sf::Lines);
+
+    auto resultBackground = imageLoader.load("img/result_bg.jpg", screenSize);
     sf::Sprite resultBackgroundSprite;
-    resultBackgroundSprite.setTexture(resultBackgroundTexture);
 
-    sf::SoundBuffer tapSoundBuffer;
-    if (!tapSoundBuffer.loadFromFile("audio/tap.wav")) { return -1; }
+    // ゲームプレイ画面の描画 (描画スレッドからも使う)
+    GameplayRenderer gameplayRenderer;
+    if (!gameplayRenderer.load()) { return -1; }
 
-    sf::SoundBuffer menuNavigateSoundBuffer;
-    if (!menuNavigateSoundBuffer.loadFromFile("audio/selection.wav")) { return -1; }
+    // 効果音はミキサーで鳴らす (連打しても前の音を切らない)
+    SfxMixer sfxMixer;
+    SfxMixer::SampleId tapSound = sfxMixer.loadSample("audio/tap.wav");
+    if (tapSound < 0) { return -1; }
 
-    sf::SoundBuffer missSoundBuffer;
-    if (!missSoundBuffer.loadFromFile("audio/miss.wav")) { return -1; }
-    sf::Sound tapSound;
-    tapSound.setBuffer(tapSoundBuffer);
+    SfxMixer::SampleId menuNavigateSound = sfxMixer.loadSample("audio/selection.wav");
+    if (menuNavigateSound < 0) { return -1; }
 
-    sf::Sound menuNavigateSound;
-    menuNavigateSound.setBuffer(menuNavigateSoundBuffer);
+    SfxMixer::SampleId missSound = sfxMixer.loadSample("audio/miss.wav");
+    if (missSound < 0) { return -1; }
 
-    sf::Sound missSound;
-    missSound.setBuffer(missSoundBuffer);
+    // 曲ごとのキー音 (固定の効果音より後に読み込む)
+    KeysoundBank keysoundBank;
 
     // --- 曲リストをJSONから読み込み ---
     std::vector<SongData> songs;
@@ -106,8 +139,28 @@ int main()
                 ChartData chart_data;
                 chart_data.difficultyName = chart_json.at("difficulty").get<std::string>();
                 chart_data.chartPath = chart_json.at("chart_path").get<std::string>();
+                if (chart_json.contains("offset")) chart_data.offset = chart_json.at("offset").get<float>();
                 song_data.charts.push_back(chart_data);
             }
+            if (song_json.contains("bgm_mode")) {
+                std::string bgmMode = song_json.at("bgm_mode").get<std::string>();
+                if (bgmMode == "memory") song_data.bgmMode = BgmMode::MEMORY;
+                else if (bgmMode == "stream") song_data.bgmMode = BgmMode::STREAM;
+            }
+            if (song_json.contains("preview_start")) {
+                song_data.previewStart = song_json.at("preview_start").get<double>();
+            }
+            if (song_json.contains("keysounds")) {
+                for (const auto& keysound_json : song_json.at("keysounds"))
+                {
+                    KeysoundMapping mapping;
+                    mapping.samplePath = keysound_json.at("sample_path").get<std::string>();
+                    if (keysound_json.contains("key")) mapping.keyNumber = keysound_json.at("key").get<int>();
+                    if (keysound_json.contains("channel")) mapping.channel = keysound_json.at("channel").get<int>();
+                    if (keysound_json.contains("gain")) mapping.gain = keysound_json.at("gain").get<float>();
+                    song_data.keysounds.push_back(mapping);
+                }
+            }
             songs.push_back(song_data);
         }
     }
@@ -118,16 +171,77 @@ int main()
         return -1;
     }
 
+    // --- インポート済みの音声に差し替え (tools/audioimport で作る。なければ元のファイルのまま) ---
+    AudioImportManifest audioImports;
+    if (audioImports.load()) {
+        for (auto& song : songs) song.audioPath = audioImports.resolve(song.audioPath);
+    }
+
+    // --- コースをJSONから読み込み (なくてもよい) ---
+    // 曲名と難易度名で songs を引く。見つからない曲は飛ばす
+    std::vector<CourseData> courses;
+    std::ifstream coursesIfs("courses.json");
+    if (coursesIfs.is_open())
+    {
+        json j = json::parse(coursesIfs);
+        for (const auto& course_json : j)
+        {
+            CourseData course_data;
+            course_data.title = course_json.at("title").get<std::string>();
+            for (const auto& entry_json : course_json.at("songs"))
+            {
+                std::string title = entry_json.at("title").get<std::string>();
+                std::string difficulty = entry_json.at("difficulty").get<std::string>();
+                for (size_t s = 0; s < songs.size(); ++s) {
+                    if (songs[s].title != title) continue;
+                    for (size_t c = 0; c < songs[s].charts.size(); ++c) {
+                        if (songs[s].charts[c].difficultyName != difficulty) continue;
+                        CourseEntry entry;
+                        entry.songIndex = s;
+                        entry.chartIndex = c;
+                        course_data.entries.push_back(entry);
+                        break;
+                    }
+                    break;
+                }
+            }
+            if (!course_data.entries.empty()) courses.push_back(course_data);
+        }
+    }
+
+    // --- 曲の背景とサムネイルのキャッシュを裏で作っておく ---
+    for (const auto& song : songs) {
+        if (song.backgroundPath.empty()) continue;
+        std::string backgroundPath = song.backgroundPath;
+        workerPool.submitLowPriority([&assetCache, backgroundPath, screenSize]() {
+            assetCache.warm(backgroundPath, {screenSize, THUMBNAIL_SIZE});
+        });
+    }
+
     // --- ハイスコアをJSONから読み込み ---
     auto highScores = loadHighScores();
 
     // --- 設定をJSONから読み込み ---
     auto config = loadConfig();
 
+    // --- 曲のラウドネスを裏で測っておく (2回目からは cache/loudness.json を読むだけ) ---
+    if (config.loudnessNormalization) {
+        for (const auto& song : songs) {
+            std::string audioPath = song.audioPath;
+            workerPool.submitLowPriority([&loudnessCache, audioPath]() {
+                loudnessCache.analyze(audioPath);
+            });
+        }
+    }
+
     // --- 初期音量の設定 ---
-    tapSound.setVolume(config.sfxVolume);
-    menuNavigateSound.setVolume(config.sfxVolume);
-    missSound.setVolume(config.sfxVolume);
+    sfxMixer.setVolume(config.sfxVolume);
+    sfxMixer.play();
+
+    // --- フレームレートの設定 ---
+    FramePacer framePacer;
+    framePacer.apply(window, config.frameRateLimit, config.verticalSync);
+    gameplayRenderer.applyConfig(config, framePacer.getFrameBudget());
 
     // --- UI要素の準備 ---
     // タイトル画面
@@ -136,8 +250,8 @@ int main()
     titleText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
     titleText.setPosition(WINDOW_WIDTH / 2.0f, 350.f); // 200 -> 350
 
-    std::vector<sf::Text> titleMenuTexts(2);
-    std::vector<std::string> titleMenuStrings = {"Start Game", "Options"};
+    std::vector<sf::Text> titleMenuTexts(3);
+    std::vector<std::string> titleMenuStrings = {"Start Game", "Course", "Options"};
     for(size_t i = 0; i < titleMenuTexts.size(); ++i) {
         titleMenuTexts[i].setFont(font);
         titleMenuTexts[i].setCharacterSize(50); // 32 -> 50
@@ -162,11 +276,28 @@ int main()
         songTitleTexts[i].setPosition(WINDOW_WIDTH / 2.0f, 350.f + i * 80.f); // 200, 60 -> 350, 80
     }
 
+    // コース選択画面
+    sf::Text courseSelectionTitle("Select a Course", font, 80);
+    textRect = courseSelectionTitle.getLocalBounds();
+    courseSelectionTitle.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+    courseSelectionTitle.setPosition(WINDOW_WIDTH / 2.0f, 150.f);
+    std::vector<sf::Text> courseTitleTexts(courses.size());
+    for(size_t i = 0; i < courses.size(); ++i) {
+        courseTitleTexts[i].setFont(font);
+        courseTitleTexts[i].setCharacterSize(50);
+        courseTitleTexts[i].setString(courses[i].title + "  (" + std::to_string(courses[i].entries.size()) + " songs)");
+        textRect = courseTitleTexts[i].getLocalBounds();
+        courseTitleTexts[i].setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+        courseTitleTexts[i].setPosition(WINDOW_WIDTH / 2.0f, 350.f + i * 80.f);
+    }
+
     // 難易度選択画面
     sf::Text difficultySelectionTitle("", font, 80); // 50 -> 80
     std::vector<sf::Text> difficultyTexts;
     sf::Text difficultyHighScoreText("", scoreFont, 42); // 28 -> 42
     difficultyHighScoreText.setFillColor(sf::Color(255, 255, 100)); // Light Yellow
+    sf::Text practiceSpeedText("", scoreFont, 42);
+    float practiceSpeed = 1.0f; // 練習用の再生速度 (難易度選択で左右キー)
 
     // オプション画面
     sf::Text optionsTitle("Options", font, 90); // 60 -> 90
@@ -174,16 +305,16 @@ int main()
     optionsTitle.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
     optionsTitle.setPosition(WINDOW_WIDTH / 2.0f, 200.f); // 100 -> 200
 
-    std::vector<sf::Text> optionMenuTexts(4);
-    std::vector<std::string> optionMenuStrings = {"Note Speed", "BGM Volume", "SFX Volume", "Audio Offset"};
+    std::vector<std::string> optionMenuStrings = {"Note Speed", "BGM Volume", "SFX Volume", "Audio Offset", "Dynamic Res.", "Frame Rate", "Keysounds", "Assist Ticks", "Calibrate"};
+    std::vector<sf::Text> optionMenuTexts(optionMenuStrings.size());
     for(size_t i = 0; i < optionMenuTexts.size(); ++i) {
         optionMenuTexts[i].setFont(font);
         optionMenuTexts[i].setCharacterSize(50); // 32 -> 50
         optionMenuTexts[i].setString(optionMenuStrings[i]);
-        optionMenuTexts[i].setPosition(WINDOW_WIDTH / 2.0f - 400.f, 400.f + i * 100.f); // 250, 80 -> 400, 100
+        optionMenuTexts[i].setPosition(WINDOW_WIDTH / 2.0f - 400.f, 300.f + i * 70.f); // 400, 100 -> 300, 70
     }
 
-    std::vector<sf::Text> optionValueTexts(4);
+    std::vector<sf::Text> optionValueTexts(optionMenuStrings.size());
     for(size_t i = 0; i < optionValueTexts.size(); ++i) {
         optionValueTexts[i].setFont(font);
         optionValueTexts[i].setCharacterSize(50); // 32 -> 50
@@ -195,24 +326,19 @@ int main()
     optionsHelpText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
     optionsHelpText.setPosition(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 150.f); // 100 -> 150
 
-    // ポーズ画面
+    // キャリブレーション画面
+    sf::Text calibrationTitle("Calibration", font, 90);
+    textRect = calibrationTitle.getLocalBounds();
+    calibrationTitle.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+    calibrationTitle.setPosition(WINDOW_WIDTH / 2.0f, 200.f);
+    sf::Text calibrationHelpText("", font, 40);
+    sf::Text calibrationStatusText("", scoreFont, 50);
+    calibrationStatusText.setFillColor(sf::Color::Yellow);
+
+    // ポーズ画面 (メニューは GameplayRenderer が描画する)
     sf::RectangleShape pauseOverlay(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
     pauseOverlay.setFillColor(sf::Color(0, 0, 0, 150)); // 半透明の黒
-    sf::Text pauseTitle("PAUSED", font, 90); // 60 -> 90
-    textRect = pauseTitle.getLocalBounds();
-    pauseTitle.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-    pauseTitle.setPosition(WINDOW_WIDTH / 2.0f, 300.f); // 150 -> 300
-
-    std::vector<sf::Text> pauseMenuTexts(3);
-    std::vector<std::string> pauseMenuStrings = {"Continue", "Retry", "Back to Select"};
-    for(size_t i = 0; i < pauseMenuTexts.size(); ++i) {
-        pauseMenuTexts[i].setFont(font);
-        pauseMenuTexts[i].setCharacterSize(50); // 32 -> 50
-        pauseMenuTexts[i].setString(pauseMenuStrings[i]);
-        textRect = pauseMenuTexts[i].getLocalBounds();
-        pauseMenuTexts[i].setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-        pauseMenuTexts[i].setPosition(WINDOW_WIDTH / 2.0f, 500.f + i * 80.f); // 280, 60 -> 500, 80
-    }
+    const size_t pauseMenuItemCount = gameplayRenderer.getPauseMenuItemCount();
 
     // ゲームオーバー画面
     sf::Text gameoverTitle("GAME OVER", font, 90);
@@ -231,26 +357,13 @@ int main()
         gameoverMenuTexts[i].setPosition(WINDOW_WIDTH / 2.0f, 500.f + i * 80.f);
     }
 
-    // ゲームプレイ画面
-    sf::Text scoreText("", scoreFont, 48); // 30 -> 48
-    scoreText.setPosition(20, 20); // 10, 10 -> 20, 20
-    scoreText.setOutlineColor(sf::Color::Black);
-    scoreText.setOutlineThickness(2.f);
-
-    sf::Text comboText("", font, 72); // 48 -> 72
-    sf::Text judgmentText("", font, 54); // 36 -> 54
+    // ゲームプレイ画面 (HUDは GameplayRenderer が描画する)
     sf::Clock judgmentClock;
+    Judgment lastJudgment = Judgment::NONE;
+    int lastJudgmentLane = 0;
 
-    // HPゲージ
-    sf::RectangleShape hpGaugeBg(sf::Vector2f(300, 20));
-    hpGaugeBg.setFillColor(sf::Color(50, 50, 50));
-    hpGaugeBg.setOutlineColor(sf::Color::White);
-    hpGaugeBg.setOutlineThickness(2.f);
-    hpGaugeBg.setPosition(WINDOW_WIDTH - 320, 20);
-
-    sf::RectangleShape hpGauge(sf::Vector2f(300, 20));
-    hpGauge.setFillColor(sf::Color::Green);
-    hpGauge.setPosition(WINDOW_WIDTH - 320, 20);
+    // パフォーマンス表示 (F3で切り替え)
+    bool showPerformanceOverlay = false;
 
     // リザルト画面
     sf::Text resultsTitle("Results", scoreFont, 90); // 60 -> 90
@@ -308,17 +421,6 @@ int main()
     }
 
 
-    // --- ゲームプレイ用オブジェクト ---
-    std::vector<sf::RectangleShape> lanes(LANE_COUNT);
-    for (int i = 0; i < LANE_COUNT; ++i) {
-        lanes[i].setSize(sf::Vector2f(LANE_WIDTH - 2.f, WINDOW_HEIGHT));
-        lanes[i].setPosition(LANE_START_X + i * LANE_WIDTH, 0);
-        lanes[i].setOutlineColor(sf::Color::White);
-    }
-    sf::RectangleShape judgmentLine(sf::Vector2f(LANE_AREA_WIDTH, 2.f));
-    judgmentLine.setPosition(LANE_START_X, JUDGMENT_LINE_Y);
-    judgmentLine.setFillColor(sf::Color::Red);
-
     sf::RectangleShape fadeOverlay(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
 
     // --- ゲームの状態と変数 ---
@@ -334,51 +436,281 @@ int main()
     size_t nextNoteIndex = 0;
     std::vector<Note> activeNotes;
     std::vector<Note> chart;
-    sf::Music music;
-    sf::Music menuMusic;
-    sf::Music resultsMusic;
-    sf::Music gameoverMusic;
+    // --- 音楽は1本のストリーミングサービスでまとめて鳴らす ---
+    AudioStreamingService audioService;
+    audioService.start();
+    gameplayRenderer.setAudioService(&audioService);
+    SpectrumAnalyzer spectrumAnalyzer(audioService);
+    if (config.spectrumVisualizer) {
+        gameplayRenderer.setSpectrumAnalyzer(&spectrumAnalyzer); // 解析スレッドはゲームプレイに入ってから動かす
+    }
+    BgmPlayer music(audioService);
+    SongClock songClock(audioService, AudioChannel::BGM);
+
+    // ノーツの落下速度 (曲中の1秒あたりのピクセル)。再生速度を落としても見た目の速さは変えない
+    auto getScrollSpeed = [&]() -> float {
+        return NOTE_PIXELS_PER_SECOND * config.noteSpeedMultiplier / songClock.getSpeed();
+    };
+
+    // --- 練習区間 ---
+    std::vector<ChartSection> chartSections; // 譜面と一緒に読み込む
+    int practiceSection = -1;                // -1 なら曲全体
+    double practiceEnd = 0.0;                // 0 なら曲の終わりまで
+    double practiceLoopLength = 0.0;         // ループする区間の長さ (曲中の秒)。0 ならループしない
+    size_t practiceStartIndex = 0;           // 区間の最初のノーツ
+    double spawnShift = 0.0;                 // 次の周のノーツを先に出すときに時刻に足す (区間の長さの倍数)
+    double previousSongTime = 0.0;           // ループで区間の先頭に戻ったことを見つけるため
+
+    // 時刻順の譜面を二分探索して、time から先のノーツを出し直す (長い譜面でもすぐ終わる)
+    auto seekChart = [&](double time) {
+        nextNoteIndex = std::lower_bound(chart.begin(), chart.end(), time, [](const Note& note, double t) {
+            return note.spawnTime < t;
+        }) - chart.begin();
+        activeNotes.clear();
+        spawnShift = 0.0;
+        previousSongTime = time - 1e6;
+    };
+    // 次の周のためにずらして出したノーツも、譜面上の時刻に戻して数える
+    auto getChartTime = [&](double time) -> double {
+        if (practiceLoopLength <= 0.0) return time;
+        const double loopEnd = songClock.getSectionStart() + practiceLoopLength;
+        while (time >= loopEnd) time -= practiceLoopLength;
+        return time;
+    };
+
+    // 選んでいる練習区間を時計と譜面に反映する。区間を選んでいればその区間をループする
+    auto applyPracticeSection = [&]() {
+        double start = 0.0;
+        practiceEnd = 0.0;
+        if (practiceSection >= 0 && static_cast<size_t>(practiceSection) < chartSections.size()) {
+            start = chartSections[practiceSection].startTime;
+            if (static_cast<size_t>(practiceSection) + 1 < chartSections.size()) {
+                practiceEnd = chartSections[practiceSection + 1].startTime;
+            }
+        }
+        songClock.setSection(sf::seconds(static_cast<float>(start)), sf::seconds(static_cast<float>(practiceEnd)), practiceSection >= 0);
+        seekChart(start);
+        practiceStartIndex = nextNoteIndex;
+        practiceLoopLength = 0.0;
+        if (practiceSection >= 0) {
+            // 最後の区間は曲の終わりで先頭に戻る
+            double loopEnd = practiceEnd > 0.0 ? practiceEnd : music.getDuration().asSeconds();
+            practiceLoopLength = std::max(0.0, loopEnd - start);
+        }
+    };
+
+    // 最初のノーツが画面の上端から落ちてこられるだけのリードインを取る (実時間)
+    auto getSongLeadIn = [&]() -> sf::Time {
+        float fallTime = JUDGMENT_LINE_Y / getScrollSpeed();
+        float firstNoteTime = nextNoteIndex < chart.size() ? static_cast<float>(chart[nextNoteIndex].spawnTime - songClock.getSectionStart()) : 0.f;
+        float leadIn = (fallTime - firstNoteTime) / songClock.getSpeed() + SONG_LEAD_IN_MARGIN.asSeconds();
+        return sf::seconds(std::max(SONG_LEAD_IN.asSeconds(), leadIn));
+    };
     size_t selectedSongIndex = 0;
     size_t selectedDifficultyIndex = 0;
     size_t selectedPauseMenuIndex = 0;
     size_t selectedTitleMenuIndex = 0;
     size_t selectedResultsMenuIndex = 0;
     size_t selectedOptionsMenuIndex = 0;
+    size_t selectedCourseIndex = 0;
+
+    auto prefersBgmMemory = [&](const SongData& song) -> bool {
+        return song.bgmMode == BgmMode::DEFAULT ? config.bgmInMemory : song.bgmMode == BgmMode::MEMORY;
+    };
+    auto getBgmMemoryBudget = [&]() -> size_t {
+        return static_cast<size_t>(std::max(0, config.bgmMemoryBudget)) * 1024 * 1024;
+    };
+    // 曲ごとの音量の補正 (dB)。まだ測れていなければ補正しない
+    auto getSongGain = [&](const SongData& song) -> float {
+        double loudness = 0.0;
+        if (!config.loudnessNormalization || !loudnessCache.lookup(song.audioPath, loudness)) return 0.f;
+        return getLoudnessGain(loudness);
+    };
+    // --- アシストのクリック ---
+    std::vector<ChartBeat> chartBeats; // 譜面と一緒に読み込む
+    // 読み込んだ譜面のクリックを今の BGM のチャンネルに重ねる (Off なら外す)。曲を鳴らし始める前に呼ぶ
+    auto applyAssistTicks = [&]() {
+        if (config.assistTicks == AssistTickMode::OFF) {
+            music.setTicks(nullptr);
+        } else {
+            music.setTicks(std::make_shared<AssistTickTrack>(chartBeats, chart, config.assistTicks));
+        }
+    };
+    // --- 譜面ごとのずれの学習 ---
+    HitOffsetTracker hitOffsets;
+    std::string playingChartKey;        // 学習に使う譜面のキー (ハイスコアと同じ)
+    double chartTimingCorrection = 0.0; // 秒 (実時間)。adaptive_offset なら学習したずれを打ち消す
+    // 曲を始めるたびに、その時点までの学習から補正を決め直す
+    auto applyChartTimingCorrection = [&]() {
+        const auto& song = songs[selectedSongIndex];
+        playingChartKey = generateHighScoreKey(song, song.charts[selectedDifficultyIndex]);
+        chartTimingCorrection = 0.0;
+        if (config.adaptiveOffset) hitOffsets.getCorrection(playingChartKey, chartTimingCorrection);
+    };
+    // --- プレイの分析 (リザルトのグラフ) ---
+    PlayAnalytics playAnalytics;
+    ResultsGraphs resultsGraphs;
+    // 判定と表示に足すずれ (実時間の秒)
+    auto getTimingOffset = [&]() -> float {
+        return config.audioOffset / 1000.0f + static_cast<float>(chartTimingCorrection);
+    };
+    auto getBackgroundPath = [](const SongData& song) -> std::string {
+        return song.backgroundPath.empty() ? "img/default.jpg" : song.backgroundPath;
+    };
+
+    // --- コース ---
+    // 曲を遊んでいる間に次の曲を先読みし、譜面を終えたらそのまま次の曲のリードインへ移る (HPは持ち越す)
+    bool courseActive = false;
+    size_t courseIndex = 0;     // 遊んでいる曲の entries の添字
+    size_t courseLength = 0;    // 遊ぶ曲数 (次の曲が読めなければそこで終える)
+    size_t courseNoteCount = 0; // ここまでの曲のノーツ数の合計 (ランクの計算に使う)
+    CoursePrefetcher coursePrefetcher(workerPool);
+    std::unique_ptr<PreparedSong> nextCourseSong; // 空いている方のチャンネルに開き済みの次の曲
+    std::shared_ptr<AsyncTexture> nextCourseBackground;
+
+    // entries の index 番目の曲の準備を裏で始める
+    auto prefetchCourseSong = [&](size_t index) {
+        nextCourseSong.reset();
+        if (index >= courseLength) {
+            coursePrefetcher.cancel();
+            return;
+        }
+        const CourseEntry& entry = courses[selectedCourseIndex].entries[index];
+        const auto& song = songs[entry.songIndex];
+        nextCourseBackground = imageLoader.load(getBackgroundPath(song), screenSize, "img/default.jpg");
+        coursePrefetcher.prepare(song, song.charts[entry.chartIndex], prefersBgmMemory(song), getBgmMemoryBudget());
+    };
+
+    // 選んだコースを最初の曲から始められるようにする。最初の曲だけはその場で読み込む
+    auto loadCourse = [&]() -> bool {
+        const CourseEntry& entry = courses[selectedCourseIndex].entries[0];
+        const auto& song = songs[entry.songIndex];
+        const auto& chartData = song.charts[entry.chartIndex];
+        selectedSongIndex = entry.songIndex;
+        selectedDifficultyIndex = entry.chartIndex;
+        songBackground = imageLoader.load(getBackgroundPath(song), screenSize, "img/default.jpg");
+        gameplayRenderer.setBackground(songBackground);
+        if (!music.open(song.audioPath, prefersBgmMemory(song), getBgmMemoryBudget())) return false;
+        music.setGain(getSongGain(song));
+        songClock.setSpeed(1.0f);
+        chart = loadChartFromMidi(chartData.chartPath, &chartSections, chartData.offset / 1000.0, &chartBeats);
+        if (chart.empty()) return false;
+        applyAssistTicks();
+        keysoundBank.unload(sfxMixer); // キー音の読み込みは重いので、コースでは鳴らさない
+        courseActive = true;
+        courseIndex = 0;
+        courseLength = courses[selectedCourseIndex].entries.size();
+        courseNoteCount = chart.size();
+        prefetchCourseSong(1);
+        return true;
+    };
+
+    // 先読みしておいた次の曲へ移る。前の曲の残りは次の曲のリードインの間にフェードアウトする
+    auto switchCourseSong = [&]() {
+        chart = std::move(nextCourseSong->chart);
+        chartSections = std::move(nextCourseSong->sections);
+        chartBeats = std::move(nextCourseSong->beats);
+        nextCourseSong.reset();
+        playAnalytics.addChart(chartBeats);
+        ++courseIndex;
+        const CourseEntry& entry = courses[selectedCourseIndex].entries[courseIndex];
+        selectedSongIndex = entry.songIndex;
+        selectedDifficultyIndex = entry.chartIndex;
+        songBackground = nextCourseBackground;
+        gameplayRenderer.setBackground(songBackground);
+        courseNoteCount += chart.size();
+
+        music.switchToNext(COURSE_OUTRO_FADE);
+        music.setGain(getSongGain(songs[entry.songIndex]));
+        applyAssistTicks();
+        songClock.setChannel(music.getChannel());
+        songClock.setSpeed(1.0f);
+        practiceSection = -1;
+        applyChartTimingCorrection();
+        applyPracticeSection();
+        songClock.start(getSongLeadIn());
+        prefetchCourseSong(courseIndex + 1);
+    };
 
     std::vector<sf::Clock> laneFlashClocks(LANE_COUNT);
     sf::Clock comboAnimationClock;
     sf::Clock fadeClock;
     std::vector<Particle> particles;
 
-    // --- メニューBGMの再生開始 ---
-    if (menuMusic.openFromFile("audio/title.ogg")) {
-        menuMusic.setLoop(true);
-        menuMusic.setVolume(config.bgmVolume);
-        menuMusic.play();
-    }
+    // --- 描画スレッド ---
+    FrameSnapshot snapshot; // ゲームプレイ画面の描画に必要な状態
+    RenderThread renderThread(window, gameplayRenderer, framePacer, imageLoader);
+
+    // --- メニュー系BGMを開いておき、タイトルBGMの再生開始 ---
+    AudioAssetManager audioAssets(audioService);
+    audioAssets.load();
+    audioAssets.setVolume(config.bgmVolume);
+    audioAssets.play(MusicCue::TITLE);
+    SongPreview songPreview(audioService, workerPool);
+    songPreview.setVolume(config.bgmVolume);
+
+    // --- 遅延のキャリブレーション ---
+    // 無音の曲にアシストのクリックを重ねて、ゲームプレイと同じ BGM のチャンネルと時計で鳴らす
+    LatencyCalibrator calibrator;
+    LatencyCalibrator::Result calibrationResult;
+    bool calibrationFinished = false;
+    auto startCalibration = [&]() -> bool {
+        calibrator.reset();
+        calibrationFinished = false;
+        size_t frameCount = static_cast<size_t>((calibrator.getEndTime() + CALIBRATION_INTERVAL.asSeconds()) * MIXER_SAMPLE_RATE);
+        std::unique_ptr<MusicSource> source(new MusicSource());
+        source->openSamples(std::vector<sf::Int16>(frameCount, 0), 1, MIXER_SAMPLE_RATE);
+        if (!music.open(std::move(source))) return false;
+        music.setGain(0.f);
+        music.setVolume(config.bgmVolume);
+        music.setTicks(std::make_shared<AssistTickTrack>(calibrator.getBeats(), std::vector<Note>(), AssistTickMode::BEAT));
+        songClock.setChannel(music.getChannel());
+        songClock.setSpeed(1.0f);
+        songClock.setSection(sf::Time::Zero, sf::Time::Zero, false);
+        songClock.start(SONG_LEAD_IN);
+        return true;
+    };
+    auto stopCalibration = [&]() {
+        songClock.stop();
+        music.setTicks(nullptr);
+    };
 
     // --- ゲームループ ---
+    sf::Clock frameClock; // 1フレームの処理時間 (動的解像度の判断に使う)
+    sf::Clock deltaClock; // 前フレームからの経過時間 (パーティクルの更新に使う)
     while (window.isOpen())
     {
+        frameClock.restart();
+        float deltaTime = std::min(deltaClock.restart().asSeconds(), 0.1f);
+
         // --- イベント処理 ---
         sf::Event event;
         while (window.pollEvent(event))
         {
-            if (event.type == sf::Event::Closed) window.close();
+            if (event.type == sf::Event::Closed) {
+                renderThread.stop(); // 描画中のウィンドウを閉じないように先に止める
+                window.close();
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                showPerformanceOverlay = !showPerformanceOverlay;
+                renderThread.setPerformanceOverlayVisible(showPerformanceOverlay);
+            }
 
             if (gameState == GameState::TITLE)
             {
                 if (event.type == sf::Event::KeyPressed) {
                     if (event.key.code == sf::Keyboard::Down) {
                         selectedTitleMenuIndex = (selectedTitleMenuIndex + 1) % titleMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     } else if (event.key.code == sf::Keyboard::Up) {
                         selectedTitleMenuIndex = (selectedTitleMenuIndex + titleMenuTexts.size() - 1) % titleMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     } else if (event.key.code == sf::Keyboard::Enter) {
                         if (selectedTitleMenuIndex == 0) { // Start Game
                             gameState = GameState::SONG_SELECTION;
-                        } else if (selectedTitleMenuIndex == 1) { // Options
+                        } else if (selectedTitleMenuIndex == 1) { // Course
+                            if (!courses.empty()) gameState = GameState::COURSE_SELECTION;
+                        } else if (selectedTitleMenuIndex == 2) { // Options
                             gameState = GameState::OPTIONS;
                         }
                     }
@@ -389,41 +721,76 @@ int main()
                 if (event.type == sf::Event::KeyPressed) {
                     if (event.key.code == sf::Keyboard::Up) {
                         selectedOptionsMenuIndex = (selectedOptionsMenuIndex + optionMenuTexts.size() - 1) % optionMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     } else if (event.key.code == sf::Keyboard::Down) {
                         selectedOptionsMenuIndex = (selectedOptionsMenuIndex + 1) % optionMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     } else if (event.key.code == sf::Keyboard::Right) {
                         if (selectedOptionsMenuIndex == 0) { // Note Speed
                             config.noteSpeedMultiplier = std::min(5.0f, config.noteSpeedMultiplier + 0.1f);
                         } else if (selectedOptionsMenuIndex == 1) { // BGM Volume
                             config.bgmVolume = std::min(100.0f, config.bgmVolume + 5.0f);
-                            menuMusic.setVolume(config.bgmVolume);
-                            menuNavigateSound.play();
+                            audioAssets.setVolume(config.bgmVolume);
+                            songPreview.setVolume(config.bgmVolume);
+                            sfxMixer.trigger(menuNavigateSound);
                         } else if (selectedOptionsMenuIndex == 2) { // SFX Volume
                             config.sfxVolume = std::min(100.0f, config.sfxVolume + 5.0f);
-                            tapSound.setVolume(config.sfxVolume);
-                            menuNavigateSound.setVolume(config.sfxVolume);
-                            menuNavigateSound.play();
+                            sfxMixer.setVolume(config.sfxVolume);
+                            sfxMixer.trigger(menuNavigateSound);
                         } else if (selectedOptionsMenuIndex == 3) { // Audio Offset
                             float increment = (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift) || sf::Keyboard::isKeyPressed(sf::Keyboard::RShift)) ? 10.0f : 1.0f;
                             config.audioOffset = std::min(1000.0f, config.audioOffset + increment);
+                        } else if (selectedOptionsMenuIndex == 4) { // Dynamic Resolution
+                            config.dynamicResolution = !config.dynamicResolution;
+                            gameplayRenderer.applyConfig(config, framePacer.getFrameBudget());
+                            sfxMixer.trigger(menuNavigateSound);
+                        } else if (selectedOptionsMenuIndex == 5) { // Frame Rate
+                            applyFrameRateChoice(config, (getFrameRateChoiceIndex(config) + 1) % getFrameRateChoiceCount());
+                            framePacer.apply(window, config.frameRateLimit, config.verticalSync);
+                            gameplayRenderer.applyConfig(config, framePacer.getFrameBudget());
+                            sfxMixer.trigger(menuNavigateSound);
+                        } else if (selectedOptionsMenuIndex == 6) { // Keysounds
+                            config.keysounds = !config.keysounds;
+                            sfxMixer.trigger(menuNavigateSound);
+                        } else if (selectedOptionsMenuIndex == 7) { // Assist Ticks
+                            config.assistTicks = static_cast<AssistTickMode>((static_cast<int>(config.assistTicks) + 1) % ASSIST_TICK_MODE_COUNT);
+                            sfxMixer.trigger(menuNavigateSound);
                         }
                     } else if (event.key.code == sf::Keyboard::Left) {
                         if (selectedOptionsMenuIndex == 0) { // Note Speed
                             config.noteSpeedMultiplier = std::max(0.1f, config.noteSpeedMultiplier - 0.1f);
                         } else if (selectedOptionsMenuIndex == 1) { // BGM Volume
                             config.bgmVolume = std::max(0.0f, config.bgmVolume - 5.0f);
-                            menuMusic.setVolume(config.bgmVolume);
-                            menuNavigateSound.play();
+                            audioAssets.setVolume(config.bgmVolume);
+                            songPreview.setVolume(config.bgmVolume);
+                            sfxMixer.trigger(menuNavigateSound);
                         } else if (selectedOptionsMenuIndex == 2) { // SFX Volume
                             config.sfxVolume = std::max(0.0f, config.sfxVolume - 5.0f);
-                            tapSound.setVolume(config.sfxVolume);
-                            menuNavigateSound.setVolume(config.sfxVolume);
-                            menuNavigateSound.play();
+                            sfxMixer.setVolume(config.sfxVolume);
+                            sfxMixer.trigger(menuNavigateSound);
                         } else if (selectedOptionsMenuIndex == 3) { // Audio Offset
                             float decrement = (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift) || sf::Keyboard::isKeyPressed(sf::Keyboard::RShift)) ? 10.0f : 1.0f;
                             config.audioOffset = std::max(-1000.0f, config.audioOffset - decrement);
+                        } else if (selectedOptionsMenuIndex == 4) { // Dynamic Resolution
+                            config.dynamicResolution = !config.dynamicResolution;
+                            gameplayRenderer.applyConfig(config, framePacer.getFrameBudget());
+                            sfxMixer.trigger(menuNavigateSound);
+                        } else if (selectedOptionsMenuIndex == 5) { // Frame Rate
+                            applyFrameRateChoice(config, (getFrameRateChoiceIndex(config) + getFrameRateChoiceCount() - 1) % getFrameRateChoiceCount());
+                            framePacer.apply(window, config.frameRateLimit, config.verticalSync);
+                            gameplayRenderer.applyConfig(config, framePacer.getFrameBudget());
+                            sfxMixer.trigger(menuNavigateSound);
+                        } else if (selectedOptionsMenuIndex == 6) { // Keysounds
+                            config.keysounds = !config.keysounds;
+                            sfxMixer.trigger(menuNavigateSound);
+                        } else if (selectedOptionsMenuIndex == 7) { // Assist Ticks
+                            config.assistTicks = static_cast<AssistTickMode>((static_cast<int>(config.assistTicks) + ASSIST_TICK_MODE_COUNT - 1) % ASSIST_TICK_MODE_COUNT);
+                            sfxMixer.trigger(menuNavigateSound);
+                        }
+                    } else if (event.key.code == sf::Keyboard::Enter && selectedOptionsMenuIndex == 8) { // Calibrate
+                        if (startCalibration()) {
+                            audioAssets.stop(MusicCue::TITLE, SONG_PREVIEW_FADE);
+                            gameState = GameState::CALIBRATION;
                         }
                     } else if (event.key.code == sf::Keyboard::Enter || event.key.code == sf::Keyboard::Escape) {
                         saveConfig(config);
@@ -431,6 +798,31 @@ int main()
                     }
                 }
             }
+            else if (gameState == GameState::CALIBRATION)
+            {
+                if (event.type == sf::Event::KeyPressed) {
+                    if (event.key.code == sf::Keyboard::Escape) {
+                        stopCalibration();
+                        audioAssets.play(MusicCue::TITLE, SONG_PREVIEW_FADE);
+                        gameState = GameState::OPTIONS;
+                    } else if (calibrationFinished) {
+                        if (event.key.code == sf::Keyboard::Enter) {
+                            if (calibrationResult.valid) {
+                                config.audioOffset = std::round(calibrationResult.offset);
+                                saveConfig(config);
+                            }
+                            audioAssets.play(MusicCue::TITLE, SONG_PREVIEW_FADE);
+                            gameState = GameState::OPTIONS;
+                        } else if (event.key.code == sf::Keyboard::Space) {
+                            startCalibration(); // やり直す
+                        }
+                    } else if (event.key.code == sf::Keyboard::Space ||
+                               std::find(LANE_KEYS.begin(), LANE_KEYS.end(), event.key.code) != LANE_KEYS.end()) {
+                        // 判定と同じく、イベントを処理した時点の曲の時計で取る
+                        calibrator.addTap(songClock.getTime());
+                    }
+                }
+            }
             else if (gameState == GameState::SONG_SELECTION)
             {
                 if (event.type == sf::Event::KeyPressed)
@@ -438,20 +830,35 @@ int main()
                     if (event.key.code == sf::Keyboard::Down)
                     {
                         selectedSongIndex = (selectedSongIndex + 1) % songs.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Up)
                     {
                         selectedSongIndex = (selectedSongIndex + songs.size() - 1) % songs.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Enter)
                     {
                         gameState = GameState::DIFFICULTY_SELECTION;
                         selectedDifficultyIndex = 0; // Reset difficulty selection
 
-                        // 難易度選択UIの動的生成
+                        // 難易度を選んでいる間に背景のデコードを済ませておく
                         const auto& selectedSong = songs[selectedSongIndex];
+                        std::string backgroundPath = getBackgroundPath(selectedSong);
+                        if (!songBackground || songBackground->getPath() != backgroundPath) {
+                            songBackground = imageLoader.load(backgroundPath, screenSize, "img/default.jpg");
+                            backgroundSprite = sf::Sprite();
+                        }
+                        if (!songPeaks || songPeaksPath != selectedSong.audioPath) {
+                            auto peaks = std::make_shared<WaveformPeaks>();
+                            std::string audioPath = selectedSong.audioPath;
+                            workerPool.submit([peaks, audioPath]() { peaks->load(audioPath); });
+                            songPeaks = peaks;
+                            songPeaksPath = audioPath;
+                            songWaveformSource = nullptr;
+                        }
+
+                        // 難易度選択UIの動的生成
                         difficultySelectionTitle.setString(selectedSong.title);
                         sf::FloatRect textRect = difficultySelectionTitle.getLocalBounds();
                         difficultySelectionTitle.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
@@ -470,6 +877,49 @@ int main()
                         }
                     }
                     else if (event.key.code == sf::Keyboard::Escape)
+                    {
+                        gameState = GameState::TITLE;
+                        songPreview.stop(SONG_PREVIEW_FADE);
+                        audioAssets.crossfadeTo(MusicCue::TITLE, SONG_PREVIEW_FADE);
+                    }
+                }
+            }
+            else if (gameState == GameState::COURSE_SELECTION)
+            {
+                if (event.type == sf::Event::KeyPressed)
+                {
+                    if (event.key.code == sf::Keyboard::Down)
+                    {
+                        selectedCourseIndex = (selectedCourseIndex + 1) % courses.size();
+                        sfxMixer.trigger(menuNavigateSound);
+                    }
+                    else if (event.key.code == sf::Keyboard::Up)
+                    {
+                        selectedCourseIndex = (selectedCourseIndex + courses.size() - 1) % courses.size();
+                        sfxMixer.trigger(menuNavigateSound);
+                    }
+                    else if (event.key.code == sf::Keyboard::Enter)
+                    {
+                        // --- コース開始処理 ---
+                        if (!loadCourse()) { return -1; }
+                        music.setVolume(config.bgmVolume);
+
+                        audioAssets.stop(MusicCue::TITLE); // メニューBGMを停止
+                        gameState = GameState::PLAYING;
+                        score = 0;
+                        combo = 0;
+                        maxCombo = 0;
+                        perfectCount = 0;
+                        greatCount = 0;
+                        missCount = 0;
+                        playAnalytics.reset(chartBeats);
+                        hp = MAX_HP;
+                        practiceSection = -1;
+                        applyChartTimingCorrection();
+                        applyPracticeSection();
+                        songClock.start(getSongLeadIn());
+                    }
+                    else if (event.key.code == sf::Keyboard::Escape)
                     {
                         gameState = GameState::TITLE;
                     }
@@ -482,12 +932,22 @@ int main()
                     if (event.key.code == sf::Keyboard::Down)
                     {
                         selectedDifficultyIndex = (selectedDifficultyIndex + 1) % songs[selectedSongIndex].charts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Up)
                     {
                         selectedDifficultyIndex = (selectedDifficultyIndex + songs[selectedSongIndex].charts.size() - 1) % songs[selectedSongIndex].charts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
+                    }
+                    else if (event.key.code == sf::Keyboard::Right)
+                    {
+                        practiceSpeed = std::min(PRACTICE_SPEED_MAX, practiceSpeed + PRACTICE_SPEED_STEP);
+                        sfxMixer.trigger(menuNavigateSound);
+                    }
+                    else if (event.key.code == sf::Keyboard::Left)
+                    {
+                        practiceSpeed = std::max(PRACTICE_SPEED_MIN, practiceSpeed - PRACTICE_SPEED_STEP);
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Enter)
                     {
@@ -495,19 +955,27 @@ int main()
                         const auto& selectedSong = songs[selectedSongIndex];
                         const auto& selectedChart = selectedSong.charts[selectedDifficultyIndex];
 
-                        // 背景の更新
-                        if (!selectedSong.backgroundPath.empty() && !backgroundTexture.loadFromFile(selectedSong.backgroundPath)) {
-                            // 読み込み失敗時はデフォルトにフォールバック
-                            backgroundTexture.loadFromFile("img/default.jpg");
-                        }
-                        backgroundSprite.setTexture(backgroundTexture, true);
+                        // 背景の更新 (デコードは曲を選んだ時点で始まっている)
+                        gameplayRenderer.setBackground(songBackground);
 
-                        if (!music.openFromFile(selectedSong.audioPath)) { return -1; }
+                        courseActive = false;
+                        coursePrefetcher.cancel();
+                        nextCourseSong.reset();
+                        if (!music.open(selectedSong.audioPath, prefersBgmMemory(selectedSong), getBgmMemoryBudget())) { return -1; }
+                        music.setGain(getSongGain(selectedSong));
+                        songClock.setSpeed(std::abs(practiceSpeed - 1.0f) < 0.001f ? 1.0f : practiceSpeed);
                         music.setVolume(config.bgmVolume);
-                        chart = loadChartFromMidi(selectedChart.chartPath);
+                        chart = loadChartFromMidi(selectedChart.chartPath, &chartSections, selectedChart.offset / 1000.0, &chartBeats);
                         if (chart.empty()) { return -1; }
+                        applyAssistTicks();
+                        if (config.keysounds) {
+                            keysoundBank.load(selectedSong, chart, sfxMixer);
+                        } else {
+                            keysoundBank.unload(sfxMixer);
+                        }
 
-                        menuMusic.stop(); // メニューBGMを停止
+                        songPreview.stop(sf::Time::Zero);
+                        audioAssets.stop(MusicCue::TITLE); // メニューBGMを停止
                         gameState = GameState::PLAYING;
                         score = 0;
                         combo = 0;
@@ -515,10 +983,12 @@ int main()
                         perfectCount = 0;
                         greatCount = 0;
                         missCount = 0;
+                        playAnalytics.reset(chartBeats);
                         hp = MAX_HP;
-                        nextNoteIndex = 0;
-                        activeNotes.clear();
-                        music.play();
+                        practiceSection = -1;
+                        applyChartTimingCorrection();
+                        applyPracticeSection();
+                        songClock.start(getSongLeadIn());
                     }
                     else if (event.key.code == sf::Keyboard::Escape)
                     {
@@ -533,7 +1003,7 @@ int main()
                     if (event.key.code == sf::Keyboard::Escape)
                     {
                         gameState = GameState::PAUSED;
-                        music.pause();
+                        songClock.pause();
                     }
                     else
                     {
@@ -546,8 +1016,9 @@ int main()
                                 {
                                     if (!note.isProcessed && note.laneIndex == i)
                                     {
-                                        float musicTime = music.getPlayingOffset().asSeconds() + (config.audioOffset / 1000.0f);
-                                        float diff = std::abs(musicTime - note.spawnTime);
+                                        float musicTime = songClock.getTime() + getTimingOffset() * songClock.getSpeed();
+                                        float error = (musicTime - note.spawnTime) / songClock.getSpeed(); // 判定幅は実時間で測る (プラスは遅れ)
+                                        float diff = std::abs(error);
 
                                         Judgment currentJudgment = Judgment::NONE;
                                         if (diff < PERFECT_WINDOW) {
@@ -576,21 +1047,16 @@ int main()
                                         if (currentJudgment != Judgment::NONE) {
                                             createParticleExplosion(particles, note.shape.getPosition()); // パーティクル生成
                                             laneFlashClocks[i].restart(); // 対応するレーンの時計をリスタート
-                                            tapSound.play();
+                                            if (!keysoundBank.play(sfxMixer, note)) {
+                                                sfxMixer.trigger(tapSound);
+                                            }
                                             note.isProcessed = true;
                                             keyProcessed = true;
-                                            if(currentJudgment == Judgment::PERFECT) {
-                                                judgmentText.setString("Perfect");
-                                                judgmentText.setFillColor(sf::Color::Cyan);
-                                            }
-                                            if(currentJudgment == Judgment::GREAT) {
-                                                judgmentText.setString("Great");
-                                                judgmentText.setFillColor(sf::Color::Yellow);
-                                            }
-                                            sf::FloatRect textRect = judgmentText.getLocalBounds();
-                                            judgmentText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-                                            judgmentText.setPosition(LANE_START_X + note.laneIndex * LANE_WIDTH + LANE_WIDTH / 2.f, JUDGMENT_LINE_Y - 100.f);
-                                            judgmentText.setScale(1.5f, 1.5f); // アニメーションの初期スケールを設定
+                                            // 補正を掛ける前のずれを学習する (再生速度を変えたプレイは使わない)
+                                            if (songClock.getSpeed() == 1.0f) hitOffsets.record(playingChartKey, error - chartTimingCorrection);
+                                            playAnalytics.recordHit(getChartTime(note.spawnTime), error, currentJudgment);
+                                            lastJudgment = currentJudgment;
+                                            lastJudgmentLane = note.laneIndex;
                                             judgmentClock.restart();
                                             break;
                                         }
@@ -608,23 +1074,24 @@ int main()
                 {
                     if (event.key.code == sf::Keyboard::Down)
                     {
-                        selectedPauseMenuIndex = (selectedPauseMenuIndex + 1) % pauseMenuTexts.size();
-                        menuNavigateSound.play();
+                        selectedPauseMenuIndex = (selectedPauseMenuIndex + 1) % pauseMenuItemCount;
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Up)
                     {
-                        selectedPauseMenuIndex = (selectedPauseMenuIndex + pauseMenuTexts.size() - 1) % pauseMenuTexts.size();
-                        menuNavigateSound.play();
+                        selectedPauseMenuIndex = (selectedPauseMenuIndex + pauseMenuItemCount - 1) % pauseMenuItemCount;
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Enter)
                     {
                         if (selectedPauseMenuIndex == 0) // Resume
                         {
                             gameState = GameState::PLAYING;
-                            music.play();
+                            songClock.resume();
                         }
-                        else if (selectedPauseMenuIndex == 1) // Retry
+                        else if (selectedPauseMenuIndex == 1 || selectedPauseMenuIndex == PAUSE_MENU_SECTION_INDEX) // Retry / 選んだ区間から練習
                         {
+                            if (courseActive && !loadCourse()) { return -1; } // コースは最初の曲からやり直す
                             gameState = GameState::PLAYING;
                             score = 0;
                             combo = 0;
@@ -632,24 +1099,34 @@ int main()
                             perfectCount = 0;
                             greatCount = 0;
                             missCount = 0;
+                            playAnalytics.reset(chartBeats);
                             hp = MAX_HP;
-                            nextNoteIndex = 0;
-                            activeNotes.clear();
                             music.stop();
                             music.setVolume(config.bgmVolume);
-                            music.play();
+                            applyChartTimingCorrection();
+                            applyPracticeSection();
+                            songClock.start(getSongLeadIn());
                         }
-                        else if (selectedPauseMenuIndex == 2) // Back to Select
+                        else if (selectedPauseMenuIndex == 3) // Back to Select
                         {
-                            gameState = GameState::SONG_SELECTION;
+                            gameState = courseActive ? GameState::COURSE_SELECTION : GameState::SONG_SELECTION;
                             music.stop();
-                            if (menuMusic.getStatus() != sf::Music::Playing) menuMusic.play();
+                            hitOffsets.save();
+                            audioAssets.crossfadeTo(MusicCue::TITLE, MUSIC_CROSSFADE_TIME);
                         }
                     }
+                    else if ((event.key.code == sf::Keyboard::Right || event.key.code == sf::Keyboard::Left) && selectedPauseMenuIndex == PAUSE_MENU_SECTION_INDEX && !courseActive)
+                    {
+                        // 曲全体 (-1) と各区間を順に切り替える
+                        int count = static_cast<int>(chartSections.size()) + 1;
+                        int step = event.key.code == sf::Keyboard::Right ? 1 : count - 1;
+                        practiceSection = (practiceSection + 1 + step) % count - 1;
+                        sfxMixer.trigger(menuNavigateSound);
+                    }
                     else if (event.key.code == sf::Keyboard::Escape)
                     {
                         gameState = GameState::PLAYING;
-                        music.play();
+                        songClock.resume();
                     }
                 }
             }
@@ -660,18 +1137,19 @@ int main()
                     if (event.key.code == sf::Keyboard::Down)
                     {
                         selectedPauseMenuIndex = (selectedPauseMenuIndex + 1) % gameoverMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Up)
                     {
                         selectedPauseMenuIndex = (selectedPauseMenuIndex + gameoverMenuTexts.size() - 1) % gameoverMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     }
                     else if (event.key.code == sf::Keyboard::Enter)
                         {
-                            gameoverMusic.stop();
                             if (selectedPauseMenuIndex == 0) // Retry
                             {
+                            audioAssets.stop(MusicCue::GAMEOVER);
+                            if (courseActive && !loadCourse()) { return -1; }
                             gameState = GameState::PLAYING;
                             score = 0;
                             combo = 0;
@@ -679,18 +1157,19 @@ int main()
                             perfectCount = 0;
                             greatCount = 0;
                             missCount = 0;
+                            playAnalytics.reset(chartBeats);
                             hp = MAX_HP;
-                            nextNoteIndex = 0;
-                            activeNotes.clear();
                             music.stop();
                             music.setVolume(config.bgmVolume);
-                            music.play();
+                            applyChartTimingCorrection();
+                            applyPracticeSection();
+                            songClock.start(getSongLeadIn());
                         }
                         else if (selectedPauseMenuIndex == 1) // Back to Select
                         {
-                            gameState = GameState::SONG_SELECTION;
+                            gameState = courseActive ? GameState::COURSE_SELECTION : GameState::SONG_SELECTION;
                             music.stop();
-                            if (menuMusic.getStatus() != sf::Music::Playing) menuMusic.play();
+                            audioAssets.crossfadeTo(MusicCue::TITLE, MUSIC_CROSSFADE_TIME);
                         }
                     }
                 }
@@ -700,13 +1179,14 @@ int main()
                 if (event.type == sf::Event::KeyPressed) {
                     if (event.key.code == sf::Keyboard::Right) {
                         selectedResultsMenuIndex = (selectedResultsMenuIndex + 1) % resultsMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     } else if (event.key.code == sf::Keyboard::Left) {
                         selectedResultsMenuIndex = (selectedResultsMenuIndex + resultsMenuTexts.size() - 1) % resultsMenuTexts.size();
-                        menuNavigateSound.play();
+                        sfxMixer.trigger(menuNavigateSound);
                     } else if (event.key.code == sf::Keyboard::Enter) {
                         if (selectedResultsMenuIndex == 0) { // Retry
-                            resultsMusic.stop();
+                            audioAssets.stop(MusicCue::RESULTS);
+                            if (courseActive && !loadCourse()) { return -1; }
                             gameState = GameState::PLAYING;
                             score = 0;
                             combo = 0;
@@ -714,16 +1194,16 @@ int main()
                             perfectCount = 0;
                             greatCount = 0;
                             missCount = 0;
+                            playAnalytics.reset(chartBeats);
                             hp = MAX_HP;
-                            nextNoteIndex = 0;
-                            activeNotes.clear();
                             music.stop();
                             music.setVolume(config.bgmVolume);
-                            music.play();
+                            applyChartTimingCorrection();
+                            applyPracticeSection();
+                            songClock.start(getSongLeadIn());
                         } else if (selectedResultsMenuIndex == 1) { // Back to Select
-                            resultsMusic.stop();
-                            gameState = GameState::SONG_SELECTION;
-                            if (menuMusic.getStatus() != sf::Music::Playing) menuMusic.play();
+                            gameState = courseActive ? GameState::COURSE_SELECTION : GameState::SONG_SELECTION;
+                            audioAssets.crossfadeTo(MusicCue::TITLE, MUSIC_CROSSFADE_TIME);
                         }
                     }
                 }
@@ -769,12 +1249,50 @@ int main()
             ss_offset << std::fixed << std::setprecision(0) << config.audioOffset << " ms";
             optionValueTexts[3].setString(ss_offset.str());
 
+            optionValueTexts[4].setString(config.dynamicResolution ? "On" : "Off");
+            optionValueTexts[5].setString(getFrameRateChoiceLabel(config));
+            optionValueTexts[6].setString(config.keysounds ? "On" : "Off");
+            optionValueTexts[7].setString(getAssistTickModeLabel(config.assistTicks));
+            optionValueTexts[8].setString("Enter");
+
             for(size_t i = 0; i < optionValueTexts.size(); ++i) {
                 textRect = optionValueTexts[i].getLocalBounds();
                 optionValueTexts[i].setOrigin(textRect.left + textRect.width, textRect.top);
                 optionValueTexts[i].setPosition(optionMenuTexts[i].getPosition().x + 800.f, optionMenuTexts[i].getPosition().y); // 450 -> 800
             }
         }
+        else if (gameState == GameState::CALIBRATION)
+        {
+            double calibrationTime = songClock.getTime();
+            if (!calibrationFinished && calibrationTime >= calibrator.getEndTime()) {
+                calibrationResult = calibrator.compute();
+                calibrationFinished = true;
+                stopCalibration();
+            }
+
+            std::ostringstream status;
+            status << std::fixed << std::setprecision(0) << std::showpos;
+            if (!calibrationFinished) {
+                calibrationHelpText.setString(calibrationTime < CALIBRATION_COUNT_IN * CALIBRATION_INTERVAL.asSeconds() - CALIBRATION_INTERVAL.asSeconds() / 2
+                    ? "Listen to the clicks..." : "Tap a lane key or Space on each click (Esc to cancel)");
+                status << std::noshowpos << "Taps: " << calibrator.getTapCount() << " / " << CALIBRATION_TAPS;
+                if (calibrator.getTapCount() > 0) status << std::showpos << "    Last: " << calibrator.getLastError() << " ms";
+            } else if (calibrationResult.valid) {
+                calibrationHelpText.setString("Enter to apply, Space to retry, Esc to cancel");
+                status << "Offset: " << calibrationResult.offset << " ms" << std::noshowpos << "  (+/-" << calibrationResult.spread << " ms, "
+                       << calibrationResult.rejected << " rejected)";
+            } else {
+                calibrationHelpText.setString("Space to retry, Esc to cancel");
+                status << std::noshowpos << "Not enough taps (" << calibrationResult.used << " / " << CALIBRATION_MIN_TAPS << ")";
+            }
+            calibrationStatusText.setString(status.str());
+            textRect = calibrationHelpText.getLocalBounds();
+            calibrationHelpText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+            calibrationHelpText.setPosition(WINDOW_WIDTH / 2.0f, 450.f);
+            textRect = calibrationStatusText.getLocalBounds();
+            calibrationStatusText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+            calibrationStatusText.setPosition(WINDOW_WIDTH / 2.0f, 600.f);
+        }
         else if (gameState == GameState::SONG_SELECTION)
         {
             for(size_t i = 0; i < songTitleTexts.size(); ++i)
@@ -788,6 +1306,24 @@ int main()
                     songTitleTexts[i].setFillColor(sf::Color::White);
                 }
             }
+
+            // カーソルが止まったら試聴を始める
+            songPreview.select(songs[selectedSongIndex], getSongGain(songs[selectedSongIndex]));
+            songPreview.update();
+        }
+        else if (gameState == GameState::COURSE_SELECTION)
+        {
+            for(size_t i = 0; i < courseTitleTexts.size(); ++i)
+            {
+                if(i == selectedCourseIndex)
+                {
+                    courseTitleTexts[i].setFillColor(sf::Color::Yellow);
+                }
+                else
+                {
+                    courseTitleTexts[i].setFillColor(sf::Color::White);
+                }
+            }
         }
         else if (gameState == GameState::DIFFICULTY_SELECTION)
         {
@@ -802,6 +1338,7 @@ int main()
                     difficultyTexts[i].setFillColor(sf::Color::White);
                 }
             }
+            songPreview.update();
 
             // ハイスコア表示
             const auto& selectedSong = songs[selectedSongIndex];
@@ -812,20 +1349,40 @@ int main()
             textRect = difficultyHighScoreText.getLocalBounds();
             difficultyHighScoreText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
             difficultyHighScoreText.setPosition(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 200.f); // 150 -> 200
+
+            std::ostringstream speedStream;
+            speedStream << std::fixed << std::setprecision(2) << "< Speed x" << practiceSpeed << " >";
+            if (std::abs(practiceSpeed - 1.0f) >= 0.001f) speedStream << "  (Practice)";
+            practiceSpeedText.setString(speedStream.str());
+            practiceSpeedText.setFillColor(std::abs(practiceSpeed - 1.0f) < 0.001f ? sf::Color::White : sf::Color(100, 200, 255));
+            textRect = practiceSpeedText.getLocalBounds();
+            practiceSpeedText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+            practiceSpeedText.setPosition(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 280.f);
+
+            // 曲全体の波形 (1ピクセルごとにピークのピラミッドから引く)
+            if (songPeaks && songPeaks->isReady() && songWaveformSource != songPeaks.get()) {
+                songWaveformSource = songPeaks.get();
+                songWaveform.clear();
+                const int columns = static_cast<int>(WAVEFORM_PREVIEW_AREA.width);
+                const double duration = songPeaks->getDuration();
+                const float halfHeight = WAVEFORM_PREVIEW_AREA.height / 2.f;
+                const float centerY = WAVEFORM_PREVIEW_AREA.top + halfHeight;
+                for (int x = 0; x < columns; ++x) {
+                    float minimum, maximum;
+                    songPeaks->query(duration * x / columns, duration * (x + 1) / columns, minimum, maximum);
+                    float columnX = WAVEFORM_PREVIEW_AREA.left + x + 0.5f;
+                    songWaveform.append(sf::Vertex(sf::Vector2f(columnX, centerY - maximum * halfHeight), WAVEFORM_PREVIEW_COLOR));
+                    songWaveform.append(sf::Vertex(sf::Vector2f(columnX, centerY - minimum * halfHeight + 1.f), WAVEFORM_PREVIEW_COLOR));
+                }
+            }
         }
         else if (gameState == GameState::PAUSED)
         {
-            for(size_t i = 0; i < pauseMenuTexts.size(); ++i)
-            {
-                if(i == selectedPauseMenuIndex)
-                {
-                    pauseMenuTexts[i].setFillColor(sf::Color::Yellow);
-                }
-                else
-                {
-                    pauseMenuTexts[i].setFillColor(sf::Color::White);
-                }
-            }
+            // ポーズ中はプレイ画面を止めたままメニューだけ更新する
+            snapshot.paused = true;
+            snapshot.selectedPauseMenuIndex = selectedPauseMenuIndex;
+            snapshot.practiceSectionLabel = practiceSection >= 0 ? chartSections[practiceSection].name : "All";
+            snapshot.judgmentTime = judgmentClock.getElapsedTime().asSeconds();
         }
         else if (gameState == GameState::GAMEOVER)
         {
@@ -866,12 +1423,35 @@ int main()
         }
         else if (gameState == GameState::PLAYING)
         {
-            float adjustedMusicTime = music.getPlayingOffset().asSeconds() + (config.audioOffset / 1000.0f);
+            // 音の遅れの補正 (実時間) は曲中の時間に直して足す
+            double songTime = songClock.getTime();
+            float adjustedMusicTime = songTime + getTimingOffset() * songClock.getSpeed();
+
+            // 練習区間のループで先頭に戻ったら、次の周の分として先に出しておいたノーツの時刻を1周分戻す
+            // (出ているノーツは消さないので、区間の頭のノーツも上から落ちてくる)
+            if (practiceSection >= 0 && songTime < previousSongTime - 0.5) {
+                if (practiceLoopLength > 0.0) {
+                    for (auto& note : activeNotes) note.spawnTime -= practiceLoopLength;
+                    spawnShift -= practiceLoopLength;
+                } else {
+                    seekChart(songClock.getSectionStart());
+                }
+            }
+            previousSongTime = songTime;
 
             // ノーツの出現
-            float fallTime = JUDGMENT_LINE_Y / (NOTE_PIXELS_PER_SECOND * config.noteSpeedMultiplier);
-            while (nextNoteIndex < chart.size() && chart[nextNoteIndex].spawnTime < adjustedMusicTime + fallTime) {
+            float scrollSpeed = getScrollSpeed();
+            float fallTime = JUDGMENT_LINE_Y / scrollSpeed;
+            for (;;) {
+                if (practiceSection >= 0 && (nextNoteIndex >= chart.size() || (practiceEnd > 0.0 && chart[nextNoteIndex].spawnTime >= practiceEnd))) {
+                    // 区間の終わりまで出したら、次の周のノーツを区間の長さだけ後ろにずらして続けて出す
+                    if (practiceLoopLength <= 0.0 || practiceStartIndex >= nextNoteIndex) break; // 区間にノーツがない
+                    nextNoteIndex = practiceStartIndex;
+                    spawnShift += practiceLoopLength;
+                }
+                if (nextNoteIndex >= chart.size() || chart[nextNoteIndex].spawnTime + spawnShift >= adjustedMusicTime + fallTime) break;
                 activeNotes.push_back(chart[nextNoteIndex]);
+                activeNotes.back().spawnTime += spawnShift;
                 nextNoteIndex++;
             }
 
@@ -879,21 +1459,18 @@ int main()
             for (auto& note : activeNotes) {
                 if (!note.isProcessed) {
                     float timeUntilJudgment = note.spawnTime - adjustedMusicTime;
-                    float newY = JUDGMENT_LINE_Y - (timeUntilJudgment * (NOTE_PIXELS_PER_SECOND * config.noteSpeedMultiplier));
+                    float newY = JUDGMENT_LINE_Y - (timeUntilJudgment * scrollSpeed);
                     note.shape.setPosition(note.shape.getPosition().x, newY);
 
-                    if (timeUntilJudgment < -GREAT_WINDOW) {
+                    if (timeUntilJudgment < -GREAT_WINDOW * songClock.getSpeed()) {
                         note.isProcessed = true;
                         combo = 0;
                         missCount++;
+                        playAnalytics.recordMiss(getChartTime(note.spawnTime));
                         hp -= 10; // HP減少
-                        missSound.play();
-                        judgmentText.setString("Miss");
-                        judgmentText.setFillColor(sf::Color::Red);
-                        sf::FloatRect textRect = judgmentText.getLocalBounds();
-                        judgmentText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-                        judgmentText.setPosition(LANE_START_X + note.laneIndex * LANE_WIDTH + LANE_WIDTH / 2.f, JUDGMENT_LINE_Y - 100.f);
-                        judgmentText.setScale(1.5f, 1.5f); // アニメーションの初期スケールを設定
+                        sfxMixer.trigger(missSound);
+                        lastJudgment = Judgment::MISS;
+                        lastJudgmentLane = note.laneIndex;
                         judgmentClock.restart();
                     }
                 }
@@ -907,99 +1484,93 @@ int main()
                 activeNotes.end()
             );
 
-            for (int i = 0; i < LANE_COUNT; ++i) {
-                if (laneFlashClocks[i].getElapsedTime().asSeconds() < 0.1f) {
-                    lanes[i].setFillColor(sf::Color::White); // ヒットした瞬間は白く光る
-                } else if (sf::Keyboard::isKeyPressed(LANE_KEYS[i])) {
-                    lanes[i].setFillColor(LANE_COLOR_PRESSED); // キーが押されている間は黄色
+            // パーティクルの更新
+            for (auto it = particles.begin(); it != particles.end();) {
+                it->lifetime -= sf::seconds(deltaTime); // フレーム時間
+                if (it->lifetime <= sf::Time::Zero) {
+                    it = particles.erase(it);
                 } else {
-                    lanes[i].setFillColor(LANE_COLOR_NORMAL); // 通常時は半透明の黒
+                    it->shape.move(it->velocity * deltaTime);
+                    it->velocity.y += 200.f * deltaTime; // 重力
+                    ++it;
                 }
             }
 
-            scoreText.setString("Score: " + std::to_string(score));
-            if (combo > 2) {
-                comboText.setString(std::to_string(combo));
-                if (combo >= 20) { // 100から変更
-                    comboText.setFillColor(sf::Color::Magenta);
-                    comboText.setCharacterSize(80); // 52 -> 80
-                } else if (combo >= 10) { // 50から変更
-                    comboText.setFillColor(sf::Color(255, 165, 0)); // Orange
-                    comboText.setCharacterSize(76); // 48 -> 76
-                } else {
-                    comboText.setFillColor(sf::Color::White);
-                    comboText.setCharacterSize(72); // 44 -> 72
+            // --- 描画用スナップショットの作成 ---
+            snapshot.paused = false;
+            snapshot.leadInRemaining = static_cast<float>(std::max(0.0, songClock.getSectionStart() - songTime) / songClock.getSpeed());
+            snapshot.notes.clear();
+            for (const auto& note : activeNotes) {
+                if (!note.isProcessed) {
+                    NoteSnapshot noteSnapshot;
+                    noteSnapshot.laneIndex = note.laneIndex;
+                    noteSnapshot.y = note.shape.getPosition().y;
+                    snapshot.notes.push_back(noteSnapshot);
                 }
-                sf::FloatRect textRect = comboText.getLocalBounds();
-                comboText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-                comboText.setPosition(LANE_START_X + LANE_AREA_WIDTH / 2.f, JUDGMENT_LINE_Y - 50.f);
-            }
-
-            // 判定テキストのアニメーション
-            const float animationDuration = 0.2f; // アニメーションの時間（秒）
-            float elapsed = judgmentClock.getElapsedTime().asSeconds();
-            if (elapsed < animationDuration) {
-                float scale = 1.5f - (0.5f * (elapsed / animationDuration));
-                judgmentText.setScale(scale, scale);
-            } else {
-                judgmentText.setScale(1.0f, 1.0f);
             }
-
-            // コンボテキストのアニメーション
-            const float comboAnimationDuration = 0.2f;
-            float comboElapsed = comboAnimationClock.getElapsedTime().asSeconds();
-            if (comboElapsed < comboAnimationDuration) {
-                float scale = 1.5f - (0.5f * (comboElapsed / comboAnimationDuration));
-                comboText.setScale(scale, scale);
-            } else {
-                comboText.setScale(1.0f, 1.0f);
+            snapshot.particles.clear();
+            for (const auto& p : particles) {
+                ParticleSnapshot particleSnapshot;
+                particleSnapshot.position = p.shape.getPosition();
+                particleSnapshot.radius = p.shape.getRadius();
+                particleSnapshot.color = p.shape.getFillColor();
+                snapshot.particles.push_back(particleSnapshot);
             }
-
-            // パーティクルの更新
-            for (auto it = particles.begin(); it != particles.end();) {
-                it->lifetime -= sf::seconds(1.f / 120.f); // フレーム時間
-                if (it->lifetime <= sf::Time::Zero) {
-                    it = particles.erase(it);
+            for (int i = 0; i < LANE_COUNT; ++i) {
+                if (laneFlashClocks[i].getElapsedTime().asSeconds() < 0.1f) {
+                    snapshot.laneColors[i] = sf::Color::White; // ヒットした瞬間は白く光る
+                } else if (sf::Keyboard::isKeyPressed(LANE_KEYS[i])) {
+                    snapshot.laneColors[i] = LANE_COLOR_PRESSED; // キーが押されている間は黄色
                 } else {
-                    it->shape.move(it->velocity * (1.f / 120.f));
-                    it->velocity.y += 200.f * (1.f / 120.f); // 重力
-                    ++it;
+                    snapshot.laneColors[i] = LANE_COLOR_NORMAL; // 通常時は半透明の黒
                 }
             }
-
-            // HPゲージの更新
-            float hpRatio = static_cast<float>(hp) / MAX_HP;
-            hpGauge.setSize(sf::Vector2f(300 * hpRatio, 20));
-            if (hpRatio > 0.5f) {
-                hpGauge.setFillColor(sf::Color::Green);
-            } else if (hpRatio > 0.2f) {
-                hpGauge.setFillColor(sf::Color::Yellow);
-            } else {
-                hpGauge.setFillColor(sf::Color::Red);
+            snapshot.score = score;
+            snapshot.combo = combo;
+            snapshot.comboAnimationTime = comboAnimationClock.getElapsedTime().asSeconds();
+            snapshot.judgment = lastJudgment;
+            snapshot.judgmentLane = lastJudgmentLane;
+            snapshot.judgmentTime = judgmentClock.getElapsedTime().asSeconds();
+            snapshot.hpRatio = static_cast<float>(hp) / MAX_HP;
+            snapshot.showSpectrum = config.spectrumVisualizer;
+            if (config.spectrumVisualizer) spectrumAnalyzer.getBands(snapshot.spectrum);
+
+            // コース: 次の曲の準備ができたら空いている方のチャンネルに開いておき、譜面を終えたら移る
+            if (courseActive && courseIndex + 1 < courseLength) {
+                if (!nextCourseSong) {
+                    nextCourseSong = coursePrefetcher.take();
+                    if (nextCourseSong && (nextCourseSong->chart.empty() ||
+                        !music.openNext(std::move(nextCourseSong->source), nextCourseSong->audioPath, nextCourseSong->inMemory))) {
+                        nextCourseSong.reset();
+                        courseLength = courseIndex + 1; // 読めなかった曲から先は遊ばない
+                    }
+                }
+                if (nextCourseSong && hp > 0 && nextNoteIndex >= chart.size() && activeNotes.empty()) {
+                    switchCourseSong();
+                }
             }
 
             // ゲームオーバーまたは曲の終了を検知
             if (hp <= 0) {
                 music.stop();
-                gameoverMusic.openFromFile("audio/failsound.ogg");
-                gameoverMusic.setVolume(config.bgmVolume);
-                gameoverMusic.play();
+                audioAssets.play(MusicCue::GAMEOVER);
                 gameState = GameState::GAMEOVER;
-            } else if (music.getStatus() == sf::Music::Stopped && activeNotes.empty())
+                hitOffsets.save();
+            } else if (music.getStatus() == sf::SoundSource::Stopped && activeNotes.empty() &&
+                       (!courseActive || courseIndex + 1 >= courseLength))
             {
                 music.stop();
-                resultsMusic.openFromFile("audio/result.ogg");
-                resultsMusic.setVolume(config.bgmVolume);
-                resultsMusic.play();
+                audioAssets.play(MusicCue::RESULTS);
                 fadeClock.restart();
                 gameState = GameState::RESULTS;
+                hitOffsets.save();
 
                 // ハイスコアのチェックと更新
                 const auto& selectedSong = songs[selectedSongIndex];
                 const auto& selectedChart = selectedSong.charts[selectedDifficultyIndex];
-                std::string key = generateHighScoreKey(selectedSong, selectedChart);
+                std::string key = courseActive ? generateCourseHighScoreKey(courses[selectedCourseIndex]) : generateHighScoreKey(selectedSong, selectedChart);
                 int oldHighScore = highScores.count(key) ? highScores.at(key) : 0;
-                bool isNewRecord = score > oldHighScore;
+                bool isNewRecord = score > oldHighScore && songClock.getSpeed() == 1.0f && practiceSection < 0; // 練習は記録しない
                 if (isNewRecord) {
                     highScores[key] = score;
                     saveHighScores(highScores);
@@ -1046,7 +1617,7 @@ int main()
                 }
 
                 // ランク計算
-                int maxScore = chart.size() * 100;
+                int maxScore = (courseActive ? courseNoteCount : chart.size()) * 100;
                 float scoreRatio = (maxScore > 0) ? static_cast<float>(score) / maxScore : 0.0f;
                 std::string rankString;
                 sf::Color rankColor;
@@ -1061,14 +1632,41 @@ int main()
                 textRect = rankText.getLocalBounds();
                 rankText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
                 rankText.setPosition(WINDOW_WIDTH * 0.8f, 250.f); // 0.75, 150 -> 0.8, 250
+
+                resultsGraphs.build(playAnalytics, font);
             }
         }
 
+        // スペクトルはゲームプレイ中にしか出さないので、FFT もその間だけ回す
+        bool useSpectrum = config.spectrumVisualizer &&
+                           (gameState == GameState::PLAYING || gameState == GameState::PAUSED);
+        if (useSpectrum != spectrumAnalyzer.isRunning()) {
+            if (useSpectrum) spectrumAnalyzer.start();
+            else spectrumAnalyzer.stop();
+        }
+
         // --- 描画処理 ---
+        // ゲームプレイ中は描画スレッドに任せ、こちらは入力と判定だけを回す
+        bool useRenderThread = config.renderThread && window.isOpen() &&
+                               (gameState == GameState::PLAYING || gameState == GameState::PAUSED);
+        if (!useRenderThread && renderThread.isRunning()) {
+            renderThread.stop();
+        }
+        if (useRenderThread) {
+            renderThread.publish(snapshot);
+            if (!renderThread.isRunning()) {
+                renderThread.start();
+            }
+            sf::sleep(GAME_TICK_INTERVAL);
+            continue;
+        }
+
+        imageLoader.pumpUploads(TEXTURE_UPLOAD_BUDGET);
         window.clear(sf::Color::Black);
 
         if (gameState == GameState::TITLE)
         {
+            titleBackground->bind(titleBackgroundSprite);
             window.draw(titleBackgroundSprite);
             window.draw(titleText);
             for(const auto& text : titleMenuTexts) {
@@ -1086,6 +1684,12 @@ int main()
             }
             window.draw(optionsHelpText);
         }
+        else if (gameState == GameState::CALIBRATION)
+        {
+            window.draw(calibrationTitle);
+            window.draw(calibrationHelpText);
+            window.draw(calibrationStatusText);
+        }
         else if (gameState == GameState::SONG_SELECTION)
         {
             window.draw(songSelectionTitle);
@@ -1093,6 +1697,13 @@ int main()
                 window.draw(text);
             }
         }
+        else if (gameState == GameState::COURSE_SELECTION)
+        {
+            window.draw(courseSelectionTitle);
+            for(const auto& text : courseTitleTexts) {
+                window.draw(text);
+            }
+        }
         else if (gameState == GameState::DIFFICULTY_SELECTION)
         {
             window.draw(difficultySelectionTitle);
@@ -1100,59 +1711,18 @@ int main()
                 window.draw(text);
             }
             window.draw(difficultyHighScoreText);
-        }
-        else if (gameState == GameState::PLAYING)
-        {
-            window.draw(backgroundSprite);
-            for (const auto& lane : lanes) { window.draw(lane); }
-            window.draw(judgmentLine);
-            for (const auto& note : activeNotes) {
-                if (note.shape.getPosition().y > -NOTE_HEIGHT && note.shape.getPosition().y < WINDOW_HEIGHT) {
-                     if (!note.isProcessed) {
-                        window.draw(note.shape);
-                     }
-                }
+            window.draw(practiceSpeedText);
+            if (songWaveformSource == songPeaks.get()) {
+                window.draw(songWaveform);
             }
-            window.draw(scoreText);
-            if (combo > 2) { window.draw(comboText); }
-            if (judgmentClock.getElapsedTime().asSeconds() < 0.5f) {
-                window.draw(judgmentText);
-            }
-            for (const auto& p : particles) {
-                window.draw(p.shape);
-            }
-            window.draw(hpGaugeBg);
-            window.draw(hpGauge);
         }
-        else if (gameState == GameState::PAUSED)
+        else if (gameState == GameState::PLAYING || gameState == GameState::PAUSED)
         {
-            // ポーズ中はプレイ画面を背景として描画
-            window.draw(backgroundSprite);
-            for (const auto& lane : lanes) { window.draw(lane); }
-            window.draw(judgmentLine);
-            for (const auto& note : activeNotes) {
-                if (note.shape.getPosition().y > -NOTE_HEIGHT && note.shape.getPosition().y < WINDOW_HEIGHT) {
-                    window.draw(note.shape);
-                }
-            }
-            window.draw(scoreText);
-            if (combo > 2) { window.draw(comboText); }
-            if (judgmentClock.getElapsedTime().asSeconds() < 0.5f) {
-                window.draw(judgmentText);
-            }
-
-            window.draw(hpGaugeBg);
-            window.draw(hpGauge);
-
-            // オーバーレイとメニューを描画
-            window.draw(pauseOverlay);
-            window.draw(pauseTitle);
-            for(const auto& text : pauseMenuTexts) {
-                window.draw(text);
-            }
+            gameplayRenderer.draw(window, snapshot);
         }
         else if (gameState == GameState::GAMEOVER)
         {
+            songBackground->bind(backgroundSprite);
             window.draw(backgroundSprite);
             window.draw(pauseOverlay); // ポーズ画面と同じオーバーレイを使いまわす
             window.draw(gameoverTitle);
@@ -1162,6 +1732,7 @@ int main()
         }
         else if (gameState == GameState::RESULTS)
         {
+            resultBackground->bind(resultBackgroundSprite);
             window.draw(resultBackgroundSprite);
             window.draw(resultsTitle);
             window.draw(finalScoreText);
@@ -1171,14 +1742,26 @@ int main()
             window.draw(missCountText);
             window.draw(newRecordText);
             window.draw(rankText);
+            resultsGraphs.draw(window);
             for(const auto& text : resultsMenuTexts) {
                 window.draw(text);
             }
             window.draw(fadeOverlay); // 最後にフェードを描画
         }
-        
+
+        if (showPerformanceOverlay) {
+            gameplayRenderer.drawPerformanceOverlay(window, framePacer);
+        }
+
+        // 描画の負荷が高いときはゲームプレイの解像度を下げる
+        if (gameState == GameState::PLAYING) {
+            gameplayRenderer.reportFrameTime(frameClock.getElapsedTime());
+        }
+
         window.display();
+        framePacer.endFrame();
     }
 
+    hitOffsets.save(); // 曲の途中で閉じた分
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "music_source.hpp"
+#include <algorithm>
+#include <cstring>
+
+bool MusicSource::open(const std::string& path, sf::Time headDuration, sf::Time headStart, const std::function<bool()>& cancelled) {
+    if (!file.openFromFile(path)) return false;
+    channelCount = file.getChannelCount();
+    sampleRate = file.getSampleRate();
+    totalSampleCount = file.getSampleCount();
+
+    headOffset = std::min(static_cast<sf::Uint64>(headStart.asSeconds() * sampleRate) * channelCount, totalSampleCount);
+    if (headOffset > 0) file.seek(headOffset);
+    sf::Uint64 headSampleCount = static_cast<sf::Uint64>(headDuration.asSeconds() * sampleRate) * channelCount;
+    headSampleCount = std::min(headSampleCount, totalSampleCount - headOffset);
+    head.resize(static_cast<size_t>(headSampleCount));
+
+    // 取りやめられるよう、少しずつ読む
+    const size_t slice = static_cast<size_t>(sampleRate / 2) * channelCount;
+    size_t filled = 0;
+    while (filled < head.size()) {
+        if (cancelled && cancelled()) return false;
+        size_t read = static_cast<size_t>(file.read(head.data() + filled, std::min(slice, head.size() - filled)));
+        if (read == 0) break;
+        filled += read;
+    }
+    head.resize(filled);
+
+    position = 0;
+    fileNeedsSeek = false; // ファイルはちょうど head の直後を指している
+    return true;
+}
+
+void MusicSource::openSamples(std::vector<sf::Int16> samples, unsigned int sourceChannelCount, unsigned int sourceSampleRate) {
+    // 開いていない InputSoundFile は何も読まないので、head を読み終えたところで終端になる
+    head = std::move(samples);
+    headOffset = 0;
+    position = 0;
+    fileNeedsSeek = false;
+    channelCount = sourceChannelCount;
+    sampleRate = sourceSampleRate;
+    totalSampleCount = head.size();
+}
+
+size_t MusicSource::read(sf::Int16* out, size_t sampleCount) {
+    size_t written = 0;
+    if (position < head.size()) {
+        written = std::min(sampleCount, head.size() - position);
+        std::memcpy(out, head.data() + position, written * sizeof(sf::Int16));
+        position += written;
+    }
+    if (written < sampleCount) {
+        if (fileNeedsSeek) {
+            file.seek(fileSeekOffset);
+            fileNeedsSeek = false;
+        }
+        written += static_cast<size_t>(file.read(out + written, sampleCount - written));
+    }
+    return written;
+}
+
+void MusicSource::seek(sf::Uint64 frameOffset) {
+    sf::Uint64 sampleOffset = std::min(frameOffset * channelCount, totalSampleCount);
+    if (sampleOffset >= headOffset && sampleOffset - headOffset < head.size()) {
+        // 先頭部分を読み終えたらファイルは head の直後から続ける
+        position = static_cast<size_t>(sampleOffset - headOffset);
+        fileSeekOffset = headOffset + head.size();
+    } else {
+        position = head.size();
+        fileSeekOffset = sampleOffset;
+    }
+    fileNeedsSeek = true;
+}
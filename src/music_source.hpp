@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+// --- 先頭を展開済みの音楽ソース ---
+// ファイルを開いてデコーダを初期化し、先頭 headDuration 分を PCM で持っておく。
+// (「先頭」は曲の頭とは限らない。試聴では試聴区間の頭から展開する)
+// 再生開始時はメモリの先頭から返すだけなので、ファイルを開く・シークする重い処理は
+// 画面遷移のフレームではなく、先頭を読み終えた後のストリームスレッドで行われる。
+// スレッドセーフではない。open() 以外は再生側のスレッドだけから呼ぶこと。
+class MusicSource {
+public:
+    // headStart から headDuration 分を展開しておく (試聴のように途中から鳴らす場合)。
+    // cancelled が true を返したら展開を途中でやめて false を返す
+    bool open(const std::string& path, sf::Time headDuration, sf::Time headStart = sf::Time::Zero,
+              const std::function<bool()>& cancelled = nullptr);
+    // 作った PCM をそのまま鳴らす (キャリブレーションのクリックなど)。ファイルは開かない
+    void openSamples(std::vector<sf::Int16> samples, unsigned int channelCount, unsigned int sampleRate);
+
+    // 最大 sampleCount サンプル (チャンネル込み) を書き出し、書いた数を返す。0 なら終端
+    size_t read(sf::Int16* out, size_t sampleCount);
+    // 先頭に戻す。ファイル側のシークは次にファイルを読むときまで遅らせる
+    void rewind() { seek(0); }
+    // frameOffset フレーム目に移る。先頭部分の中ならメモリ上で済む
+    void seek(sf::Uint64 frameOffset);
+
+    unsigned int getChannelCount() const { return channelCount; }
+    unsigned int getSampleRate() const { return sampleRate; }
+    sf::Uint64 getSampleCount() const { return totalSampleCount; }
+
+private:
+    sf::InputSoundFile file;
+    std::vector<sf::Int16> head;
+    sf::Uint64 headOffset = 0;    // head の先頭のサンプル (チャンネル込み)
+    size_t position = 0;          // 先頭部分を読んだ位置
+    bool fileNeedsSeek = false;   // ファイルの読み位置を fileSeekOffset に動かす必要があるか
+    sf::Uint64 fileSeekOffset = 0; // サンプル (チャンネル込み)
+    unsigned int channelCount = 0;
+    unsigned int sampleRate = 0;
+    sf::Uint64 totalSampleCount = 0;
+};
@@ -0,0 +1,62 @@
+#include "play_analytics.hpp"
+#include <algorithm>
+#include <cmath>
+
+void PlayAnalytics::RunningStats::add(double value) {
+    ++count;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+double PlayAnalytics::RunningStats::getStdDev() const {
+    return count > 1 ? std::sqrt(m2 / (count - 1)) : 0.0;
+}
+
+float PlayAnalytics::BarStats::getAccuracy() const {
+    int noteCount = getNoteCount();
+    if (noteCount == 0) return -1.f;
+    return (perfect + 0.5f * great) / noteCount;
+}
+
+void PlayAnalytics::reset(const std::vector<ChartBeat>& beats) {
+    histogram.fill(0);
+    errorStats = RunningStats();
+    bars.clear();
+    addChart(beats);
+}
+
+void PlayAnalytics::addChart(const std::vector<ChartBeat>& beats) {
+    barStarts.clear();
+    for (const auto& beat : beats) {
+        if (beat.downbeat) barStarts.push_back(beat.time);
+    }
+    barBase = bars.size();
+    // 拍の取れない譜面は1曲を1小節として数える
+    bars.resize(barBase + std::max<size_t>(1, barStarts.size()));
+}
+
+PlayAnalytics::BarStats& PlayAnalytics::findBar(double noteTime) {
+    // 最初の小節の頭より前のノーツ (弱起) は最初の小節に入れる
+    size_t index = std::upper_bound(barStarts.begin(), barStarts.end(), noteTime) - barStarts.begin();
+    if (index > 0) --index;
+    return bars[barBase + index];
+}
+
+void PlayAnalytics::recordHit(double noteTime, double error, Judgment judgment) {
+    BarStats& bar = findBar(noteTime);
+    if (judgment == Judgment::PERFECT) {
+        ++bar.perfect;
+    } else {
+        ++bar.great;
+    }
+    bar.error.add(error);
+    errorStats.add(error);
+
+    int bin = static_cast<int>(std::floor((error + GREAT_WINDOW) / (2.0 * GREAT_WINDOW) * TIMING_HISTOGRAM_BINS));
+    ++histogram[std::min(std::max(bin, 0), TIMING_HISTOGRAM_BINS - 1)];
+}
+
+void PlayAnalytics::recordMiss(double noteTime) {
+    ++findBar(noteTime).miss;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "constants.hpp"
+#include "types.hpp"
+
+// --- プレイの分析 ---
+// リザルト画面に出すため、判定したノーツごとの符号付きのずれ (実時間、プラスは遅れ) を
+// ±GREAT_WINDOW を等分した固定のヒストグラムに数え、小節ごとの判定の数とずれの平均・分散を持つ。
+// 平均と分散は Welford の方法で1打ごとに更新するので、打鍵を溜めておかない。
+// 小節の入れ物は曲を始めるとき (コースでは次の曲に移るとき) にまとめて作るので、
+// 判定のたびにメモリを確保しない。
+class PlayAnalytics {
+public:
+    // 平均と分散を逐次に求める (Welford)
+    struct RunningStats {
+        long long count = 0;
+        double mean = 0.0;
+        double m2 = 0.0; // 平均からの差の2乗の和
+
+        void add(double value);
+        double getStdDev() const;
+    };
+
+    struct BarStats {
+        int perfect = 0;
+        int great = 0;
+        int miss = 0;
+        RunningStats error; // 叩いたノーツのずれ (秒)
+
+        int getNoteCount() const { return perfect + great + miss; }
+        // スコアと同じ重み (Perfect 1, Great 0.5, Miss 0)。ノーツがなければ負
+        float getAccuracy() const;
+    };
+
+    // 新しいプレイを始める。beats は譜面の拍 (小節の頭で区切る)
+    void reset(const std::vector<ChartBeat>& beats);
+    // コースの次の曲の小節を後ろに足す。以後の記録はこの曲の時刻で数える
+    void addChart(const std::vector<ChartBeat>& beats);
+
+    // noteTime はノーツの譜面上の時刻、error は秒 (プラスが遅れ)
+    void recordHit(double noteTime, double error, Judgment judgment);
+    void recordMiss(double noteTime);
+
+    const std::array<int, TIMING_HISTOGRAM_BINS>& getHistogram() const { return histogram; }
+    const RunningStats& getErrorStats() const { return errorStats; }
+    const std::vector<BarStats>& getBars() const { return bars; }
+
+private:
+    BarStats& findBar(double noteTime);
+
+    std::array<int, TIMING_HISTOGRAM_BINS> histogram{};
+    RunningStats errorStats;
+    std::vector<double> barStarts; // 今の曲の小節の頭 (秒)
+    size_t barBase = 0;            // 今の曲の最初の小節の bars の添字
+    std::vector<BarStats> bars;    // 遊んだ曲すべての小節 (コースでは曲順につなぐ)
+};
@@ -0,0 +1,84 @@
+#include "render_scaler.hpp"
+#include "constants.hpp"
+#include <algorithm>
+
+RenderScaler::RenderScaler()
+    : enabled(false),
+      available(false),
+      scale(MAX_RENDER_SCALE),
+      averageFrameTime(0.f),
+      targetFrameTime(1.f / 120.f)
+{
+}
+
+bool RenderScaler::create(unsigned int width, unsigned int height) {
+    baseSize = sf::Vector2f(static_cast<float>(width), static_cast<float>(height));
+    // 最大解像度で一度だけ確保し、以降はビューポートの大きさだけを変える
+    available = sceneTexture.create(width, height);
+    if (available) {
+        sceneTexture.setSmooth(true);
+    }
+    return available;
+}
+
+void RenderScaler::setEnabled(bool isEnabled) {
+    enabled = isEnabled;
+    scale = MAX_RENDER_SCALE;
+    averageFrameTime = 0.f;
+    adjustClock.restart();
+}
+
+bool RenderScaler::isActive() const {
+    return enabled && available;
+}
+
+void RenderScaler::setTargetFrameTime(sf::Time frameTime) {
+    targetFrameTime = frameTime.asSeconds();
+}
+
+void RenderScaler::update(sf::Time frameTime) {
+    if (!isActive()) return;
+
+    // スパイク1回で解像度が揺れないよう、指数移動平均で均す
+    averageFrameTime += (frameTime.asSeconds() - averageFrameTime) * FRAME_TIME_SMOOTHING;
+
+    // 変更直後は効果が平均に反映されるまで待つ
+    if (adjustClock.getElapsedTime() < RENDER_SCALE_COOLDOWN) return;
+
+    if (averageFrameTime > targetFrameTime * RENDER_SCALE_DOWN_THRESHOLD && scale > MIN_RENDER_SCALE) {
+        scale = std::max(MIN_RENDER_SCALE, scale - RENDER_SCALE_STEP);
+        adjustClock.restart();
+    } else if (averageFrameTime < targetFrameTime * RENDER_SCALE_UP_THRESHOLD && scale < MAX_RENDER_SCALE) {
+        scale = std::min(MAX_RENDER_SCALE, scale + RENDER_SCALE_STEP);
+        adjustClock.restart();
+    }
+}
+
+sf::RenderTarget& RenderScaler::beginScene(sf::RenderTarget& fallback) {
+    if (!isActive()) return fallback;
+
+    // 論理座標はそのままに、テクスチャ左上の scale 倍の領域へ描画する
+    sf::View view(sf::FloatRect(0.f, 0.f, baseSize.x, baseSize.y));
+    view.setViewport(sf::FloatRect(0.f, 0.f, scale, scale));
+    sceneTexture.setView(view);
+    sceneTexture.clear(sf::Color::Black);
+    return sceneTexture;
+}
+
+void RenderScaler::present(sf::RenderTarget& target) {
+    if (!isActive()) return;
+
+    sceneTexture.display();
+
+    // SFML のビューポートと同じ丸め方で実際に描画された領域を求める
+    int width = static_cast<int>(0.5f + baseSize.x * scale);
+    int height = static_cast<int>(0.5f + baseSize.y * scale);
+    sf::Sprite sprite(sceneTexture.getTexture());
+    sprite.setTextureRect(sf::IntRect(0, 0, width, height));
+    sprite.setScale(baseSize.x / width, baseSize.y / height);
+    target.draw(sprite);
+}
+
+float RenderScaler::getScale() const {
+    return scale;
+}
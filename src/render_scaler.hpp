@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// --- 動的解像度スケーリング ---
+// ゲームプレイのシーン(背景・レーン・ノーツ・パーティクル)をオフスクリーンに縮小描画し、
+// 計測したフレーム時間に応じて描画解像度を上下させる。HUDやテキストは呼び出し側で
+// ネイティブ解像度のまま描画する。
+class RenderScaler {
+public:
+    RenderScaler();
+
+    // オフスクリーンの作成 (失敗した場合は常にネイティブ描画になる)
+    bool create(unsigned int width, unsigned int height);
+
+    void setEnabled(bool enabled);
+    bool isActive() const;
+
+    // 1フレームの予算 (目標フレームレートの逆数)
+    void setTargetFrameTime(sf::Time frameTime);
+
+    // 描画にかかった時間を渡して解像度を調整する
+    void update(sf::Time frameTime);
+
+    // シーンの描画先を返す。無効時は fallback をそのまま返す
+    sf::RenderTarget& beginScene(sf::RenderTarget& fallback);
+    // シーンを拡大して target に描画する。無効時は何もしない
+    void present(sf::RenderTarget& target);
+
+    float getScale() const;
+
+private:
+    sf::RenderTexture sceneTexture;
+    sf::Vector2f baseSize;
+    bool enabled;
+    bool available;
+    float scale;
+    float averageFrameTime; // 秒 (指数移動平均)
+    float targetFrameTime;  // 秒
+    sf::Clock adjustClock;  // 前回スケールを変更してからの時間
+};
@@ -0,0 +1,74 @@
+#include "render_thread.hpp"
+#include "constants.hpp"
+
+RenderThread::RenderThread(sf::RenderWindow& window, GameplayRenderer& renderer, FramePacer& pacer, ImageLoader& imageLoader)
+    : window(window),
+      renderer(renderer),
+      pacer(pacer),
+      imageLoader(imageLoader),
+      running(false),
+      showPerformanceOverlay(false)
+{
+}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start() {
+    if (running) return;
+
+    // OpenGL コンテキストは同時に1スレッドでしか有効にできない
+    window.setActive(false);
+    running = true;
+    thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop() {
+    if (!running) return;
+
+    running = false;
+    thread.join();
+    window.setActive(true);
+}
+
+bool RenderThread::isRunning() const {
+    return running;
+}
+
+void RenderThread::publish(const FrameSnapshot& snapshot) {
+    // 代入なのでベクタの容量は使い回され、定常状態では確保が起きない
+    snapshots.beginWrite() = snapshot;
+    snapshots.publish();
+}
+
+void RenderThread::setPerformanceOverlayVisible(bool visible) {
+    showPerformanceOverlay = visible;
+}
+
+void RenderThread::run() {
+    window.setActive(true);
+
+    sf::Clock frameClock;
+    while (running) {
+        frameClock.restart();
+        const FrameSnapshot& snapshot = snapshots.read();
+
+        // テクスチャの転送は GL コンテキストを持つこのスレッドで行う
+        imageLoader.pumpUploads(TEXTURE_UPLOAD_BUDGET);
+
+        window.clear(sf::Color::Black);
+        renderer.draw(window, snapshot);
+        if (showPerformanceOverlay) {
+            renderer.drawPerformanceOverlay(window, pacer);
+        }
+        if (!snapshot.paused) {
+            renderer.reportFrameTime(frameClock.getElapsedTime());
+        }
+
+        window.display();
+        pacer.endFrame();
+    }
+
+    window.setActive(false);
+}
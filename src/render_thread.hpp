@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <thread>
+#include "frame_snapshot.hpp"
+#include "frame_pacer.hpp"
+#include "gameplay_renderer.hpp"
+#include "image_loader.hpp"
+#include "triple_buffer.hpp"
+
+// --- 描画スレッド ---
+// ゲームプレイ中はこのスレッドが画面の描画と display() を担当し、
+// ゲームスレッドは入力・判定・更新だけを行ってスナップショットを公開する。
+// 動いている間、メインスレッドはウィンドウに描画してはいけない。
+class RenderThread {
+public:
+    RenderThread(sf::RenderWindow& window, GameplayRenderer& renderer, FramePacer& pacer, ImageLoader& imageLoader);
+    ~RenderThread();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // 最新の状態を描画スレッドに渡す (待たずに戻る)
+    void publish(const FrameSnapshot& snapshot);
+
+    // F3 の表示切り替え
+    void setPerformanceOverlayVisible(bool visible);
+
+private:
+    void run();
+
+    sf::RenderWindow& window;
+    GameplayRenderer& renderer;
+    FramePacer& pacer;
+    ImageLoader& imageLoader;
+
+    TripleBuffer<FrameSnapshot> snapshots;
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<bool> showPerformanceOverlay;
+};
@@ -0,0 +1,66 @@
+#include "resampler.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <cmath>
+
+Resampler::Resampler(unsigned int inputRate, unsigned int outputRate) {
+    reset(inputRate, outputRate);
+}
+
+void Resampler::reset(unsigned int newInputRate, unsigned int newOutputRate) {
+    if (newInputRate != inputRate || newOutputRate != outputRate || table.empty()) {
+        inputRate = newInputRate;
+        outputRate = newOutputRate;
+        step = static_cast<double>(inputRate) / outputRate;
+
+        const double pi = 3.14159265358979323846;
+        double cutoff = 0.5 * std::min(1.0, 1.0 / step) * 0.97;
+        table.resize(RESAMPLE_HALF_TAPS * RESAMPLE_TABLE_RESOLUTION + 2);
+        for (size_t i = 0; i < table.size(); ++i) {
+            double x = static_cast<double>(i) / RESAMPLE_TABLE_RESOLUTION;
+            double t = std::min(1.0, x / RESAMPLE_HALF_TAPS);
+            double window = 0.42 + 0.5 * std::cos(pi * t) + 0.08 * std::cos(2.0 * pi * t);
+            double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * pi * cutoff * x) / (2.0 * pi * cutoff * x);
+            table[i] = static_cast<float>(2.0 * cutoff * sinc * window);
+        }
+    }
+    position = RESAMPLE_HALF_TAPS;
+    outputPosition = 0.0;
+    inputFrames = 0;
+    // 先頭の前は無音とみなす
+    buffer.assign(RESAMPLE_HALF_TAPS * 2, 0.f);
+}
+
+void Resampler::process(const float* input, size_t frames, bool last, std::vector<float>& output) {
+    buffer.insert(buffer.end(), input, input + frames * 2);
+    inputFrames += frames;
+    if (last) buffer.insert(buffer.end(), (RESAMPLE_HALF_TAPS + 1) * 2, 0.f);
+
+    const size_t bufferFrames = buffer.size() / 2;
+    while (position + RESAMPLE_HALF_TAPS + 1 <= bufferFrames) {
+        if (last && outputPosition >= inputFrames) break;
+        size_t center = static_cast<size_t>(position);
+        double fraction = position - center;
+        float left = 0.f, right = 0.f;
+        for (int k = -RESAMPLE_HALF_TAPS + 1; k <= RESAMPLE_HALF_TAPS; ++k) {
+            double distance = std::abs(k - fraction) * RESAMPLE_TABLE_RESOLUTION;
+            size_t index = static_cast<size_t>(distance);
+            float t = static_cast<float>(distance - index);
+            float weight = table[index] * (1.f - t) + table[index + 1] * t;
+            const float* frame = &buffer[(center + k) * 2];
+            left += frame[0] * weight;
+            right += frame[1] * weight;
+        }
+        output.push_back(left);
+        output.push_back(right);
+        position += step;
+        outputPosition += step;
+    }
+
+    // もう使わない古い入力を捨てる
+    size_t drop = static_cast<size_t>(position) > static_cast<size_t>(RESAMPLE_HALF_TAPS) ? static_cast<size_t>(position) - RESAMPLE_HALF_TAPS : 0;
+    if (drop > 0) {
+        buffer.erase(buffer.begin(), buffer.begin() + drop * 2);
+        position -= drop;
+    }
+}
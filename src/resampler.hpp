@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --- サンプルレートの変換 ---
+// 窓付き sinc でサンプルレートを変える (ステレオ float)。下げるときは新しいナイキスト周波数の少し手前で切る。
+// 小数の読み位置と、まだ使う入力の末尾を持ち越すので、入力をどんな長さに区切って渡しても
+// 1本の長い入力を変換したのと同じ結果になる (ブロックの継ぎ目でずれたりプチノイズが出たりしない)。
+// 出力の k フレーム目は、入力の先頭から k * getStep() フレームの位置に当たる。
+class Resampler {
+public:
+    Resampler() = default;
+    Resampler(unsigned int inputRate, unsigned int outputRate);
+
+    // 入力の先頭からやり直す (レートが変わらなければ係数の表は作り直さない)
+    void reset(unsigned int inputRate, unsigned int outputRate);
+
+    // frames フレームを足し、作れるだけ output の後ろに足す。last なら入力の終わりまで出し切る
+    void process(const float* input, size_t frames, bool last, std::vector<float>& output);
+
+    // 出力1フレームで進む入力のフレーム数
+    double getStep() const { return step; }
+
+private:
+    unsigned int inputRate = 0;
+    unsigned int outputRate = 0;
+    double step = 1.0;
+    double position = 0.0;       // buffer の先頭から数えた、次の出力の位置
+    double outputPosition = 0.0; // 入力の先頭から数えた、次の出力の位置
+    size_t inputFrames = 0;
+    std::vector<float> table;  // 距離 0..RESAMPLE_HALF_TAPS の係数
+    std::vector<float> buffer; // ステレオの入力
+};
@@ -0,0 +1,158 @@
+#include "results_graphs.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+const unsigned int LABEL_SIZE = 24;
+const float HISTOGRAM_HEADROOM = 20.f;    // 一番高い棒の上の余白
+const float TIMELINE_ACCURACY_RATIO = 0.55f; // 小節ごとのグラフの上からこの割合を精度の折れ線に使う
+const float TIMELINE_GAP = 10.f;
+const double TIMELINE_ERROR_RANGE = 0.05; // 秒。平均のずれの棒がこの値で端に届く
+
+const sf::Color PANEL_COLOR(0, 0, 0, 150);
+const sf::Color GUIDE_COLOR(255, 255, 255, 90);
+const sf::Color PERFECT_COLOR = sf::Color::Cyan; // 判定の数の文字と同じ色
+const sf::Color GREAT_COLOR = sf::Color::Yellow;
+const sf::Color EARLY_COLOR(90, 150, 255);
+const sf::Color LATE_COLOR(255, 110, 90);
+
+void appendQuad(sf::VertexArray& array, float left, float top, float right, float bottom, sf::Color color) {
+    array.append(sf::Vertex(sf::Vector2f(left, top), color));
+    array.append(sf::Vertex(sf::Vector2f(right, top), color));
+    array.append(sf::Vertex(sf::Vector2f(right, bottom), color));
+    array.append(sf::Vertex(sf::Vector2f(left, bottom), color));
+}
+
+void appendLine(sf::VertexArray& array, sf::Vector2f from, sf::Vector2f to, sf::Color color) {
+    array.append(sf::Vertex(from, color));
+    array.append(sf::Vertex(to, color));
+}
+
+// 秒を "+3.2ms" のように書く
+std::string formatMilliseconds(double seconds, bool showSign) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    if (showSign) oss << std::showpos;
+    oss << seconds * 1000.0 << "ms";
+    return oss.str();
+}
+}
+
+ResultsGraphs::ResultsGraphs()
+    : panels(sf::Quads),
+      bars(sf::Quads),
+      guides(sf::Lines),
+      accuracyLine(sf::LineStrip)
+{
+}
+
+void ResultsGraphs::build(const PlayAnalytics& analytics, const sf::Font& font) {
+    panels.clear();
+    bars.clear();
+    guides.clear();
+    accuracyLine.clear();
+    labels.clear();
+    buildHistogram(analytics, font);
+    buildTimeline(analytics, font);
+}
+
+void ResultsGraphs::buildHistogram(const PlayAnalytics& analytics, const sf::Font& font) {
+    const sf::FloatRect& area = RESULTS_HISTOGRAM_AREA;
+    const float bottom = area.top + area.height;
+    appendQuad(panels, area.left, area.top, area.left + area.width, bottom, PANEL_COLOR);
+
+    // ずれ t (秒) の横位置
+    auto getX = [&](double t) {
+        return area.left + static_cast<float>((t + GREAT_WINDOW) / (2.0 * GREAT_WINDOW)) * area.width;
+    };
+    appendLine(guides, sf::Vector2f(getX(0.0), area.top), sf::Vector2f(getX(0.0), bottom), GUIDE_COLOR);
+    for (double t : {-static_cast<double>(PERFECT_WINDOW), static_cast<double>(PERFECT_WINDOW)}) {
+        sf::Color color = PERFECT_COLOR;
+        color.a = 90;
+        appendLine(guides, sf::Vector2f(getX(t), area.top), sf::Vector2f(getX(t), bottom), color);
+    }
+
+    const auto& histogram = analytics.getHistogram();
+    int maxCount = *std::max_element(histogram.begin(), histogram.end());
+    if (maxCount > 0) {
+        const float binWidth = area.width / TIMING_HISTOGRAM_BINS;
+        for (int i = 0; i < TIMING_HISTOGRAM_BINS; ++i) {
+            if (histogram[i] == 0) continue;
+            float left = area.left + i * binWidth;
+            float height = (area.height - HISTOGRAM_HEADROOM) * histogram[i] / maxCount;
+            double center = ((i + 0.5) / TIMING_HISTOGRAM_BINS * 2.0 - 1.0) * GREAT_WINDOW;
+            sf::Color color = std::abs(center) < PERFECT_WINDOW ? PERFECT_COLOR : GREAT_COLOR;
+            appendQuad(bars, left + 1.f, bottom - height, left + binWidth - 1.f, bottom, color);
+        }
+    }
+
+    addLabel(font, "Timing", area.left, area.top - 6.f, 0.f, sf::Color::White);
+    const auto& stats = analytics.getErrorStats();
+    std::string summary = "No hits";
+    if (stats.count > 0) {
+        // 平均が0.5ms未満なら早い・遅いは書かない
+        std::string tendency = std::abs(stats.mean) < 0.0005 ? "" : (stats.mean > 0.0 ? " (Late)" : " (Early)");
+        summary = "Avg " + formatMilliseconds(stats.mean, true) + tendency + "   SD " + formatMilliseconds(stats.getStdDev(), false);
+    }
+    addLabel(font, summary, area.left + area.width, area.top - 6.f, 1.f, sf::Color::White);
+    addLabel(font, "Early", area.left - 8.f, bottom, 1.f, EARLY_COLOR);
+    addLabel(font, "Late", area.left + area.width + 8.f, bottom, 0.f, LATE_COLOR);
+}
+
+void ResultsGraphs::buildTimeline(const PlayAnalytics& analytics, const sf::Font& font) {
+    const sf::FloatRect& area = RESULTS_TIMELINE_AREA;
+    const float bottom = area.top + area.height;
+    const float accuracyBottom = area.top + area.height * TIMELINE_ACCURACY_RATIO;
+    const float errorTop = accuracyBottom + TIMELINE_GAP;
+    const float errorZero = (errorTop + bottom) / 2.f;
+    const float errorHalfHeight = (bottom - errorTop) / 2.f;
+    appendQuad(panels, area.left, area.top, area.left + area.width, accuracyBottom, PANEL_COLOR);
+    appendQuad(panels, area.left, errorTop, area.left + area.width, bottom, PANEL_COLOR);
+    appendLine(guides, sf::Vector2f(area.left, errorZero), sf::Vector2f(area.left + area.width, errorZero), GUIDE_COLOR);
+
+    const auto& barStats = analytics.getBars();
+    const float barWidth = area.width / std::max<size_t>(1, barStats.size());
+    for (size_t i = 0; i < barStats.size(); ++i) {
+        const auto& bar = barStats[i];
+        float accuracy = bar.getAccuracy();
+        if (accuracy < 0.f) continue; // ノーツのない小節は飛ばしてつなぐ
+        float x = area.left + (i + 0.5f) * barWidth;
+        accuracyLine.append(sf::Vertex(sf::Vector2f(x, accuracyBottom - accuracy * (accuracyBottom - area.top)), sf::Color::White));
+
+        if (bar.error.count == 0) continue;
+        float ratio = static_cast<float>(std::max(-1.0, std::min(1.0, bar.error.mean / TIMELINE_ERROR_RANGE)));
+        float left = area.left + i * barWidth;
+        float right = left + std::max(1.f, barWidth - 1.f);
+        float top = std::min(errorZero, errorZero - ratio * errorHalfHeight);
+        float barBottom = std::max(errorZero, errorZero - ratio * errorHalfHeight);
+        appendQuad(bars, left, top, right, barBottom, ratio > 0.f ? LATE_COLOR : EARLY_COLOR);
+    }
+
+    addLabel(font, "Accuracy by Bar", area.left, area.top - 6.f, 0.f, sf::Color::White);
+    addLabel(font, "Late", area.left + area.width + 8.f, errorZero, 0.f, LATE_COLOR);
+    addLabel(font, "Early", area.left + area.width + 8.f, bottom, 0.f, EARLY_COLOR);
+}
+
+void ResultsGraphs::addLabel(const sf::Font& font, const std::string& string, float x, float y, float anchor, sf::Color color) {
+    sf::Text text(string, font, LABEL_SIZE);
+    text.setFillColor(color);
+    text.setOutlineColor(sf::Color::Black);
+    text.setOutlineThickness(1.f);
+    sf::FloatRect bounds = text.getLocalBounds();
+    text.setOrigin(bounds.left + bounds.width * anchor, bounds.top + bounds.height);
+    text.setPosition(x, y);
+    labels.push_back(text);
+}
+
+void ResultsGraphs::draw(sf::RenderTarget& target) const {
+    target.draw(panels);
+    target.draw(bars);
+    target.draw(guides);
+    if (accuracyLine.getVertexCount() > 1) target.draw(accuracyLine);
+    for (const auto& label : labels) {
+        target.draw(label);
+    }
+}
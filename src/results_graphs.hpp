@@ -0,0 +1,31 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include "play_analytics.hpp"
+
+// --- リザルト画面のグラフ ---
+// PlayAnalytics の集計から、ずれのヒストグラムと小節ごとの精度・ずれのグラフを作る。
+// 頂点はリザルトに入るときに1回だけ作り、描画は頂点配列ごとに1回ずつで済ませる。
+// ヒストグラムは左が早い・右が遅い。小節ごとのグラフは上が精度の折れ線、下が平均のずれ
+// (上に伸びれば遅れ、下に伸びれば走っている) で、どこで走ったかもたったかが分かる。
+class ResultsGraphs {
+public:
+    ResultsGraphs();
+
+    void build(const PlayAnalytics& analytics, const sf::Font& font);
+    void draw(sf::RenderTarget& target) const;
+
+private:
+    void buildHistogram(const PlayAnalytics& analytics, const sf::Font& font);
+    void buildTimeline(const PlayAnalytics& analytics, const sf::Font& font);
+    // x, y に anchor (0 で左端、1 で右端) を合わせ、下端を揃えて置く
+    void addLabel(const sf::Font& font, const std::string& string, float x, float y, float anchor, sf::Color color);
+
+    sf::VertexArray panels;       // 背景
+    sf::VertexArray bars;         // ヒストグラムと小節ごとのずれ
+    sf::VertexArray guides;       // 0ms と判定幅の目盛り
+    sf::VertexArray accuracyLine; // 小節ごとの精度
+    std::vector<sf::Text> labels;
+};
@@ -0,0 +1,197 @@
+#include "sfx_mixer.hpp"
+#include <algorithm>
+
+SfxMixer::SfxMixer()
+    : sampleCount(0),
+      timelineSequence(0),
+      timelineFrame(0),
+      timelineMicroseconds(0),
+      mixCount(0),
+      voices(SFX_VOICE_COUNT),
+      voiceCounter(0),
+      mixedFrames(0),
+      mixBuffer(SFX_MIXER_CHUNK_FRAMES * 2, 0.f),
+      outputBuffer(SFX_MIXER_CHUNK_FRAMES * 2, 0)
+{
+    samples.reserve(SFX_MAX_SAMPLES);
+    initialize(2, MIXER_SAMPLE_RATE);
+#if SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR >= 6
+    // 小さなバッファでも取りこぼさないよう、ストリームスレッドの起床間隔を詰める
+    setProcessingInterval(sf::milliseconds(1));
+#endif
+}
+
+SfxMixer::~SfxMixer() {
+    // 派生クラスが壊れる前にストリームスレッドを止める
+    stop();
+}
+
+SfxMixer::SampleId SfxMixer::loadSample(const std::string& path) {
+    if (samples.size() >= SFX_MAX_SAMPLES) return -1;
+
+    sf::SoundBuffer buffer;
+    if (!buffer.loadFromFile(path) || buffer.getChannelCount() == 0) return -1;
+
+    Sample sample;
+    size_t frameCount = static_cast<size_t>(buffer.getSampleCount() / buffer.getChannelCount());
+    sample.frames = convertToStereoFloat(buffer.getSamples(), frameCount, buffer.getChannelCount(),
+                                         buffer.getSampleRate(), MIXER_SAMPLE_RATE);
+    sample.frameCount = sample.frames.size() / 2;
+
+    // 容量は確保済みなので再配置は起きず、オーディオスレッドが読んでいる要素は動かない
+    samples.push_back(std::move(sample));
+    int id = static_cast<int>(samples.size()) - 1;
+    sampleCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+void SfxMixer::trigger(SampleId sample, float gain) {
+    triggerAt(sample, gain, -1);
+}
+
+void SfxMixer::triggerAt(SampleId sample, float gain, long long startFrame) {
+    if (sample < 0) return;
+    Command command;
+    command.sample = sample;
+    command.gain = gain;
+    command.startFrame = startFrame;
+    commands.push(command); // 満杯のときは鳴らさない (ブロックしない)
+}
+
+long long SfxMixer::getMixFrame() const {
+    long long frame, microseconds;
+    unsigned int before, after;
+    do {
+        before = timelineSequence.load();
+        frame = timelineFrame.load();
+        microseconds = timelineMicroseconds.load();
+        after = timelineSequence.load();
+    } while (before != after || (before & 1u) != 0);
+
+    long long elapsed = timelineClock.getElapsedTime().asMicroseconds() - microseconds;
+    return frame + elapsed * static_cast<long long>(MIXER_SAMPLE_RATE) / 1000000;
+}
+
+void SfxMixer::unloadSamplesFrom(SampleId first) {
+    if (first < 0 || first >= static_cast<SampleId>(samples.size())) return;
+
+    // 先に数を減らし、オーディオスレッドが新しい数を見たミックスを2回終えるまで待つ
+    // (1回目は減らす前に読んだ数でミックス中かもしれない)
+    sampleCount.store(first, std::memory_order_release);
+    if (getStatus() == Playing) {
+        unsigned long long start = mixCount.load();
+        while (mixCount.load() < start + 2 && getStatus() == Playing) {
+            sf::sleep(sf::milliseconds(1));
+        }
+    }
+    samples.erase(samples.begin() + first, samples.end());
+}
+
+bool SfxMixer::onGetData(Chunk& data) {
+    const long long chunkStart = mixedFrames;
+    publishTimeline(chunkStart);
+
+    Command command;
+    while (commands.pop(command)) {
+        startVoice(command, chunkStart);
+    }
+
+    std::fill(mixBuffer.begin(), mixBuffer.end(), 0.f);
+    int availableSamples = sampleCount.load(std::memory_order_acquire);
+
+    for (auto& voice : voices) {
+        if (voice.sample < 0) continue;
+        if (voice.sample >= availableSamples) {
+            voice.sample = -1; // 破棄されたサンプルを鳴らしていたボイスは解放する
+            continue;
+        }
+
+        // 予約位置がこのチャンクより先なら次に回す。チャンクの途中から鳴らすこともある
+        long long offset = voice.startFrame - chunkStart;
+        if (offset >= static_cast<long long>(SFX_MIXER_CHUNK_FRAMES)) continue;
+        size_t begin = offset > 0 ? static_cast<size_t>(offset) : 0;
+
+        const Sample& sample = samples[voice.sample];
+        size_t frames = std::min(SFX_MIXER_CHUNK_FRAMES - begin, sample.frameCount - voice.position);
+        const float* in = &sample.frames[voice.position * 2];
+        float* out = &mixBuffer[begin * 2];
+        for (size_t i = 0; i < frames * 2; ++i) {
+            out[i] += in[i] * voice.gain;
+        }
+        voice.position += frames;
+        if (voice.position >= sample.frameCount) {
+            voice.sample = -1;
+        }
+    }
+
+    for (size_t i = 0; i < mixBuffer.size(); ++i) {
+        float value = std::max(-1.f, std::min(1.f, mixBuffer[i]));
+        outputBuffer[i] = static_cast<sf::Int16>(value * 32767.f);
+    }
+
+    data.samples = outputBuffer.data();
+    data.sampleCount = outputBuffer.size();
+    mixedFrames += SFX_MIXER_CHUNK_FRAMES;
+    mixCount.fetch_add(1);
+    return true; // 鳴らす音がなくても無音を流し続ける
+}
+
+void SfxMixer::onSeek(sf::Time) {
+    // 常に再生し続けるストリームなのでシークはしない
+}
+
+void SfxMixer::publishTimeline(long long frame) {
+    timelineSequence.fetch_add(1); // 奇数の間は書き込み中
+    timelineFrame.store(frame);
+    timelineMicroseconds.store(timelineClock.getElapsedTime().asMicroseconds());
+    timelineSequence.fetch_add(1);
+}
+
+void SfxMixer::startVoice(const Command& command, long long chunkStart) {
+    if (command.sample >= sampleCount.load(std::memory_order_acquire)) return;
+
+    // 空きボイスがなければ一番古いボイスを奪う
+    Voice* target = &voices[0];
+    for (auto& voice : voices) {
+        if (voice.sample < 0) {
+            target = &voice;
+            break;
+        }
+        if (voice.startOrder < target->startOrder) {
+            target = &voice;
+        }
+    }
+
+    target->sample = command.sample;
+    target->position = 0;
+    target->gain = command.gain;
+    target->startFrame = command.startFrame < 0 ? chunkStart : command.startFrame;
+    target->startOrder = ++voiceCounter;
+}
+
+std::vector<float> convertToStereoFloat(const sf::Int16* samples, size_t frameCount, unsigned int channelCount,
+                                        unsigned int sampleRate, unsigned int targetSampleRate) {
+    const float scale = 1.f / 32768.f;
+    std::vector<float> stereo(frameCount * 2);
+    for (size_t i = 0; i < frameCount; ++i) {
+        const sf::Int16* frame = samples + i * channelCount;
+        // モノラルは両チャンネルに同じ値を、3ch以上は先頭の2chを使う
+        stereo[i * 2] = frame[0] * scale;
+        stereo[i * 2 + 1] = (channelCount > 1 ? frame[1] : frame[0]) * scale;
+    }
+    if (sampleRate == targetSampleRate || sampleRate == 0 || frameCount == 0) return stereo;
+
+    double step = static_cast<double>(sampleRate) / targetSampleRate;
+    size_t resampledCount = static_cast<size_t>(frameCount / step);
+    std::vector<float> resampled(resampledCount * 2);
+    for (size_t i = 0; i < resampledCount; ++i) {
+        double position = i * step;
+        size_t index = static_cast<size_t>(position);
+        size_t next = std::min(index + 1, frameCount - 1);
+        float t = static_cast<float>(position - index);
+        for (int c = 0; c < 2; ++c) {
+            resampled[i * 2 + c] = stereo[index * 2 + c] * (1.f - t) + stereo[next * 2 + c] * t;
+        }
+    }
+    return resampled;
+}
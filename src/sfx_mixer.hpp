@@ -0,0 +1,87 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "constants.hpp"
+#include "spsc_queue.hpp"
+
+// --- 効果音ミキサー ---
+// sf::Sound は1つのボイスを play() のたびに頭から鳴らし直すため、連打で自分の音を切ってしまう。
+// ここでは PCM をメモリに展開しておき、固定数のボイスを小さなバッファで1本のストリームに混ぜる。
+// trigger() はロックもメモリ確保もしないので、ゲームスレッドから毎フレーム呼んでよい。
+class SfxMixer : public sf::SoundStream {
+public:
+    typedef int SampleId; // 読み込み失敗時は -1
+
+    SfxMixer();
+    ~SfxMixer();
+
+    // ファイルを読み込んでミキサーの形式 (ステレオ float) に変換する
+    SampleId loadSample(const std::string& path);
+
+    // 空いているボイスで鳴らす。空きがなければ一番古いボイスを奪う
+    void trigger(SampleId sample, float gain = 1.f);
+
+    // ミックス位置 (出力フレーム番号) を指定して鳴らす。過ぎた位置ならすぐに鳴らす
+    void triggerAt(SampleId sample, float gain, long long startFrame);
+
+    // 今この瞬間に対応するミックス位置の推定値。直近のコールバック時刻から外挿する
+    long long getMixFrame() const;
+
+    // first 以降に読み込んだサンプルを破棄する (曲ごとのキー音の入れ替え用)
+    // オーディオスレッドが古いサンプルを読み終えるまで待つので、メインスレッドから呼ぶ
+    void unloadSamplesFrom(SampleId first);
+
+protected:
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time timeOffset) override;
+
+private:
+    struct Sample {
+        std::vector<float> frames; // L, R の交互
+        size_t frameCount = 0;
+    };
+
+    struct Voice {
+        SampleId sample = -1; // -1 なら空き
+        size_t position = 0;  // 次に読むフレーム
+        float gain = 1.f;
+        long long startFrame = 0; // このミックス位置から鳴り始める
+        unsigned long long startOrder = 0; // ボイスを奪うときに古いものを選ぶため
+    };
+
+    struct Command {
+        SampleId sample;
+        float gain;
+        long long startFrame; // -1 なら次のチャンクの先頭
+    };
+
+    void startVoice(const Command& command, long long chunkStart);
+    void publishTimeline(long long frame);
+
+    // サンプルはあらかじめ確保した領域に追加し、数だけをアトミックに公開する
+    std::vector<Sample> samples;
+    std::atomic<int> sampleCount;
+
+    // ミックス位置と時刻の対応。seqlock でまとめて読めるようにする
+    sf::Clock timelineClock;
+    std::atomic<unsigned int> timelineSequence;
+    std::atomic<long long> timelineFrame;
+    std::atomic<long long> timelineMicroseconds;
+    std::atomic<unsigned long long> mixCount; // onGetData を抜けた回数
+
+    // 以下はオーディオスレッドだけが触る
+    std::vector<Voice> voices;
+    unsigned long long voiceCounter;
+    long long mixedFrames; // これまでにミックスしたフレーム数
+    std::vector<float> mixBuffer;
+    std::vector<sf::Int16> outputBuffer;
+
+    SpscQueue<Command, SFX_COMMAND_QUEUE_SIZE> commands;
+};
+
+// PCM をステレオ float に変換し、必要なら線形補間でサンプルレートを合わせる
+std::vector<float> convertToStereoFloat(const sf::Int16* samples, size_t frameCount, unsigned int channelCount,
+                                        unsigned int sampleRate, unsigned int targetSampleRate);
@@ -0,0 +1,92 @@
+#include "song_clock.hpp"
+#include <algorithm>
+#include <cmath>
+#include "constants.hpp"
+
+SongClock::SongClock(AudioStreamingService& service, AudioChannel channel)
+    : service(service),
+      channel(channel),
+      startFrame(0),
+      speed(1.f),
+      sectionStart(0.0),
+      paused(false),
+      pausedTime(0.0),
+      anchored(false),
+      anchorTime(0.0) {
+}
+
+void SongClock::setSpeed(float newSpeed) {
+    speed = newSpeed;
+    service.setPlaybackSpeed(channel, speed);
+}
+
+void SongClock::setSection(sf::Time start, sf::Time end, bool loop) {
+    sectionStart = start.asSeconds();
+    service.setSection(channel, start, end, loop);
+}
+
+void SongClock::start(sf::Time leadIn) {
+    // ミックス済みの位置より後なら、出力スレッドはそのフレームちょうどから鳴らせる
+    startFrame = service.getMixedFrame() + static_cast<long long>(leadIn.asSeconds() * MIXER_SAMPLE_RATE);
+    service.playAt(channel, startFrame);
+    paused = false;
+    anchored = false;
+}
+
+void SongClock::pause() {
+    if (paused) return;
+    pausedTime = getTime();
+    paused = true;
+    if (pausedTime < sectionStart) {
+        service.stop(channel); // リードイン中はまだ鳴っていないので、再開時に予約し直す
+    } else {
+        service.pause(channel);
+    }
+}
+
+void SongClock::resume() {
+    if (!paused) return;
+    paused = false;
+    anchored = false;
+    if (pausedTime < sectionStart) {
+        // 止めた時点の残りのリードインから続ける (出力の遅れより短ければその分だけ縮む)
+        startFrame = service.getOutputFrame() + static_cast<long long>((sectionStart - pausedTime) / speed * MIXER_SAMPLE_RATE);
+        startFrame = std::max(startFrame, service.getMixedFrame());
+        service.playAt(channel, startFrame);
+    } else {
+        service.resume(channel);
+    }
+}
+
+void SongClock::stop() {
+    service.stop(channel);
+    paused = false;
+    anchored = false;
+}
+
+double SongClock::getTime() {
+    if (paused) return pausedTime;
+
+    double audioTime = getAudioTime();
+    double elapsed = anchorClock.restart().asSeconds();
+    double predicted = anchorTime + elapsed * speed;
+    double error = audioTime - predicted;
+
+    // 大きくずれたら合わせ直し、小さなずれは少しずつ吸収する
+    if (!anchored || std::abs(error) > SONG_CLOCK_RESYNC_THRESHOLD.asSeconds()) {
+        anchorTime = audioTime;
+        anchored = true;
+    } else {
+        double correction = std::min(1.0, elapsed / SONG_CLOCK_CORRECTION_TIME.asSeconds());
+        anchorTime = predicted + error * correction;
+    }
+    return anchorTime;
+}
+
+double SongClock::getAudioTime() const {
+    long long played = service.getOutputFrame();
+    if (played < startFrame) {
+        return sectionStart + static_cast<double>(played - startFrame) / MIXER_SAMPLE_RATE * speed;
+    }
+    return service.getPlayingOffset(channel).asSeconds();
+}
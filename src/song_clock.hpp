@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include "audio_streaming_service.hpp"
+
+// --- 曲の時計 ---
+// 曲の開始を出力タイムライン上のフレームに予約し、リードイン (負の時刻) から
+// 曲中の時刻までを1本の時計で返す。リードイン中は出力ストリームの再生位置から、
+// 曲が始まってからはチャンネルの再生位置から時刻を求めるので、見た目と音がずれない。
+// 再生位置の細かな揺れはそのまま使わず、壁時計をゆっくり寄せて滑らかにする。
+// 練習用に再生速度を変えたときは、曲中の時刻が壁時計の speed 倍で進む。
+class SongClock {
+public:
+    SongClock(AudioStreamingService& service, AudioChannel channel);
+
+    // 時刻を読むチャンネルを変える (コースで次の曲に移るとき)。次の start() の前に呼ぶ
+    void setChannel(AudioChannel newChannel) { channel = newChannel; }
+
+    // 次の start() から有効。リードインは実時間のまま
+    void setSpeed(float speed);
+    float getSpeed() const { return speed; }
+    // 練習区間。次の start() から start の位置で鳴り始め、loop なら end で start に戻る
+    void setSection(sf::Time start, sf::Time end, bool loop);
+
+    // leadIn 後に (ミックス済みの位置から数えて) 曲の先頭が鳴るよう予約する
+    void start(sf::Time leadIn);
+    void pause();
+    void resume();
+    void stop();
+
+    // 曲中の時刻 (秒)。リードイン中は区間の先頭より前。毎フレーム呼ぶと補正が進む
+    double getTime();
+    bool isPaused() const { return paused; }
+    double getSectionStart() const { return sectionStart; }
+
+private:
+    double getAudioTime() const;
+
+    AudioStreamingService& service;
+    AudioChannel channel;
+    long long startFrame;
+    float speed;
+    double sectionStart;
+
+    bool paused;
+    double pausedTime;
+
+    bool anchored;
+    double anchorTime;
+    sf::Clock anchorClock;
+};
@@ -0,0 +1,104 @@
+#include "song_preview.hpp"
+#include "constants.hpp"
+#include "waveform_peaks.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace {
+// 1秒ごとの振れ幅を足し合わせ、SONG_PREVIEW_LENGTH の窓で一番大きい所を選ぶ (サビのあたりになりやすい)。
+// ピークのキャッシュがない曲は全体をデコードすることになるので、カーソルが離れたらやめて頭から流す
+double findLoudestSection(const std::string& audioPath, const std::function<bool()>& cancelled) {
+    WaveformPeaks peaks;
+    if (!peaks.load(audioPath, cancelled)) return 0.0;
+    const double length = SONG_PREVIEW_LENGTH.asSeconds();
+    const size_t windowSeconds = static_cast<size_t>(length);
+    const size_t seconds = static_cast<size_t>(peaks.getDuration());
+    if (seconds <= windowSeconds) return 0.0;
+
+    std::vector<float> energy(seconds);
+    for (size_t i = 0; i < seconds; ++i) {
+        float minimum = 0.f, maximum = 0.f;
+        peaks.query(static_cast<double>(i), static_cast<double>(i + 1), minimum, maximum);
+        energy[i] = maximum - minimum;
+    }
+    float sum = 0.f;
+    for (size_t i = 0; i < windowSeconds; ++i) sum += energy[i];
+    float bestSum = sum;
+    size_t bestStart = 0;
+    for (size_t start = 1; start + windowSeconds <= seconds; ++start) {
+        sum += energy[start + windowSeconds - 1] - energy[start - 1];
+        if (sum > bestSum) {
+            bestSum = sum;
+            bestStart = start;
+        }
+    }
+    return static_cast<double>(bestStart);
+}
+}
+
+SongPreview::SongPreview(AudioStreamingService& service, WorkerPool& pool)
+    : service(service),
+      job(pool)
+{
+}
+
+void SongPreview::setVolume(float volume) {
+    service.setChannelVolume(AudioChannel::PREVIEW, volume);
+}
+
+void SongPreview::select(const SongData& song, float songGain) {
+    if (selected && song.audioPath == audioPath) return;
+    selected = true;
+    audioPath = song.audioPath;
+    previewStart = song.previewStart;
+    gain = songGain;
+
+    job.cancel();
+    submitted = false;
+    restClock.restart();
+    if (playing) {
+        service.crossfade(AudioChannel::PREVIEW, AudioChannel::MENU, SONG_PREVIEW_FADE);
+        playing = false;
+    }
+}
+
+void SongPreview::update() {
+    if (!selected) return;
+
+    std::unique_ptr<PreparedPreview> prepared = job.take();
+    if (prepared) {
+        // 展開済みの区間をそのままループさせるので、デコードスレッドがファイルを読むことはほとんどない
+        service.setSection(AudioChannel::PREVIEW, prepared->start, prepared->start + SONG_PREVIEW_LENGTH, true);
+        service.open(AudioChannel::PREVIEW, std::move(prepared->source), false);
+        service.setChannelGain(AudioChannel::PREVIEW, gain);
+        service.crossfade(AudioChannel::MENU, AudioChannel::PREVIEW, SONG_PREVIEW_FADE);
+        playing = true;
+        return;
+    }
+    // 取り消したジョブがまだ走っていれば終わるのを待つ (投げるのは同時に1つだけ)
+    if (!submitted && !job.isBusy() && restClock.getElapsedTime() >= SONG_PREVIEW_DELAY) submit();
+}
+
+void SongPreview::stop(sf::Time fade) {
+    job.cancel();
+    selected = false;
+    submitted = false;
+    audioPath.clear();
+    if (playing) {
+        service.stop(AudioChannel::PREVIEW, fade);
+        playing = false;
+    }
+}
+
+void SongPreview::submit() {
+    submitted = true;
+    std::string path = audioPath;
+    double startSeconds = previewStart;
+    job.start([path, startSeconds](const BackgroundJob<PreparedPreview>::CancelCheck& cancelled) {
+        std::unique_ptr<PreparedPreview> prepared(new PreparedPreview());
+        prepared->start = sf::seconds(static_cast<float>(startSeconds >= 0.0 ? startSeconds : findLoudestSection(path, cancelled)));
+        prepared->source.reset(new MusicSource());
+        if (!prepared->source->open(path, SONG_PREVIEW_LENGTH, prepared->start, cancelled)) prepared.reset();
+        return prepared;
+    });
+}
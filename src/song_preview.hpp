@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <memory>
+#include <string>
+#include "audio_streaming_service.hpp"
+#include "background_job.hpp"
+#include "types.hpp"
+#include "worker_pool.hpp"
+
+// --- 選曲画面の試聴 ---
+// カーソルが SONG_PREVIEW_DELAY だけ止まったら、その曲の試聴区間をワーカーで開いて先頭を展開し、
+// 準備ができたフレームで PREVIEW チャンネルに渡してメニューBGMとクロスフェードする。
+// 試聴区間の開始位置は songs.json の "preview_start" (秒)、なければ波形のピークから一番大きい区間を選ぶ。
+//
+// 速くスクロールしている間はジョブを投げない。投げるのは同時に1つだけで、カーソルが離れた曲の
+// ジョブは世代番号で気付いて展開を途中でやめる (結果は捨てる)。
+// select/update/stop はメインスレッドから呼ぶ。
+class SongPreview {
+public:
+    SongPreview(AudioStreamingService& service, WorkerPool& pool);
+
+    void setVolume(float volume); // 0-100
+
+    // カーソルが song に移った (同じ曲なら何もしない)。gain は曲ごとの音量の補正 (dB)
+    void select(const SongData& song, float gain = 0.f);
+    // 毎フレーム呼ぶ。止まっていればジョブを投げ、準備ができていれば鳴らす
+    void update();
+    // 試聴をやめる。鳴っていればメニューBGMに戻さずにフェードアウトする
+    void stop(sf::Time fade);
+
+private:
+    // ワーカーで開いた試聴区間
+    struct PreparedPreview {
+        std::unique_ptr<MusicSource> source;
+        sf::Time start;
+    };
+
+    void submit();
+
+    AudioStreamingService& service;
+    BackgroundJob<PreparedPreview> job;
+
+    std::string audioPath;
+    double previewStart = -1.0;
+    float gain = 0.f;
+    bool selected = false;
+    bool submitted = false; // 今の世代のジョブを投げた
+    bool playing = false;   // 試聴が鳴っている (メニューBGMはフェードアウトしている)
+    sf::Clock restClock;    // カーソルが止まってからの時間
+};
@@ -0,0 +1,94 @@
+#include "spectrum_analyzer.hpp"
+#include <algorithm>
+#include <cmath>
+
+SpectrumAnalyzer::SpectrumAnalyzer(const AudioStreamingService& service)
+    : service(service),
+      running(false),
+      fft(SPECTRUM_FFT_SIZE),
+      window(fft.makeHannWindow()),
+      samples(SPECTRUM_FFT_SIZE),
+      real(SPECTRUM_FFT_SIZE),
+      imag(SPECTRUM_FFT_SIZE),
+      smoothed(SPECTRUM_BAND_COUNT, 0.f),
+      analysisMicroseconds(0.f) {
+    const size_t n = SPECTRUM_FFT_SIZE;
+
+    // 帯域は対数で等間隔に分ける。低い帯域でも最低1ビンは入るようにする
+    const float binWidth = static_cast<float>(MIXER_SAMPLE_RATE) / n;
+    for (size_t b = 0; b <= SPECTRUM_BAND_COUNT; ++b) {
+        float frequency = SPECTRUM_MIN_FREQUENCY * std::pow(SPECTRUM_MAX_FREQUENCY / SPECTRUM_MIN_FREQUENCY, static_cast<float>(b) / SPECTRUM_BAND_COUNT);
+        size_t bin = std::min(n / 2, static_cast<size_t>(frequency / binWidth + 0.5f));
+        if (!bandEdges.empty()) bin = std::max(bin, bandEdges.back() + 1);
+        bandEdges.push_back(std::min(n / 2, bin));
+    }
+
+    bands.beginWrite().fill(0.f);
+    bands.publish();
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    stop();
+}
+
+void SpectrumAnalyzer::start() {
+    if (running.exchange(true)) return;
+    // 前のプレイの残りを出さないよう、0 から立ち上げる (解析スレッドは止まっているので触ってよい)
+    std::fill(smoothed.begin(), smoothed.end(), 0.f);
+    bands.beginWrite().fill(0.f);
+    bands.publish();
+    thread = std::thread(&SpectrumAnalyzer::run, this);
+}
+
+void SpectrumAnalyzer::stop() {
+    if (running.exchange(false)) {
+        thread.join();
+    }
+}
+
+void SpectrumAnalyzer::getBands(float* out) {
+    const auto& latest = bands.read();
+    std::copy(latest.begin(), latest.end(), out);
+}
+
+void SpectrumAnalyzer::run() {
+    sf::Clock clock;
+    while (running.load()) {
+        clock.restart();
+        analyze();
+        float elapsed = static_cast<float>(clock.getElapsedTime().asMicroseconds());
+        analysisMicroseconds.store(analysisMicroseconds.load() + (elapsed - analysisMicroseconds.load()) * AUDIO_LOAD_SMOOTHING);
+        sf::sleep(SPECTRUM_INTERVAL - clock.getElapsedTime());
+    }
+}
+
+void SpectrumAnalyzer::analyze() {
+    const size_t n = SPECTRUM_FFT_SIZE;
+
+    // 今聞こえている位置までの区間を解析する (取れなければ無音として減衰させる)
+    if (!service.readTap(samples.data(), n, service.getOutputFrame())) {
+        std::fill(samples.begin(), samples.end(), 0.f);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        samples[i] *= window[i];
+    }
+    fft.transform(samples.data(), real.data(), imag.data());
+
+    // ハン窓のフルスケールの正弦波がちょうど 1 (0dB) になるように正規化する
+    const float scale = 4.f / n;
+    for (size_t b = 0; b < SPECTRUM_BAND_COUNT; ++b) {
+        float power = 0.f;
+        for (size_t bin = bandEdges[b]; bin < bandEdges[b + 1]; ++bin) {
+            power = std::max(power, (real[bin] * real[bin] + imag[bin] * imag[bin]) * scale * scale);
+        }
+        float decibels = 10.f * std::log10(power + 1e-12f);
+        float target = std::max(0.f, std::min(1.f, 1.f - decibels / SPECTRUM_FLOOR_DB));
+
+        float& value = smoothed[b];
+        value = target > value ? value + (target - value) * SPECTRUM_ATTACK : std::max(target, value * SPECTRUM_RELEASE);
+    }
+
+    auto& published = bands.beginWrite();
+    std::copy(smoothed.begin(), smoothed.end(), published.begin());
+    bands.publish();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "audio_streaming_service.hpp"
+#include "constants.hpp"
+#include "fft.hpp"
+#include "triple_buffer.hpp"
+
+// --- スペクトル解析 ---
+// 音楽ストリーミングサービスの出力を約60Hzで FFT し、帯域ごとの強さ (0-1) を公開する。
+// 解析は専用のスレッドで行い、読むのは今まさに聞こえている位置の直前の区間なので、
+// 出力の遅れの分だけ表示が先走ることもない。
+// 結果はトリプルバッファで公開するので、オーディオスレッドもゲームスレッドも待たされない。
+class SpectrumAnalyzer {
+public:
+    explicit SpectrumAnalyzer(const AudioStreamingService& service);
+    ~SpectrumAnalyzer();
+
+    // ゲームプレイに入るときに start し、出るときに stop する (それ以外の画面では FFT を回さない)
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(); }
+
+    // 最新の帯域ごとの強さを out (SPECTRUM_BAND_COUNT 個) に写す。読むのは1つのスレッドだけ
+    void getBands(float* out);
+    // 1回の解析にかかった時間 (平滑化)
+    sf::Time getAnalysisTime() const { return sf::microseconds(static_cast<sf::Int64>(analysisMicroseconds.load())); }
+
+private:
+    void run();
+    void analyze();
+
+    const AudioStreamingService& service;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    // 解析スレッドだけが触る
+    Fft fft;
+    std::vector<float> window;
+    std::vector<float> samples;
+    std::vector<float> real;
+    std::vector<float> imag;
+    std::vector<size_t> bandEdges;  // 帯域の境界のビン (SPECTRUM_BAND_COUNT + 1 個)
+    std::vector<float> smoothed;
+
+    TripleBuffer<std::array<float, SPECTRUM_BAND_COUNT>> bands;
+    std::atomic<float> analysisMicroseconds;
+};
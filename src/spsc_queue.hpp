@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// --- ロックフリーの単一生産者・単一消費者キュー ---
+// ゲームスレッドからオーディオスレッドへの命令の受け渡しなどに使う。
+// 固定長の配列だけで動くので、push/pop でメモリ確保も待ちも発生しない。
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // 満杯なら false を返して何もしない
+    bool push(const T& item) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        size_t nextTail = (currentTail + 1) % Capacity;
+        if (nextTail == head.load(std::memory_order_acquire)) return false;
+        items[currentTail] = item;
+        tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    // 空なら false を返す
+    bool pop(T& item) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) return false;
+        item = items[currentHead];
+        head.store((currentHead + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+    // 先頭の要素をコピーせずに参照する (消費者側のみ)。空なら nullptr
+    T* front() {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) return nullptr;
+        return &items[currentHead];
+    }
+
+    // front() で見ていた要素を捨てる (消費者側のみ)
+    void popFront() {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        head.store((currentHead + 1) % Capacity, std::memory_order_release);
+    }
+
+    // 目安の要素数 (どちらのスレッドからでも呼べるが、読んだ直後に変わりうる)
+    size_t size() const {
+        size_t currentHead = head.load(std::memory_order_acquire);
+        size_t currentTail = tail.load(std::memory_order_acquire);
+        return (currentTail + Capacity - currentHead) % Capacity;
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<size_t> head; // 消費者だけが書く
+    std::atomic<size_t> tail; // 生産者だけが書く
+};
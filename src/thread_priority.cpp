@@ -0,0 +1,22 @@
+#include "thread_priority.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+void raiseCurrentThreadPriority(ThreadPriority priority) {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(),
+                      priority == ThreadPriority::REALTIME ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST);
+#else
+    // SCHED_FIFO は通常ユーザーでは失敗することが多いが、その場合は通常優先度のまま続ける
+    int minPriority = sched_get_priority_min(SCHED_FIFO);
+    int maxPriority = sched_get_priority_max(SCHED_FIFO);
+    sched_param param;
+    param.sched_priority = priority == ThreadPriority::REALTIME ? maxPriority - 1 : (minPriority + maxPriority) / 2;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// --- スレッドの優先度 ---
+enum class ThreadPriority {
+    HIGH,     // デコードなど、遅れると音切れにつながる処理
+    REALTIME  // 出力バッファを埋める処理
+};
+
+// 呼び出したスレッドの優先度を上げる。権限がなければ何もしない
+void raiseCurrentThreadPriority(ThreadPriority priority);
@@ -0,0 +1,190 @@
+#include "time_stretcher.hpp"
+#include <algorithm>
+#include <cmath>
+#include "constants.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TIME_STRETCH_USE_SSE2 1
+#endif
+
+namespace {
+const long long HOP = static_cast<long long>(TIME_STRETCH_HOP_FRAMES);
+const long long WINDOW = HOP * 2;
+const long long SEARCH = static_cast<long long>(TIME_STRETCH_SEARCH_FRAMES);
+
+// 位置の探索はこの内積がほとんどを占める
+float dotProduct(const float* a, const float* b, size_t count) {
+    size_t i = 0;
+    float sum = 0.f;
+#ifdef TIME_STRETCH_USE_SSE2
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    const size_t vectorCount = count - count % 8;
+    for (; i < vectorCount; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+}
+
+TimeStretcher::TimeStretcher()
+    : speed(1.f),
+      window(static_cast<size_t>(WINDOW)),
+      inputBase(0),
+      inputEnd(0),
+      finished(false),
+      drained(false),
+      hopIndex(0),
+      previousPosition(0),
+      overlap(static_cast<size_t>(HOP) * 2, 0.f),
+      outputRead(0),
+      templateMono(static_cast<size_t>(HOP)),
+      searchMono(static_cast<size_t>(SEARCH * 2 + HOP)) {
+    const double pi = 3.14159265358979323846;
+    for (long long i = 0; i < WINDOW; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * i / WINDOW));
+    }
+}
+
+void TimeStretcher::reset(float newSpeed) {
+    speed = newSpeed;
+    input.clear();
+    inputBase = 0;
+    inputEnd = 0;
+    finished = false;
+    drained = false;
+    hopIndex = 0;
+    previousPosition = 0;
+    std::fill(overlap.begin(), overlap.end(), 0.f);
+    output.clear();
+    outputRead = 0;
+}
+
+void TimeStretcher::write(const float* frames, size_t frameCount) {
+    input.insert(input.end(), frames, frames + frameCount * 2);
+    inputEnd += static_cast<long long>(frameCount);
+    while (processHop()) {}
+}
+
+void TimeStretcher::finish() {
+    finished = true;
+    while (processHop()) {}
+}
+
+size_t TimeStretcher::read(float* out, size_t maxFrames) {
+    size_t frames = std::min(maxFrames, getAvailableFrames());
+    std::copy(output.begin() + outputRead, output.begin() + outputRead + frames * 2, out);
+    outputRead += frames * 2;
+    if (outputRead == output.size()) {
+        output.clear();
+        outputRead = 0;
+    }
+    return frames;
+}
+
+bool TimeStretcher::processHop() {
+    if (drained) return false;
+
+    const long long nominal = static_cast<long long>(std::llround(hopIndex * HOP * static_cast<double>(speed)));
+    if (finished && nominal >= inputEnd) {
+        // 最後の区間の後半を出して終わり
+        output.insert(output.end(), overlap.begin(), overlap.end());
+        drained = true;
+        return false;
+    }
+    if (!finished && inputEnd < nominal + SEARCH + WINDOW) return false;
+
+    long long position = nominal;
+    if (hopIndex == 0) {
+        // 直前に同じ信号を窓の後半で切り出していたことにして、先頭から音量が欠けないようにする
+        previousPosition = -HOP;
+        for (long long i = 0; i < HOP; ++i) {
+            overlap[i * 2] = getSample(i, 0) * window[HOP + i];
+            overlap[i * 2 + 1] = getSample(i, 1) * window[HOP + i];
+        }
+    } else {
+        position = findBestPosition(nominal);
+    }
+
+    size_t start = output.size();
+    output.resize(start + static_cast<size_t>(HOP) * 2);
+    float* out = &output[start];
+    for (long long i = 0; i < HOP; ++i) {
+        out[i * 2] = overlap[i * 2] + getSample(position + i, 0) * window[i];
+        out[i * 2 + 1] = overlap[i * 2 + 1] + getSample(position + i, 1) * window[i];
+    }
+    for (long long i = 0; i < HOP; ++i) {
+        overlap[i * 2] = getSample(position + HOP + i, 0) * window[HOP + i];
+        overlap[i * 2 + 1] = getSample(position + HOP + i, 1) * window[HOP + i];
+    }
+
+    previousPosition = position;
+    ++hopIndex;
+
+    // 次の区間の探索と比較に使う範囲より前は捨ててよい
+    long long nextNominal = static_cast<long long>(std::llround(hopIndex * HOP * static_cast<double>(speed)));
+    trimInput(std::min(previousPosition + HOP, nextNominal - SEARCH));
+    return true;
+}
+
+long long TimeStretcher::findBestPosition(long long nominal) {
+    // 直前の区間がそのまま続いた場合の波形 (重なる部分) に一番似ている位置を探す
+    copyMono(previousPosition + HOP, static_cast<size_t>(HOP), templateMono.data());
+
+    long long first = std::max(std::max(nominal - SEARCH, 0LL), inputBase);
+    long long last = nominal + SEARCH;
+    if (last < first) return nominal;
+    size_t candidates = static_cast<size_t>(last - first + 1);
+    copyMono(first, candidates + static_cast<size_t>(HOP) - 1, searchMono.data());
+
+    float energy = 0.f;
+    for (long long i = 0; i < HOP; ++i) {
+        energy += searchMono[i] * searchMono[i];
+    }
+
+    long long best = nominal;
+    float bestScore = -1e30f;
+    for (size_t c = 0; c < candidates; ++c) {
+        // 音量の大きい所ばかり選ばないよう、候補側のエネルギーで正規化する
+        float score = dotProduct(templateMono.data(), &searchMono[c], static_cast<size_t>(HOP)) / std::sqrt(energy + 1e-6f);
+        if (score > bestScore) {
+            bestScore = score;
+            best = first + static_cast<long long>(c);
+        }
+        if (c + 1 < candidates) {
+            float leaving = searchMono[c];
+            float entering = searchMono[c + static_cast<size_t>(HOP)];
+            energy = std::max(0.f, energy - leaving * leaving + entering * entering);
+        }
+    }
+    return best;
+}
+
+void TimeStretcher::copyMono(long long first, size_t frameCount, float* dest) const {
+    for (size_t i = 0; i < frameCount; ++i) {
+        long long frame = first + static_cast<long long>(i);
+        dest[i] = getSample(frame, 0) + getSample(frame, 1);
+    }
+}
+
+float TimeStretcher::getSample(long long frame, int side) const {
+    if (frame < inputBase || frame >= inputEnd) return 0.f;
+    return input[static_cast<size_t>(frame - inputBase) * 2 + side];
+}
+
+void TimeStretcher::trimInput(long long keepFrom) {
+    // 毎回詰めると重いので、窓いくつか分たまってからまとめて捨てる
+    long long removable = std::min(keepFrom, inputEnd) - inputBase;
+    if (removable < WINDOW * 2) return;
+    input.erase(input.begin(), input.begin() + static_cast<size_t>(removable) * 2);
+    inputBase += removable;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --- 時間伸縮 (WSOLA) ---
+// 練習用に音程を変えずに再生速度だけを変える。入力 (MIXER_SAMPLE_RATE のステレオ float) から
+// 窓をかけた区間を speed に応じた間隔で切り出し、半分ずつ重ねて出力する。切り出す位置は
+// 予定の位置の前後 TIME_STRETCH_SEARCH_FRAMES の中から、直前の区間の続きに一番似ている所を選ぶ。
+//
+// 出力の n フレーム目は入力の n * speed フレーム目として扱う。探索によるずれは範囲内に収まり
+// 累積しないので、時刻はこの対応から求めればよい (実際に選んだ位置の揺れを時計に持ち込まない)。
+// スレッドセーフではない。デコードスレッドだけから使う。
+class TimeStretcher {
+public:
+    TimeStretcher();
+
+    // 入出力を空にして速度を設定する
+    void reset(float speed);
+    float getSpeed() const { return speed; }
+
+    void write(const float* frames, size_t frameCount);
+    // 入力の終わり。残りの入力を最後まで出力する
+    void finish();
+
+    size_t getAvailableFrames() const { return (output.size() - outputRead) / 2; }
+    size_t read(float* out, size_t maxFrames);
+    // finish() の後、すべて読み終えたか
+    bool isDrained() const { return drained && getAvailableFrames() == 0; }
+
+private:
+    bool processHop();
+    long long findBestPosition(long long nominal);
+    // 入力フレーム [first, first + frameCount) を L+R のモノラルで dest に書く (範囲外は 0)
+    void copyMono(long long first, size_t frameCount, float* dest) const;
+    float getSample(long long frame, int side) const;
+    void trimInput(long long keepFrom);
+
+    float speed;
+    std::vector<float> window; // 周期的なハン窓 (半分ずつ重ねると和が1になる)
+
+    std::vector<float> input;  // ステレオ
+    long long inputBase;       // input の先頭の入力フレーム番号
+    long long inputEnd;        // 書き込まれた入力のフレーム数
+    bool finished;
+    bool drained;
+
+    long long hopIndex;
+    long long previousPosition; // 直前に切り出した区間の先頭
+    std::vector<float> overlap; // 直前の区間の後半 (窓をかけたもの)
+
+    std::vector<float> output; // ステレオ
+    size_t outputRead;
+
+    std::vector<float> templateMono;
+    std::vector<float> searchMono;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+// --- ロックフリーのトリプルバッファ ---
+// 書き込み側と読み込み側がそれぞれ1スレッドのときに使う。
+// 書き込み側は常に空いているバッファに書き、読み込み側は最後に公開されたものを取得する。
+// どちらも相手を待つことはない。
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : front(0), back(1), middle(2) {}
+
+    // 書き込み用のバッファ (publish するまで読み込み側からは見えない)
+    T& beginWrite() {
+        return buffers[back];
+    }
+
+    // 書き込んだバッファを公開する
+    void publish() {
+        int previous = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    // 新しいデータが公開されていれば最新のものに切り替えて返す
+    const T& read() {
+        if (middle.load(std::memory_order_acquire) & FRESH_BIT) {
+            int previous = middle.exchange(front, std::memory_order_acq_rel);
+            front = previous & INDEX_MASK;
+        }
+        return buffers[front];
+    }
+
+private:
+    static const int INDEX_MASK = 0x3;
+    static const int FRESH_BIT = 0x4;
+
+    T buffers[3];
+    int front;               // 読み込み側だけが触る
+    int back;                // 書き込み側だけが触る
+    std::atomic<int> middle; // 受け渡し中のバッファ (FRESH_BIT 付きなら未読)
+};
@@ -8,8 +8,10 @@
 enum class GameState {
     TITLE,
     OPTIONS,
+    CALIBRATION, // オプションから入る遅延のキャリブレーション
     SONG_SELECTION,
     DIFFICULTY_SELECTION,
+    COURSE_SELECTION,
     PLAYING,
     PAUSED,
     GAMEOVER,
@@ -24,6 +26,32 @@ enum class Judgment {
     MISS
 };
 
+// --- 曲のBGMの読み込み方 ---
+enum class BgmMode {
+    DEFAULT, // config.json の bgm_in_memory に従う
+    MEMORY,  // 全体をメモリに展開する (予算を超える場合はストリーミング)
+    STREAM   // ディスクからストリーミングする
+};
+
+// --- 音楽ストリーミングのチャンネル ---
+enum class AudioChannel {
+    BGM,      // ゲームプレイ中の曲
+    MENU,     // タイトル・選曲画面
+    RESULTS,
+    GAMEOVER,
+    PREVIEW,  // 選曲画面の試聴
+    BGM_SUB   // コースで次の曲を開いておく2本目 (曲が変わるたびに BGM と入れ替わる)
+};
+const int AUDIO_CHANNEL_COUNT = 6;
+
+// --- メニュー系BGM ---
+enum class MusicCue {
+    TITLE,
+    RESULTS,
+    GAMEOVER
+};
+const int MUSIC_CUE_COUNT = 3;
+
 // --- データ構造 ---
 struct Note
 {
@@ -31,12 +59,39 @@ struct Note
     int laneIndex;
     double spawnTime; // ノーツが判定ラインに到達すべき時間 (秒)
     bool isProcessed = false; // 判定済みかどうかのフラグ
+    int keyNumber = 0; // MIDIのキー番号
+    int channel = 0;   // MIDIのチャンネル (0-15)
+    int keysound = -1; // KeysoundBank の割り当て。-1 なら通常のタップ音
+};
+
+// 練習で選べる区間の先頭。MIDIのマーカー、なければ一定の小節ごと
+struct ChartSection
+{
+    double startTime; // 秒
+    std::string name;
+};
+
+// 拍の頭。MIDIのテンポマップと拍子から求める (アシストのクリック用)
+struct ChartBeat
+{
+    double time; // 秒
+    bool downbeat; // 小節の頭
 };
 
 struct ChartData
 {
     std::string difficultyName;
     std::string chartPath;
+    float offset = 0.0f; // ms。譜面の時刻に足して音声に合わせる (chartoffset ツールで推定する)
+};
+
+// MIDIのキー番号・チャンネルと鳴らすサンプルの対応。-1 はどれにでも一致する
+struct KeysoundMapping
+{
+    int keyNumber = -1;
+    int channel = -1;
+    std::string samplePath;
+    float gain = 1.0f;
 };
 
 struct SongData
@@ -45,6 +100,22 @@ struct SongData
     std::string audioPath;
     std::string backgroundPath; // 背景画像パスを追加
     std::vector<ChartData> charts;
+    std::vector<KeysoundMapping> keysounds; // 空ならキー音なし
+    BgmMode bgmMode = BgmMode::DEFAULT;
+    double previewStart = -1.0; // 試聴の開始位置 (秒)。負なら波形から自動で決める
+};
+
+// コースの1曲 (songs の添字と、その曲の charts の添字)
+struct CourseEntry
+{
+    size_t songIndex = 0;
+    size_t chartIndex = 0;
+};
+
+struct CourseData
+{
+    std::string title;
+    std::vector<CourseEntry> entries;
 };
 
 struct Particle {
@@ -53,9 +124,29 @@ struct Particle {
     sf::Time lifetime;
 };
 
+// 練習用のアシストのクリック。拍の頭とノーツのどちらで鳴らすか
+enum class AssistTickMode {
+    OFF,
+    BEAT,
+    NOTES,
+    BOTH
+};
+const int ASSIST_TICK_MODE_COUNT = 4;
+
 struct GameConfig {
     float noteSpeedMultiplier = 1.0f;
     float bgmVolume = 100.0f;
     float sfxVolume = 100.0f;
     float audioOffset = 0.0f; // ms
+    bool dynamicResolution = false; // フレーム時間に応じてゲームプレイの描画解像度を下げる
+    int frameRateLimit = 120; // 0 で無制限
+    bool verticalSync = false; // true のときは frameRateLimit より優先
+    bool renderThread = true; // ゲームプレイ中の描画を別スレッドで行う
+    bool keysounds = true; // 曲にキー音が定義されていればタップ音の代わりに鳴らす
+    bool bgmInMemory = true; // 曲のBGMを開始時に全体デコードしてメモリから鳴らす
+    int bgmMemoryBudget = 128; // メモリ展開するPCMの上限 (MB)。超える曲はストリーミング
+    bool loudnessNormalization = true; // 曲ごとのラウドネスを測って音量を揃える
+    bool spectrumVisualizer = true; // レーンの後ろにBGMのスペクトルを出す
+    AssistTickMode assistTicks = AssistTickMode::OFF; // 曲に重ねて拍・ノーツのクリックを鳴らす
+    bool adaptiveOffset = false; // 譜面ごとに学習したずれを判定とノーツの表示に足す
 };
@@ -0,0 +1,298 @@
+#include "waveform_peaks.hpp"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "constants.hpp"
+#include "file_utils.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVEFORM_USE_SSE2 1
+#endif
+
+namespace {
+const char CACHE_MAGIC[4] = {'S', 'G', 'P', 'K'};
+const sf::Uint32 CACHE_VERSION = 1;
+const char REAPER_MAGIC[4] = {'R', 'P', 'K', 'L'}; // これ以外の版は読まずに自前で作る
+const size_t REAPER_HEADER_SIZE = 18;              // マジック, チャンネル数, 段数, サンプルレート, 更新日時, サイズ
+
+struct CacheHeader {
+    char magic[4];
+    sf::Uint32 version;
+    sf::Int64 sourceModifiedTime;
+    sf::Int64 sourceSize;
+    sf::Uint32 sampleRate;
+    sf::Uint32 baseDivision;
+    sf::Uint64 count;
+};
+
+sf::Uint32 readUint32(const unsigned char* bytes) {
+    return static_cast<sf::Uint32>(bytes[0]) | (static_cast<sf::Uint32>(bytes[1]) << 8) |
+           (static_cast<sf::Uint32>(bytes[2]) << 16) | (static_cast<sf::Uint32>(bytes[3]) << 24);
+}
+
+// samples (count 個) の最大値と最小値
+void reduceMinMax(const sf::Int16* samples, size_t count, sf::Int16& maximum, sf::Int16& minimum) {
+    size_t i = 0;
+    sf::Int16 high = -32768, low = 32767;
+#ifdef WAVEFORM_USE_SSE2
+    const size_t vectorCount = count - count % 8;
+    if (vectorCount > 0) {
+        __m128i highs = _mm_set1_epi16(-32768);
+        __m128i lows = _mm_set1_epi16(32767);
+        for (; i < vectorCount; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+            highs = _mm_max_epi16(highs, v);
+            lows = _mm_min_epi16(lows, v);
+        }
+        // 8つのレーンを半分ずつ畳んで、先頭のレーンに集める
+        highs = _mm_max_epi16(highs, _mm_shuffle_epi32(highs, _MM_SHUFFLE(1, 0, 3, 2)));
+        highs = _mm_max_epi16(highs, _mm_shuffle_epi32(highs, _MM_SHUFFLE(2, 3, 0, 1)));
+        highs = _mm_max_epi16(highs, _mm_srli_epi32(highs, 16));
+        lows = _mm_min_epi16(lows, _mm_shuffle_epi32(lows, _MM_SHUFFLE(1, 0, 3, 2)));
+        lows = _mm_min_epi16(lows, _mm_shuffle_epi32(lows, _MM_SHUFFLE(2, 3, 0, 1)));
+        lows = _mm_min_epi16(lows, _mm_srli_epi32(lows, 16));
+        high = static_cast<sf::Int16>(_mm_cvtsi128_si32(highs));
+        low = static_cast<sf::Int16>(_mm_cvtsi128_si32(lows));
+    }
+#endif
+    for (; i < count; ++i) {
+        high = std::max(high, samples[i]);
+        low = std::min(low, samples[i]);
+    }
+    maximum = high;
+    minimum = low;
+}
+
+// 隣り合う2つずつをまとめる (takeMaximum なら大きい方、そうでなければ小さい方)。奇数個なら最後はそのまま
+std::vector<sf::Int16> reducePairs(const std::vector<sf::Int16>& input, bool takeMaximum) {
+    std::vector<sf::Int16> output((input.size() + 1) / 2);
+    size_t i = 0;
+#ifdef WAVEFORM_USE_SSE2
+    // 16個を読んで、32ビットごとの上下の16ビットを比べ、符号拡張してから8個に詰める
+    const size_t vectorCount = input.size() - input.size() % 16;
+    for (; i < vectorCount; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input[i]));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input[i + 8]));
+        a = takeMaximum ? _mm_max_epi16(a, _mm_srli_epi32(a, 16)) : _mm_min_epi16(a, _mm_srli_epi32(a, 16));
+        b = takeMaximum ? _mm_max_epi16(b, _mm_srli_epi32(b, 16)) : _mm_min_epi16(b, _mm_srli_epi32(b, 16));
+        a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+        b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i / 2]), _mm_packs_epi32(a, b));
+    }
+#endif
+    for (; i < input.size(); i += 2) {
+        sf::Int16 second = i + 1 < input.size() ? input[i + 1] : input[i];
+        output[i / 2] = takeMaximum ? std::max(input[i], second) : std::min(input[i], second);
+    }
+    return output;
+}
+
+// "audio/song.ogg" → "audio/peaks/", "song.ogg"
+void splitPeaksPath(const std::string& audioPath, std::string& directory, std::string& name) {
+    size_t slash = audioPath.find_last_of("/\\");
+    directory = (slash == std::string::npos ? std::string() : audioPath.substr(0, slash + 1)) + "peaks";
+    name = slash == std::string::npos ? audioPath : audioPath.substr(slash + 1);
+}
+}
+
+WaveformPeaks::WaveformPeaks()
+    : sampleRate(0),
+      baseDivision(0),
+      ready(false) {
+}
+
+bool WaveformPeaks::load(const std::string& audioPath, const std::function<bool()>& cancelled) {
+    FileStamp stamp;
+    if (!getFileStamp(audioPath, stamp)) return false;
+
+    std::string directory, name;
+    splitPeaksPath(audioPath, directory, name);
+    std::string cachePath = directory + "/" + name + ".peaks";
+    if (!readReaperPeaks(directory + "/" + name + ".reapeaks", stamp.size) &&
+        !readCache(cachePath, stamp.modifiedTime, stamp.size)) {
+        if (!build(audioPath, cancelled)) return false;
+        if (ensureDirectory(directory)) {
+            writeCache(cachePath, stamp.modifiedTime, stamp.size);
+        }
+    }
+
+    buildLevels();
+    ready.store(true, std::memory_order_release);
+    return true;
+}
+
+double WaveformPeaks::getDuration() const {
+    if (levels.empty() || sampleRate == 0) return 0.0;
+    return static_cast<double>(levels[0].maximum.size()) * baseDivision / sampleRate;
+}
+
+void WaveformPeaks::query(double startTime, double endTime, float& minimum, float& maximum) const {
+    minimum = 0.f;
+    maximum = 0.f;
+    if (!isReady() || levels.empty()) return;
+
+    // 一番細かい段での範囲。それが 2^level 個以上 2^(level+1) 個未満になる段なら、高々3つで覆える
+    const double perSecond = static_cast<double>(sampleRate) / baseDivision;
+    const double baseCount = static_cast<double>(levels[0].maximum.size());
+    double first = std::max(0.0, startTime * perSecond);
+    double last = std::min(baseCount, endTime * perSecond);
+    if (first >= baseCount || last <= first) return;
+
+    int level = static_cast<int>(std::floor(std::log2(std::max(1.0, last - first))));
+    level = std::min(level, static_cast<int>(levels.size()) - 1);
+    const Level& peaks = levels[level];
+    size_t begin = static_cast<size_t>(first) >> level;
+    size_t end = std::max(begin, (static_cast<size_t>(std::ceil(last)) - 1) >> level);
+    end = std::min(end, peaks.maximum.size() - 1);
+
+    sf::Int16 high = -32768, low = 32767;
+    for (size_t i = begin; i <= end; ++i) {
+        high = std::max(high, peaks.maximum[i]);
+        low = std::min(low, peaks.minimum[i]);
+    }
+    maximum = high / 32768.f;
+    minimum = low / 32768.f;
+}
+
+bool WaveformPeaks::readReaperPeaks(const std::string& path, long long sourceSize) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) return false;
+
+    unsigned char header[REAPER_HEADER_SIZE];
+    if (!ifs.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    if (std::memcmp(header, REAPER_MAGIC, sizeof(REAPER_MAGIC)) != 0) return false;
+    unsigned int channelCount = header[4];
+    unsigned int mipmapCount = header[5];
+    // 更新日時は git で取ってくるだけで変わってしまうので、サイズだけで元の音声と同じか確かめる
+    if (channelCount == 0 || mipmapCount == 0 || readUint32(header + 14) != static_cast<sf::Uint32>(sourceSize)) return false;
+
+    // 段ごとの (1値あたりのフレーム数, 値の数)。データは段の順に並んでいる
+    std::vector<unsigned char> mipmaps(mipmapCount * 8);
+    if (!ifs.read(reinterpret_cast<char*>(mipmaps.data()), mipmaps.size())) return false;
+    size_t finest = 0;
+    for (size_t m = 1; m < mipmapCount; ++m) {
+        if (readUint32(&mipmaps[m * 8]) < readUint32(&mipmaps[finest * 8])) finest = m;
+    }
+    std::streamoff dataOffset = static_cast<std::streamoff>(REAPER_HEADER_SIZE + mipmaps.size());
+    for (size_t m = 0; m < finest; ++m) {
+        dataOffset += static_cast<std::streamoff>(readUint32(&mipmaps[m * 8 + 4])) * channelCount * 2 * sizeof(sf::Int16);
+    }
+    sf::Uint32 division = readUint32(&mipmaps[finest * 8]);
+    sf::Uint32 count = readUint32(&mipmaps[finest * 8 + 4]);
+    if (division == 0 || count == 0) return false;
+
+    // 値ごとにチャンネルごとの (最大, 最小) が並ぶ。チャンネルはまとめる
+    std::vector<sf::Int16> values(static_cast<size_t>(count) * channelCount * 2);
+    ifs.seekg(dataOffset);
+    if (!ifs.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(sf::Int16))) return false;
+
+    Level base;
+    base.maximum.resize(count);
+    base.minimum.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const sf::Int16* value = &values[i * channelCount * 2];
+        sf::Int16 high = value[0], low = value[1];
+        for (unsigned int c = 1; c < channelCount; ++c) {
+            high = std::max(high, value[c * 2]);
+            low = std::min(low, value[c * 2 + 1]);
+        }
+        base.maximum[i] = high;
+        base.minimum[i] = low;
+    }
+
+    sampleRate = readUint32(header + 6);
+    baseDivision = division;
+    levels.assign(1, base);
+    return sampleRate > 0;
+}
+
+bool WaveformPeaks::readCache(const std::string& path, long long sourceModifiedTime, long long sourceSize) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) return false;
+
+    CacheHeader header;
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.sourceModifiedTime != sourceModifiedTime ||
+        header.sourceSize != sourceSize ||
+        header.sampleRate == 0 || header.baseDivision == 0 || header.count == 0) {
+        return false;
+    }
+
+    Level base;
+    base.maximum.resize(static_cast<size_t>(header.count));
+    base.minimum.resize(static_cast<size_t>(header.count));
+    if (!ifs.read(reinterpret_cast<char*>(base.maximum.data()), base.maximum.size() * sizeof(sf::Int16)) ||
+        !ifs.read(reinterpret_cast<char*>(base.minimum.data()), base.minimum.size() * sizeof(sf::Int16))) {
+        return false;
+    }
+
+    sampleRate = header.sampleRate;
+    baseDivision = header.baseDivision;
+    levels.assign(1, base);
+    return true;
+}
+
+void WaveformPeaks::writeCache(const std::string& path, long long sourceModifiedTime, long long sourceSize) const {
+    // 上の段は読み込むときに作り直せるので、一番細かい段だけ保存する
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.sourceModifiedTime = sourceModifiedTime;
+    header.sourceSize = sourceSize;
+    header.sampleRate = sampleRate;
+    header.baseDivision = baseDivision;
+    header.count = levels[0].maximum.size();
+
+    writeFileAtomically(path, [&](std::ostream& os) {
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(levels[0].maximum.data()), static_cast<std::streamsize>(header.count * sizeof(sf::Int16)));
+        os.write(reinterpret_cast<const char*>(levels[0].minimum.data()), static_cast<std::streamsize>(header.count * sizeof(sf::Int16)));
+        return static_cast<bool>(os);
+    }, true);
+}
+
+bool WaveformPeaks::build(const std::string& audioPath, const std::function<bool()>& cancelled) {
+    sf::InputSoundFile file;
+    if (!file.openFromFile(audioPath)) return false;
+    const unsigned int channelCount = file.getChannelCount();
+    const size_t blockSamples = static_cast<size_t>(WAVEFORM_BASE_DIVISION) * channelCount;
+
+    Level base;
+    size_t expected = static_cast<size_t>(file.getSampleCount() / blockSamples + 1);
+    base.maximum.reserve(expected);
+    base.minimum.reserve(expected);
+
+    // 読む単位を1値分の倍数にしておけば、値がバッファの境目をまたがない
+    std::vector<sf::Int16> buffer(blockSamples * 256);
+    sf::Uint64 read;
+    while ((read = file.read(buffer.data(), buffer.size())) > 0) {
+        if (cancelled && cancelled()) return false;
+        for (size_t offset = 0; offset < read; offset += blockSamples) {
+            sf::Int16 high, low;
+            reduceMinMax(&buffer[offset], std::min(blockSamples, static_cast<size_t>(read) - offset), high, low);
+            base.maximum.push_back(high);
+            base.minimum.push_back(low);
+        }
+    }
+    if (base.maximum.empty()) return false;
+
+    sampleRate = file.getSampleRate();
+    baseDivision = WAVEFORM_BASE_DIVISION;
+    levels.assign(1, base);
+    return true;
+}
+
+void WaveformPeaks::buildLevels() {
+    levels.resize(1);
+    while (levels.back().maximum.size() > 1) {
+        Level next;
+        next.maximum = reducePairs(levels.back().maximum, true);
+        next.minimum = reducePairs(levels.back().minimum, false);
+        levels.push_back(std::move(next));
+    }
+}
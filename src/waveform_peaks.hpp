@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+// --- 波形のピーク ---
+// 音声の波形を、一定のフレーム数ごとの最小値・最大値 (int16, 全チャンネルをまとめたもの) の列で持つ。
+// 一番細かい段から隣り合う2つずつをまとめた段を重ねたピラミッドにしておくので、
+// どの拡大率でも1ピクセルあたり高々3つの値を見るだけで描ける (音声をデコードし直す必要はない)。
+//
+// 読み込む順番:
+//   1. REAPER が作った <音声のディレクトリ>/peaks/<ファイル名>.reapeaks
+//   2. 自前のキャッシュ <音声のディレクトリ>/peaks/<ファイル名>.peaks
+//   3. 音声をデコードして作り、2 に保存する
+// load() は時間がかかることがあるのでワーカーで1回だけ呼び、isReady() が true になってから query() する。
+// cancelled を渡すと、3 のデコードの途中でもそれが true を返した時点でやめて false を返す (キャッシュは書かない)。
+class WaveformPeaks {
+public:
+    WaveformPeaks();
+
+    bool load(const std::string& audioPath, const std::function<bool()>& cancelled = nullptr);
+
+    bool isReady() const { return ready.load(std::memory_order_acquire); }
+    double getDuration() const;
+
+    // 時刻 [startTime, endTime) (秒) の最小値・最大値 (-1..1)。範囲外なら 0
+    void query(double startTime, double endTime, float& minimum, float& maximum) const;
+
+private:
+    struct Level {
+        std::vector<sf::Int16> maximum;
+        std::vector<sf::Int16> minimum;
+    };
+
+    bool readReaperPeaks(const std::string& path, long long sourceSize);
+    bool readCache(const std::string& path, long long sourceModifiedTime, long long sourceSize);
+    void writeCache(const std::string& path, long long sourceModifiedTime, long long sourceSize) const;
+    bool build(const std::string& audioPath, const std::function<bool()>& cancelled);
+    // levels[0] から上の段を作る
+    void buildLevels();
+
+    unsigned int sampleRate;
+    unsigned int baseDivision; // levels[0] の1値あたりのフレーム数
+    std::vector<Level> levels; // levels[n] の1値は levels[0] の 2^n 個分
+    std::atomic<bool> ready;
+};
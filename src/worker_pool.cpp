@@ -0,0 +1,75 @@
+#include "worker_pool.hpp"
+#include "constants.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+    : activeJobs(0),
+      stopping(false)
+{
+    if (threadCount == 0) {
+        // メインスレッドと描画スレッドの分を残す
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 2 ? hardwareThreads - 2 : 1;
+        threadCount = std::min(threadCount, MAX_WORKER_THREADS);
+    }
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.push_back(std::thread(&WorkerPool::run, this));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear(); // 未着手のジョブは捨てる
+        lowPriorityJobs.clear();
+    }
+    condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    condition.notify_one();
+}
+
+void WorkerPool::submitLowPriority(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lowPriorityJobs.push_back(std::move(job));
+    }
+    condition.notify_one();
+}
+
+void WorkerPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCondition.wait(lock, [this] { return activeJobs == 0 && jobs.empty() && lowPriorityJobs.empty(); });
+}
+
+unsigned int WorkerPool::getThreadCount() const {
+    return static_cast<unsigned int>(threads.size());
+}
+
+void WorkerPool::run() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || !jobs.empty() || !lowPriorityJobs.empty(); });
+            if (stopping) return;
+            std::deque<std::function<void()>>& queue = jobs.empty() ? lowPriorityJobs : jobs;
+            job = std::move(queue.front());
+            queue.pop_front();
+            ++activeJobs;
+        }
+        job();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--activeJobs == 0 && jobs.empty() && lowPriorityJobs.empty()) idleCondition.notify_all();
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- ワーカースレッドプール ---
+// 画像のデコードなど、メインスレッドを止めたくない重い処理を投げる先。
+// ジョブは投げた順に実行され、完了の通知はジョブ自身が行う。
+// 低優先度のジョブ (キャッシュの事前作成など) は通常のジョブが空のときだけ実行する。
+class WorkerPool {
+public:
+    // threadCount が 0 ならハードウェアのスレッド数から決める
+    explicit WorkerPool(unsigned int threadCount = 0);
+    ~WorkerPool();
+
+    void submit(std::function<void()> job);
+    void submitLowPriority(std::function<void()> job);
+    // 投げたジョブ (低優先度も含む) がすべて終わるまで待つ。ワーカーのジョブの中からは呼ばない
+    void waitIdle();
+
+    unsigned int getThreadCount() const;
+
+private:
+    void run();
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> jobs;
+    std::deque<std::function<void()>> lowPriorityJobs;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable idleCondition;
+    unsigned int activeJobs; // 実行中のジョブの数
+    bool stopping;
+};
@@ -0,0 +1,244 @@
+// --- 曲の音声のインポートツール ---
+// songs.json の全曲の audio_path を、出力と同じサンプルレート (MIXER_SAMPLE_RATE)・ステレオの
+// Ogg Vorbis に変換して audio/imported/ に置き、対応表 audio/imported/manifest.json を書く。
+// ゲームは起動時に対応表を読み、変換済みの曲はそちらを鳴らす。
+//
+//   audioimport           変わった曲だけ変換する
+//   audioimport --force   全曲を変換し直す
+//
+// 変換は中身のハッシュで管理するので、ファイルの日時が変わっただけなら変換し直さない。
+// 曲ごとのジョブは全コアで並列に処理する。
+
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_import.hpp"
+#include "constants.hpp"
+#include "file_utils.hpp"
+#include "resampler.hpp"
+#include "worker_pool.hpp"
+
+namespace {
+const size_t READ_FRAMES = 65536;
+
+void toStereo(const sf::Int16* samples, size_t frameCount, unsigned int channelCount, std::vector<float>& stereo) {
+    const float scale = 1.f / 32768.f;
+    stereo.resize(frameCount * 2);
+    for (size_t i = 0; i < frameCount; ++i) {
+        const sf::Int16* frame = samples + i * channelCount;
+        // モノラルは両チャンネルに同じ値を、3ch以上は先頭の2chを使う
+        stereo[i * 2] = frame[0] * scale;
+        stereo[i * 2 + 1] = (channelCount > 1 ? frame[1] : frame[0]) * scale;
+    }
+}
+
+void writeSamples(sf::OutputSoundFile& file, const std::vector<float>& stereo, std::vector<sf::Int16>& pcm) {
+    pcm.resize(stereo.size());
+    for (size_t i = 0; i < stereo.size(); ++i) {
+        float value = std::max(-1.f, std::min(1.f, stereo[i]));
+        pcm[i] = static_cast<sf::Int16>(std::lround(value * 32767.f));
+    }
+    file.write(pcm.data(), pcm.size());
+}
+
+// 一時ファイルに書いてから置き換えるので、途中で止めても壊れたファイルは残らない
+bool transcode(const std::string& sourcePath, const std::string& outputPath) {
+    sf::InputSoundFile input;
+    if (!input.openFromFile(sourcePath)) return false;
+    const unsigned int channelCount = input.getChannelCount();
+    const unsigned int sampleRate = input.getSampleRate();
+
+    std::string temporaryPath = outputPath.substr(0, outputPath.size() - 4) + ".tmp.ogg";
+    {
+        sf::OutputSoundFile output;
+        if (!output.openFromFile(temporaryPath, MIXER_SAMPLE_RATE, 2)) return false;
+
+        Resampler resampler(sampleRate, MIXER_SAMPLE_RATE);
+        std::vector<sf::Int16> samples(READ_FRAMES * channelCount);
+        std::vector<sf::Int16> pcm;
+        std::vector<float> stereo, resampled;
+        for (;;) {
+            size_t frames = static_cast<size_t>(input.read(samples.data(), samples.size())) / channelCount;
+            toStereo(samples.data(), frames, channelCount, stereo);
+            bool last = frames == 0;
+            if (sampleRate == MIXER_SAMPLE_RATE) {
+                writeSamples(output, stereo, pcm);
+            } else {
+                resampled.clear();
+                resampler.process(stereo.data(), frames, last, resampled);
+                writeSamples(output, resampled, pcm);
+            }
+            if (last) break;
+        }
+    }
+    return replaceFile(temporaryPath, outputPath);
+}
+
+bool hasExtension(const std::string& path, const std::string& extension) {
+    if (path.size() < extension.size()) return false;
+    std::string tail = path.substr(path.size() - extension.size());
+    std::transform(tail.begin(), tail.end(), tail.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return tail == extension;
+}
+
+enum class ImportStatus { UP_TO_DATE, RESTAMPED, KEPT, CONVERTED, SHARED, FAILED };
+
+struct ImportJob {
+    std::string sourcePath;
+    AudioImportManifest::Entry previous;
+    bool hasPrevious = false;
+    AudioImportManifest::Entry entry;
+    ImportStatus status = ImportStatus::FAILED;
+    double seconds = 0.0;
+};
+
+// 同じ出力を2つのジョブが書かないよう、変換を始めたハッシュを覚えておく
+struct OutputClaims {
+    std::mutex mutex;
+    std::set<std::string> hashes;
+};
+
+void processJob(ImportJob& job, const AudioImportManifest& manifest, bool force, OutputClaims& claims) {
+    auto startTime = std::chrono::steady_clock::now();
+    FileStamp stamp;
+    if (!getFileStamp(job.sourcePath, stamp)) return;
+    job.entry.modifiedTime = stamp.modifiedTime;
+    job.entry.size = stamp.size;
+
+    FileStamp outputStamp;
+    bool previousOutputExists = job.hasPrevious && getFileStamp(job.previous.output, outputStamp);
+    if (!force && previousOutputExists && job.previous.modifiedTime == stamp.modifiedTime && job.previous.size == stamp.size) {
+        job.entry = job.previous;
+        job.status = ImportStatus::UP_TO_DATE;
+        return;
+    }
+
+    if (!hashFileContents(job.sourcePath, job.entry.hash)) return;
+    if (!force && previousOutputExists && job.previous.hash == job.entry.hash) {
+        job.entry.output = job.previous.output;
+        job.status = ImportStatus::RESTAMPED;
+        return;
+    }
+
+    sf::InputSoundFile input;
+    if (!input.openFromFile(job.sourcePath)) return;
+    if (hasExtension(job.sourcePath, ".ogg") && input.getSampleRate() == MIXER_SAMPLE_RATE && input.getChannelCount() == 2) {
+        // もう揃っているので変換しない (Vorbis をもう一度かけて音を悪くしない)
+        job.entry.output = job.sourcePath;
+        job.status = ImportStatus::KEPT;
+        return;
+    }
+
+    job.entry.output = manifest.getOutputPath(job.entry.hash);
+    {
+        // 中身の同じ曲が2つあっても1回だけ変換する
+        std::lock_guard<std::mutex> lock(claims.mutex);
+        if (!claims.hashes.insert(job.entry.hash).second || (!force && getFileStamp(job.entry.output, outputStamp))) {
+            job.status = ImportStatus::SHARED;
+            return;
+        }
+    }
+    if (!transcode(job.sourcePath, job.entry.output)) return;
+    job.status = ImportStatus::CONVERTED;
+    job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+const char* getStatusName(ImportStatus status) {
+    switch (status) {
+    case ImportStatus::UP_TO_DATE: return "up to date";
+    case ImportStatus::RESTAMPED: return "unchanged";
+    case ImportStatus::KEPT: return "kept (already canonical)";
+    case ImportStatus::CONVERTED: return "converted";
+    case ImportStatus::SHARED: return "shared";
+    case ImportStatus::FAILED: return "failed";
+    }
+    return "";
+}
+}
+
+int main(int argc, char* argv[]) {
+    bool force = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--force") {
+            force = true;
+        } else {
+            std::printf("usage: audioimport [--force]\n");
+            return 1;
+        }
+    }
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::ifstream ifs("songs.json");
+    if (!ifs) {
+        std::fprintf(stderr, "songs.json not found\n");
+        return 1;
+    }
+    json songsJson = json::parse(ifs, nullptr, false);
+    if (!songsJson.is_array()) {
+        std::fprintf(stderr, "failed to parse songs.json\n");
+        return 1;
+    }
+
+    AudioImportManifest manifest;
+    manifest.load();
+    if (!ensureDirectory(manifest.getDirectory())) {
+        std::fprintf(stderr, "failed to create %s\n", manifest.getDirectory().c_str());
+        return 1;
+    }
+
+    std::vector<ImportJob> jobs;
+    std::set<std::string> seen;
+    for (const auto& songJson : songsJson) {
+        if (!songJson.is_object()) continue;
+        std::string audioPath = songJson.value("audio_path", "");
+        if (audioPath.empty() || !seen.insert(audioPath).second) continue;
+        ImportJob job;
+        job.sourcePath = audioPath;
+        if (const AudioImportManifest::Entry* previous = manifest.find(audioPath)) {
+            job.previous = *previous;
+            job.hasPrevious = true;
+        }
+        jobs.push_back(job);
+    }
+
+    // 曲ごとのジョブをワーカープールで並列に処理する
+    OutputClaims claims;
+    {
+        WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        for (auto& job : jobs) {
+            ImportJob* target = &job;
+            pool.submit([&, target]() { processJob(*target, manifest, force, claims); });
+        }
+        pool.waitIdle();
+    }
+
+    size_t failed = 0;
+    for (const auto& job : jobs) {
+        if (job.status == ImportStatus::CONVERTED) {
+            std::printf("%-32s %s -> %s (%.1fs)\n", job.sourcePath.c_str(), getStatusName(job.status), job.entry.output.c_str(), job.seconds);
+        } else {
+            std::printf("%-32s %s\n", job.sourcePath.c_str(), getStatusName(job.status));
+        }
+        if (job.status == ImportStatus::FAILED) {
+            ++failed;
+            continue;
+        }
+        manifest.set(job.sourcePath, job.entry);
+    }
+    if (!manifest.save()) {
+        std::fprintf(stderr, "failed to write %s/manifest.json\n", manifest.getDirectory().c_str());
+        return 1;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    std::printf("%zu files in %lldms\n", jobs.size(), static_cast<long long>(elapsed.count()));
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+// --- 譜面の自動生成ツール ---
+// 音声ファイルから音の立ち上がり (オンセット) を検出し、推定したテンポの格子に合わせて
+// ゲームがそのまま読める MIDI 譜面を書き出す。
+//
+//   chartgen <音声ファイル> <出力.mid> [easy|normal|hard]
+//   chartgen --song <曲名> [easy|normal|hard]
+//
+// --song では songs.json の audio_path を読み、midi/auto/ に書き出して songs.json に足す行を表示する。
+// スペクトルの計算はフレームを区切ってスレッドごとに並列に行う。
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MidiFile.h"
+#include "constants.hpp"
+#include "file_utils.hpp"
+#include "onset_envelope.hpp"
+
+namespace {
+const size_t FRAME_SIZE = 2048;
+const size_t HOP_SIZE = 512;           // 44.1kHz で約11.6ms
+const double MIN_BPM = 70.0;
+const double MAX_BPM = 190.0;
+const double PREFERRED_BPM = 120.0;    // テンポの候補が倍・半分で迷ったときに寄せる先
+const int TICKS_PER_QUARTER = 480;
+const int BASE_KEY = 60;               // 60 はレーン数で割り切れるので、キー番号 60 + レーン
+const int NOTE_LENGTH_TICKS = TICKS_PER_QUARTER / 4;
+const int SECTION_BARS = 8;            // 練習区間のマーカーを打つ間隔
+
+struct Difficulty {
+    const char* name;
+    const char* label;     // songs.json の difficulty
+    int gridDivision;      // 1拍を何分割した格子に合わせるか
+    double threshold;      // オンセットとみなす強さ (流束の標準偏差の何倍か)
+    double minimumGap;     // ノーツ同士の最小間隔 (秒)
+};
+
+const Difficulty DIFFICULTIES[] = {
+    {"easy", "EASY", 1, 1.6, 0.30},
+    {"normal", "NORMAL", 2, 1.0, 0.15},
+    {"hard", "HARD", 4, 0.6, 0.08},
+};
+
+struct Onset {
+    double time;    // 秒
+    float strength;
+    float centroid; // スペクトルの重心 (Hz)。レーンの割り当てに使う
+};
+
+// 周りより突き出た流束のピークをオンセットとする
+std::vector<Onset> detectOnsets(const OnsetEnvelope& envelope, const std::vector<float>& flux, const Difficulty& difficulty) {
+    const int peakRadius = 3;
+    const int averageRadius = 16;
+    std::vector<Onset> onsets;
+    double lastTime = -1e9;
+
+    for (int i = 0; i < static_cast<int>(flux.size()); ++i) {
+        bool isPeak = true;
+        double localSum = 0.0;
+        int localCount = 0;
+        for (int j = std::max(0, i - averageRadius); j <= std::min(static_cast<int>(flux.size()) - 1, i + averageRadius); ++j) {
+            if (std::abs(j - i) <= peakRadius && flux[j] > flux[i]) isPeak = false;
+            localSum += flux[j];
+            ++localCount;
+        }
+        if (!isPeak) continue;
+
+        float strength = flux[i] - static_cast<float>(localSum / localCount);
+        double time = envelope.getTime(i);
+        if (strength < difficulty.threshold || time - lastTime < difficulty.minimumGap) continue;
+        onsets.push_back({time, strength, envelope.centroid[i]});
+        lastTime = time;
+    }
+    return onsets;
+}
+
+// 流束の自己相関からテンポを、その格子に流束が一番乗る位置から拍の位相を求める
+void estimateTempo(const OnsetEnvelope& envelope, const std::vector<float>& flux, double& bpm, double& phase) {
+    const int minLag = static_cast<int>(60.0 / MAX_BPM * envelope.frameRate);
+    const int maxLag = static_cast<int>(60.0 / MIN_BPM * envelope.frameRate) + 1;
+    std::vector<double> scores(maxLag + 2, 0.0);
+
+    int bestLag = minLag;
+    double bestScore = -1e30;
+    for (int lag = minLag - 1; lag <= maxLag + 1; ++lag) {
+        double sum = 0.0;
+        for (size_t i = static_cast<size_t>(lag); i < flux.size(); ++i) {
+            sum += flux[i] * flux[i - lag];
+        }
+        double lagBpm = 60.0 * envelope.frameRate / lag;
+        double octaves = std::log2(lagBpm / PREFERRED_BPM);
+        scores[lag] = sum / flux.size() * std::exp(-0.5 * octaves * octaves);
+        if (lag >= minLag && lag <= maxLag && scores[lag] > bestScore) {
+            bestScore = scores[lag];
+            bestLag = lag;
+        }
+    }
+
+    // 放物線で補間して1フレームより細かい周期を出す
+    double a = scores[bestLag - 1], b = scores[bestLag], c = scores[bestLag + 1];
+    double denominator = a - 2.0 * b + c;
+    double period = bestLag + (denominator != 0.0 ? 0.5 * (a - c) / denominator : 0.0);
+    bpm = 60.0 * envelope.frameRate / period;
+
+    double bestPhaseScore = -1e30;
+    phase = 0.0;
+    for (int offset = 0; offset < static_cast<int>(period); ++offset) {
+        double sum = 0.0;
+        for (double position = offset; position < flux.size(); position += period) {
+            sum += flux[static_cast<size_t>(position + 0.5) < flux.size() ? static_cast<size_t>(position + 0.5) : flux.size() - 1];
+        }
+        if (sum > bestPhaseScore) {
+            bestPhaseScore = sum;
+            phase = envelope.getTime(offset);
+        }
+    }
+}
+
+// オンセットを格子に合わせる。同じ格子点に重なったら強い方を残す
+std::vector<Onset> quantize(const std::vector<Onset>& onsets, double bpm, double phase, const Difficulty& difficulty) {
+    const double step = 60.0 / bpm / difficulty.gridDivision;
+    std::vector<Onset> notes;
+    long long lastSlot = -1;
+    for (const auto& onset : onsets) {
+        long long slot = static_cast<long long>(std::floor((onset.time - phase) / step + 0.5));
+        if (slot < 0) continue;
+        Onset note = onset;
+        note.time = phase + slot * step;
+        if (slot == lastSlot) {
+            if (note.strength > notes.back().strength) notes.back() = note;
+            continue;
+        }
+        if (!notes.empty() && note.time - notes.back().time < difficulty.minimumGap - 1e-6) {
+            if (note.strength > notes.back().strength) notes.back() = note;
+            continue;
+        }
+        notes.push_back(note);
+        lastSlot = slot;
+    }
+    return notes;
+}
+
+// 低い音ほど左、高い音ほど右のレーンにする。短い間隔で同じレーンが続くときは隣にずらす
+std::vector<int> assignLanes(const std::vector<Onset>& notes, double bpm) {
+    const double lowFrequency = 150.0, highFrequency = 6000.0;
+    const double repeatWindow = 60.0 / bpm / 2.0;
+    std::vector<int> lanes(notes.size());
+    for (size_t i = 0; i < notes.size(); ++i) {
+        double position = std::log(std::max(lowFrequency, std::min(highFrequency, static_cast<double>(notes[i].centroid))) / lowFrequency) / std::log(highFrequency / lowFrequency);
+        int lane = std::min(LANE_COUNT - 1, static_cast<int>(position * LANE_COUNT));
+        if (i > 0 && lane == lanes[i - 1] && notes[i].time - notes[i - 1].time < repeatWindow) {
+            lane = lane + (lane < LANE_COUNT / 2 ? 1 : -1);
+        }
+        lanes[i] = lane;
+    }
+    return lanes;
+}
+
+bool writeChart(const std::string& path, const std::vector<Onset>& notes, const std::vector<int>& lanes, double bpm, double phase, double duration) {
+    smf::MidiFile midi;
+    midi.setTicksPerQuarterNote(TICKS_PER_QUARTER);
+    midi.addTempo(0, 0, bpm);
+    auto toTick = [&](double time) { return static_cast<int>(std::floor(time * bpm / 60.0 * TICKS_PER_QUARTER + 0.5)); };
+
+    // 拍の位相から数えた小節ごとに練習区間のマーカーを打つ (4/4 とみなす)
+    const double sectionLength = 60.0 / bpm * 4 * SECTION_BARS;
+    for (int bar = 1; phase + (bar - 1) / SECTION_BARS * sectionLength < duration; bar += SECTION_BARS) {
+        midi.addMarker(0, toTick(phase + (bar - 1) / SECTION_BARS * sectionLength), "Bar " + std::to_string(bar));
+    }
+    for (size_t i = 0; i < notes.size(); ++i) {
+        int tick = toTick(notes[i].time);
+        int velocity = std::max(40, std::min(127, static_cast<int>(64 + notes[i].strength * 16)));
+        midi.addNoteOn(0, tick, 0, BASE_KEY + lanes[i], velocity);
+        midi.addNoteOff(0, tick + NOTE_LENGTH_TICKS, 0, BASE_KEY + lanes[i]);
+    }
+    midi.sortTracks();
+    return midi.write(path);
+}
+
+const Difficulty* findDifficulty(const std::string& name) {
+    for (const auto& difficulty : DIFFICULTIES) {
+        if (name == difficulty.name) return &difficulty;
+    }
+    return nullptr;
+}
+
+bool findSongAudio(const std::string& title, std::string& audioPath) {
+    std::ifstream ifs("songs.json");
+    if (!ifs) return false;
+    json songsJson = json::parse(ifs, nullptr, false);
+    if (!songsJson.is_array()) return false;
+    for (const auto& song : songsJson) {
+        if (song.value("title", "") == title) {
+            audioPath = song.value("audio_path", "");
+            return !audioPath.empty();
+        }
+    }
+    return false;
+}
+
+void printUsage() {
+    std::printf("usage: chartgen <audio> <output.mid> [easy|normal|hard]\n");
+    std::printf("       chartgen --song <title> [easy|normal|hard]\n");
+}
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return 1;
+    }
+
+    std::string audioPath, outputPath;
+    const Difficulty* difficulty = &DIFFICULTIES[1];
+    if (argc >= 4 && !(difficulty = findDifficulty(argv[3]))) {
+        printUsage();
+        return 1;
+    }
+
+    if (std::string(argv[1]) == "--song") {
+        if (!findSongAudio(argv[2], audioPath)) {
+            std::fprintf(stderr, "song not found in songs.json: %s\n", argv[2]);
+            return 1;
+        }
+        std::string name;
+        for (char ch : std::string(argv[2])) name += std::isalnum(static_cast<unsigned char>(ch)) ? ch : '_';
+        ensureDirectory("midi/auto");
+        outputPath = "midi/auto/" + name + "_" + difficulty->label + ".mid"; // 曲名と難易度の境目が分かるように
+    } else {
+        audioPath = argv[1];
+        outputPath = argv[2];
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<float> mono;
+    unsigned int sampleRate = 0;
+    if (!decodeMono(audioPath, mono, sampleRate)) {
+        std::fprintf(stderr, "failed to decode %s\n", audioPath.c_str());
+        return 1;
+    }
+    auto decodedTime = std::chrono::steady_clock::now();
+
+    OnsetEnvelope envelope = analyzeOnsets(mono, sampleRate, FRAME_SIZE, HOP_SIZE);
+    std::vector<float> flux = normalizeEnvelope(envelope.flux);
+    double bpm = PREFERRED_BPM, phase = 0.0;
+    if (!flux.empty()) estimateTempo(envelope, flux, bpm, phase);
+    std::vector<Onset> notes = quantize(detectOnsets(envelope, flux, *difficulty), bpm, phase, *difficulty);
+    std::vector<int> lanes = assignLanes(notes, bpm);
+
+    double duration = static_cast<double>(mono.size()) / sampleRate;
+    if (!writeChart(outputPath, notes, lanes, bpm, phase, duration)) {
+        std::fprintf(stderr, "failed to write %s\n", outputPath.c_str());
+        return 1;
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    auto milliseconds = [](std::chrono::steady_clock::duration d) {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(d).count());
+    };
+    std::printf("%s: %.1fs, %.1f BPM, %zu notes (%s)\n", outputPath.c_str(), duration, bpm, notes.size(), difficulty->name);
+    std::printf("decode %lldms, analysis %lldms\n", milliseconds(decodedTime - startTime), milliseconds(endTime - decodedTime));
+    if (std::string(argv[1]) == "--song") {
+        std::printf("songs.json: {\"difficulty\": \"%s\", \"chart_path\": \"%s\"}\n", difficulty->label, outputPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+// --- 譜面と音声のずれの推定ツール ---
+// 曲の音声から作ったオンセットの包絡と、譜面のノーツの時刻を並べたインパルス列を FFT で相互相関し、
+// 一番よく重なるずらし幅を譜面ごとのオフセットとして求める。
+//
+//   chartoffset <音声ファイル> <譜面.mid>
+//   chartoffset --song <曲名> [--write]
+//   chartoffset --all [--write]
+//
+// --write を付けると songs.json の各譜面に "offset" (ms) を書き込み、ゲームは読み込み時にそれを足す。
+// --all では曲ごとのジョブを全コアで並列に処理する。
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fft.hpp"
+#include "file_utils.hpp"
+#include "onset_envelope.hpp"
+#include "worker_pool.hpp"
+
+namespace {
+const size_t FRAME_SIZE = 1024;
+const size_t HOP_SIZE = 256;          // 44.1kHz で約5.8ms。ピークは補間してさらに細かく求める
+const double MAX_OFFSET = 3.0;        // 探すずれの範囲 (秒、前後とも)
+const double MIN_CONFIDENCE = 1.5;    // ピークがこれより埋もれていたら書き込まない
+
+struct ChartResult {
+    size_t chartIndex = 0; // songs.json の charts の中の位置
+    std::string difficulty;
+    std::string chartPath;
+    bool valid = false;
+    double offset = 0.0;     // 秒。譜面の時刻に足すと音声に合う
+    double confidence = 0.0; // 相関のピークが範囲内の平均の何倍か
+};
+
+struct SongJob {
+    size_t songIndex = 0;
+    std::string title;
+    std::string audioPath;
+    std::vector<ChartResult> charts;
+    bool decoded = false;
+};
+
+// 包絡の負の部分 (音が減っていく所) は相関に使わない
+std::vector<float> rectify(const std::vector<float>& flux) {
+    std::vector<float> result = normalizeEnvelope(flux);
+    for (float& value : result) value = std::max(0.f, value);
+    return result;
+}
+
+void estimateOffset(const OnsetEnvelope& envelope, const std::vector<float>& rectified, const std::vector<Note>& notes, ChartResult& result) {
+    if (notes.empty() || rectified.empty()) return;
+
+    // ノーツの時刻をフレームに直し、隣り合う2フレームに線形に振り分ける
+    const double lastTime = std::max(0.0, notes.back().spawnTime);
+    const size_t impulseLength = static_cast<size_t>(lastTime * envelope.frameRate) + 2;
+    size_t size = 1;
+    while (size < rectified.size() + impulseLength) size *= 2;
+
+    std::vector<float> audio(size, 0.f), impulses(size, 0.f);
+    std::copy(rectified.begin(), rectified.end(), audio.begin());
+    for (const auto& note : notes) {
+        if (note.spawnTime < 0.0) continue;
+        double position = note.spawnTime * envelope.frameRate;
+        size_t index = static_cast<size_t>(position);
+        float fraction = static_cast<float>(position - index);
+        impulses[index] += 1.f - fraction;
+        impulses[index + 1] += fraction;
+    }
+
+    // 相関 r[lag] = Σ audio[n + lag] * impulses[n] を周波数領域の積で求める
+    const Fft fft(size);
+    std::vector<float> audioReal(size), audioImag(size), impulseReal(size), impulseImag(size);
+    fft.transform(audio.data(), audioReal.data(), audioImag.data());
+    fft.transform(impulses.data(), impulseReal.data(), impulseImag.data());
+    for (size_t k = 0; k < size; ++k) {
+        float re = audioReal[k] * impulseReal[k] + audioImag[k] * impulseImag[k];
+        float im = audioImag[k] * impulseReal[k] - audioReal[k] * impulseImag[k];
+        audioReal[k] = re;
+        audioImag[k] = im;
+    }
+    fft.inverse(audioReal.data(), audioImag.data());
+    auto correlation = [&](long long lag) { return audioReal[static_cast<size_t>((lag + static_cast<long long>(size)) % static_cast<long long>(size))]; };
+
+    // 同じパターンを繰り返す曲では何小節か離れた所にもほぼ同じ高さのピークが出るので、
+    // ずれの小さい方を少しだけ優先して選ぶ (位置の補間には重みをかけない相関を使う)
+    const long long maxLag = static_cast<long long>(MAX_OFFSET * envelope.frameRate);
+    auto weighted = [&](long long lag) {
+        double distance = static_cast<double>(lag) / maxLag;
+        return correlation(lag) * (1.0 - 0.25 * distance * distance);
+    };
+    long long bestLag = 0;
+    double sum = 0.0;
+    for (long long lag = -maxLag; lag <= maxLag; ++lag) {
+        sum += std::max(0.f, correlation(lag));
+        if (weighted(lag) > weighted(bestLag)) bestLag = lag;
+    }
+    double mean = sum / (maxLag * 2 + 1);
+
+    // 放物線で補間して1フレームより細かく求める
+    double a = correlation(bestLag - 1), b = correlation(bestLag), c = correlation(bestLag + 1);
+    double denominator = a - 2.0 * b + c;
+    double lag = bestLag + (denominator < 0.0 ? 0.5 * (a - c) / denominator : 0.0);
+
+    result.valid = true;
+    result.offset = lag / envelope.frameRate + envelope.timeOffset;
+    result.confidence = mean > 0.0 ? b / mean : 0.0;
+}
+
+void processSong(SongJob& job, unsigned int analysisThreads) {
+    std::vector<float> mono;
+    unsigned int sampleRate = 0;
+    if (!decodeMono(job.audioPath, mono, sampleRate)) return;
+    job.decoded = true;
+
+    OnsetEnvelope envelope = analyzeOnsets(mono, sampleRate, FRAME_SIZE, HOP_SIZE, analysisThreads);
+    std::vector<float> rectified = rectify(envelope.flux);
+    for (auto& chart : job.charts) {
+        // 今のオフセットは足さずに、MIDI の時刻そのものから求め直す
+        estimateOffset(envelope, rectified, loadChartFromMidi(chart.chartPath), chart);
+    }
+}
+
+// 曲ごとのジョブをワーカープールで並列に処理する。曲が少なければ余ったスレッドを曲の中の解析に回す
+void processSongs(std::vector<SongJob>& jobs) {
+    if (jobs.empty()) return;
+    unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int poolThreads = std::min(hardwareThreads, static_cast<unsigned int>(jobs.size()));
+    unsigned int analysisThreads = std::max(1u, hardwareThreads / poolThreads);
+
+    WorkerPool pool(poolThreads);
+    for (auto& job : jobs) {
+        SongJob* target = &job;
+        pool.submit([target, analysisThreads]() { processSong(*target, analysisThreads); });
+    }
+    pool.waitIdle();
+}
+
+void printResult(const std::string& title, const ChartResult& chart) {
+    if (!chart.valid) {
+        std::printf("%-24s %-8s failed (%s)\n", title.c_str(), chart.difficulty.c_str(), chart.chartPath.c_str());
+        return;
+    }
+    std::printf("%-24s %-8s %+7.1f ms  x%.1f%s\n", title.c_str(), chart.difficulty.c_str(), chart.offset * 1000.0, chart.confidence,
+                chart.confidence < MIN_CONFIDENCE ? "  (unreliable)" : "");
+}
+
+void printUsage() {
+    std::printf("usage: chartoffset <audio> <chart.mid>\n");
+    std::printf("       chartoffset --song <title> [--write]\n");
+    std::printf("       chartoffset --all [--write]\n");
+}
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    std::string mode = argv[1];
+
+    if (mode != "--song" && mode != "--all") {
+        if (argc < 3) {
+            printUsage();
+            return 1;
+        }
+        SongJob job;
+        job.audioPath = argv[1];
+        job.charts.resize(1);
+        job.charts[0].chartPath = argv[2];
+        processSong(job, 0);
+        if (!job.decoded) {
+            std::fprintf(stderr, "failed to decode %s\n", job.audioPath.c_str());
+            return 1;
+        }
+        printResult(job.audioPath, job.charts[0]);
+        return job.charts[0].valid ? 0 : 1;
+    }
+
+    // songs.json はキーの順番を保ったまま書き戻す
+    std::ifstream ifs("songs.json");
+    if (!ifs) {
+        std::fprintf(stderr, "songs.json not found\n");
+        return 1;
+    }
+    nlohmann::ordered_json songsJson = nlohmann::ordered_json::parse(ifs, nullptr, false);
+    ifs.close();
+    if (!songsJson.is_array()) {
+        std::fprintf(stderr, "failed to parse songs.json\n");
+        return 1;
+    }
+
+    bool write = false;
+    std::string title;
+    for (int i = 2; i < argc; ++i) {
+        if (std::string(argv[i]) == "--write") write = true;
+        else if (mode == "--song" && title.empty()) title = argv[i];
+    }
+    if (mode == "--song" && title.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<SongJob> jobs;
+    for (size_t i = 0; i < songsJson.size(); ++i) {
+        const auto& songJson = songsJson[i];
+        if (!songJson.is_object()) continue;
+        if (mode == "--song" && songJson.value("title", "") != title) continue;
+        // 譜面のない曲は飛ばす
+        auto charts = songJson.find("charts");
+        if (charts == songJson.end() || !charts->is_array()) continue;
+        SongJob job;
+        job.songIndex = i;
+        job.title = songJson.value("title", "");
+        job.audioPath = songJson.value("audio_path", "");
+        for (size_t c = 0; c < charts->size(); ++c) {
+            const auto& chartJson = (*charts)[c];
+            if (!chartJson.is_object()) continue;
+            ChartResult chart;
+            chart.chartIndex = c;
+            chart.difficulty = chartJson.value("difficulty", "");
+            chart.chartPath = chartJson.value("chart_path", "");
+            job.charts.push_back(chart);
+        }
+        jobs.push_back(job);
+    }
+    if (jobs.empty()) {
+        std::fprintf(stderr, "song not found in songs.json: %s\n", title.c_str());
+        return 1;
+    }
+
+    processSongs(jobs);
+
+    size_t written = 0;
+    for (const auto& job : jobs) {
+        if (!job.decoded) {
+            std::printf("%-24s failed to decode %s\n", job.title.c_str(), job.audioPath.c_str());
+            continue;
+        }
+        for (const auto& chart : job.charts) {
+            printResult(job.title, chart);
+            if (write && chart.valid && chart.confidence >= MIN_CONFIDENCE) {
+                songsJson[job.songIndex]["charts"][chart.chartIndex]["offset"] = static_cast<int>(std::lround(chart.offset * 1000.0));
+                ++written;
+            }
+        }
+    }
+
+    if (write && written > 0) {
+        bool saved = writeFileAtomically("songs.json", [&](std::ostream& os) {
+            os << std::setw(2) << songsJson << std::endl;
+            return static_cast<bool>(os);
+        });
+        if (!saved) {
+            std::fprintf(stderr, "failed to write songs.json\n");
+            return 1;
+        }
+        std::printf("wrote %zu offsets to songs.json\n", written);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    std::printf("%zu songs in %lldms\n", jobs.size(), static_cast<long long>(elapsed.count()));
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "onset_envelope.hpp"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "fft.hpp"
+
+bool decodeMono(const std::string& path, std::vector<float>& mono, unsigned int& sampleRate) {
+    sf::InputSoundFile file;
+    if (!file.openFromFile(path)) return false;
+    unsigned int channelCount = file.getChannelCount();
+    sampleRate = file.getSampleRate();
+    mono.clear();
+    mono.reserve(static_cast<size_t>(file.getSampleCount() / channelCount));
+
+    std::vector<sf::Int16> buffer(65536 * channelCount);
+    sf::Uint64 read;
+    while ((read = file.read(buffer.data(), buffer.size())) > 0) {
+        for (sf::Uint64 i = 0; i + channelCount <= read; i += channelCount) {
+            int sum = 0;
+            for (unsigned int c = 0; c < channelCount; ++c) sum += buffer[i + c];
+            mono.push_back(static_cast<float>(sum) / (32768.f * channelCount));
+        }
+    }
+    return !mono.empty();
+}
+
+// 各スレッドは担当範囲の1つ前のフレームから計算し始めるので、境目で待ち合わせる必要はない
+OnsetEnvelope analyzeOnsets(const std::vector<float>& mono, unsigned int sampleRate, size_t frameSize, size_t hopSize, unsigned int threadCount) {
+    OnsetEnvelope envelope;
+    envelope.frameRate = static_cast<double>(sampleRate) / hopSize;
+    // 流束は対数で見ているので、音の頭が窓の後端に入ってから1ホップほどで最大になる
+    envelope.timeOffset = static_cast<double>(frameSize - hopSize) / sampleRate;
+    if (mono.size() < frameSize) return envelope;
+
+    const size_t frameCount = (mono.size() - frameSize) / hopSize + 1;
+    envelope.flux.assign(frameCount, 0.f);
+    envelope.centroid.assign(frameCount, 0.f);
+
+    const Fft fft(frameSize);
+    const std::vector<float> window = fft.makeHannWindow();
+    const size_t binCount = frameSize / 2 + 1;
+    const float binWidth = static_cast<float>(sampleRate) / frameSize;
+
+    auto worker = [&](size_t begin, size_t end) {
+        std::vector<float> frame(frameSize), real(frameSize), imag(frameSize);
+        std::vector<float> magnitude(binCount), previous(binCount, 0.f), linear(binCount);
+        auto computeMagnitude = [&](size_t index) {
+            const float* samples = &mono[index * hopSize];
+            for (size_t i = 0; i < frameSize; ++i) frame[i] = samples[i] * window[i];
+            fft.transform(frame.data(), real.data(), imag.data());
+            for (size_t k = 0; k < binCount; ++k) {
+                linear[k] = std::sqrt(real[k] * real[k] + imag[k] * imag[k]);
+                // 流束は対数で圧縮して、大きな音だけに引きずられないようにする
+                magnitude[k] = std::log1p(100.f * linear[k]);
+            }
+        };
+
+        if (begin > 0) {
+            computeMagnitude(begin - 1);
+            previous.swap(magnitude);
+        }
+        for (size_t index = begin; index < end; ++index) {
+            computeMagnitude(index);
+            float flux = 0.f, weighted = 0.f, total = 0.f;
+            for (size_t k = 1; k < binCount; ++k) {
+                flux += std::max(0.f, magnitude[k] - previous[k]);
+                weighted += linear[k] * k * binWidth;
+                total += linear[k];
+            }
+            envelope.flux[index] = index > 0 ? flux : 0.f;
+            envelope.centroid[index] = total > 0.f ? weighted / total : 0.f;
+            previous.swap(magnitude);
+        }
+    };
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    size_t perThread = (frameCount + threadCount - 1) / threadCount;
+    for (size_t begin = perThread; begin < frameCount; begin += perThread) {
+        threads.emplace_back(worker, begin, std::min(frameCount, begin + perThread));
+    }
+    worker(0, std::min(frameCount, perThread));
+    for (auto& thread : threads) thread.join();
+    return envelope;
+}
+
+std::vector<float> normalizeEnvelope(const std::vector<float>& values) {
+    double mean = 0.0, variance = 0.0;
+    for (float v : values) mean += v;
+    mean /= std::max<size_t>(1, values.size());
+    for (float v : values) variance += (v - mean) * (v - mean);
+    double deviation = std::sqrt(variance / std::max<size_t>(1, values.size()));
+    std::vector<float> result(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        result[i] = deviation > 0.0 ? static_cast<float>((values[i] - mean) / deviation) : 0.f;
+    }
+    return result;
+}
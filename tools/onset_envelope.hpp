@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// --- オンセットの包絡 (ツール用) ---
+// 音声のスペクトル流束をフレームごとに求める。譜面の自動生成とオフセットの推定で共有する。
+
+// 音声ファイルを -1..1 のモノラルにデコードする
+bool decodeMono(const std::string& path, std::vector<float>& mono, unsigned int& sampleRate);
+
+struct OnsetEnvelope {
+    std::vector<float> flux;     // スペクトル流束 (フレームごと)
+    std::vector<float> centroid; // スペクトルの重心 (Hz)
+    double frameRate = 0.0;      // 1秒あたりのフレーム数
+    double timeOffset = 0.0;     // フレーム 0 の時刻 (秒)。流束が立ち上がる位置に合わせてある
+
+    double getTime(size_t frame) const { return frame / frameRate + timeOffset; }
+};
+
+// frameSize は2のべき乗。フレームの範囲を threadCount 個のスレッドで分け合う (0 ならハードウェアのスレッド数)
+OnsetEnvelope analyzeOnsets(const std::vector<float>& mono, unsigned int sampleRate, size_t frameSize, size_t hopSize, unsigned int threadCount = 0);
+
+// 平均0・標準偏差1にそろえる
+std::vector<float> normalizeEnvelope(const std::vector<float>& values);